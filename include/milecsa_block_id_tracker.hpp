@@ -0,0 +1,96 @@
+//
+// Created by lotus mile on 2026-10-17.
+//
+
+#pragma once
+
+#include <optional>
+#include <string>
+#include <memory>
+#include <chrono>
+
+#include "milecsa.hpp"
+#include "milecsa_error.hpp"
+#include "milecsa_rpc_session.hpp"
+
+namespace milecsa::rpc {
+
+    namespace detail { class TrackerState; }
+
+    /**
+     * Current block id tracker shared by transaction builders.
+     *
+     * Tracker polls the node from its own thread and connection, the latest block id is published
+     * through a seqlock over atomic words, so any number of threads read it without locks
+     * and without a round trip to the node. Copies share the same tracker.
+     */
+    class BlockIdTracker {
+
+    public:
+
+        /**
+         * Tracked block id is not served if it has been refreshed earlier than the bound
+         */
+        static std::chrono::milliseconds max_staleness;
+
+        /**
+         * Start tracker
+         * @param urlString - MILE node runs on json-rpcd mode
+         * @param interval - polling interval
+         * @param verify_ssl - if url contains https protocol it will enable SSL verification
+         * @param response_fail_handler - response fail handler, called from tracker thread
+         * @param error_handler - connection error handler, called from tracker thread
+         * @return optional BlockIdTracker object, nullopt if the first block id can't be got
+         */
+        static std::optional<BlockIdTracker> Start(
+                const std::string &urlString,
+                std::chrono::milliseconds interval = std::chrono::seconds(1),
+                bool verify_ssl = true,
+                const http::ResponseHandler &response_fail_handler = http::default_response_handler,
+                const ErrorHandler &error_handler = default_error_handler);
+
+        BlockIdTracker(const BlockIdTracker &tracker);
+
+        ~BlockIdTracker();
+
+        /**
+         * Get the latest block id, lock-free
+         * @return block id or nullopt if it is staler than max_staleness
+         */
+        std::optional<uint256_t> get() const;
+
+        /**
+         * Get the latest block id, lock-free
+         * @param staleness - staleness bound
+         * @return block id or nullopt if it is staler than the bound
+         */
+        std::optional<uint256_t> get(std::chrono::milliseconds staleness) const;
+
+        /**
+         * Get time elapsed since the last successful refresh
+         * @return age
+         */
+        std::chrono::milliseconds get_age() const;
+
+        /**
+         * Wake tracker up to refresh block id now, e.g. when the node has rejected a transaction
+         */
+        void refresh() const;
+
+        /**
+         * Wait until tracker detects a block newer than the given one
+         * @param id - known block id
+         * @param timeout - wait timeout
+         * @return the new block id or nullopt if timeout expired
+         */
+        std::optional<uint256_t> wait_next(const uint256_t &id, std::chrono::milliseconds timeout) const;
+
+        BlockIdTracker& operator=(const BlockIdTracker&);
+
+    private:
+
+        BlockIdTracker(const std::shared_ptr<detail::TrackerState> &state);
+
+        std::shared_ptr<detail::TrackerState> state;
+    };
+}
@@ -0,0 +1,90 @@
+//
+// Created by lotus mile on 2026-10-17.
+//
+
+#pragma once
+
+#include <optional>
+#include <vector>
+#include <memory>
+
+#include "milecsa.hpp"
+#include "milecsa_error.hpp"
+#include "milecsa_concurrent_client.hpp"
+
+namespace milecsa::rpc {
+
+    namespace detail { class IteratorState; }
+
+    /**
+     * Ordered iterator over block range with read-ahead.
+     *
+     * Blocks ahead of the consumer are requested over all connections of the given clients,
+     * one client per node, and reordered in the ring buffer, so blocks are yielded strictly
+     * in order. Read-ahead window grows while the consumer waits for blocks and shrinks when
+     * the request latency rises over the minimum of the recent ones, blocks found in the cache
+     * or the store are not latency samples. Failed requests are retried on the next client.
+     * Iterator is consumed by one thread, copies share the same position.
+     */
+    class BlockIterator {
+
+    public:
+
+        /**
+         * Read-ahead window bounds, max_window is the ring buffer capacity
+         */
+        static size_t min_window;
+        static size_t max_window;
+
+        /**
+         * Block request attempts before the iteration is failed
+         */
+        static size_t max_attempts;
+
+        /**
+         * Start iteration
+         * @param clients - clients of one or more nodes
+         * @param first - the first block id
+         * @param last - the last block id, inclusive
+         * @param window - initial read-ahead window
+         * @param error_handler - iteration error handler, called from io threads
+         * @return optional BlockIterator object, nullopt if clients are empty or range is empty
+         */
+        static std::optional<BlockIterator> Start(
+                const std::vector<ConcurrentClient> &clients,
+                const uint256_t &first,
+                const uint256_t &last,
+                size_t window = 16,
+                const ErrorHandler &error_handler = default_error_handler);
+
+        BlockIterator(const BlockIterator &iterator);
+
+        ~BlockIterator();
+
+        /**
+         * Get the next block, waits until it is received
+         * @return block or nullopt if the range is over or block can't be got
+         */
+        response next();
+
+        /**
+         * Get id of the block is returned by the next call
+         * @return block id
+         */
+        uint256_t get_position() const;
+
+        /**
+         * Get the current read-ahead window
+         * @return window
+         */
+        size_t get_window() const;
+
+        BlockIterator& operator=(const BlockIterator&);
+
+    private:
+
+        BlockIterator(const std::shared_ptr<detail::IteratorState> &state);
+
+        std::shared_ptr<detail::IteratorState> state;
+    };
+}
@@ -0,0 +1,95 @@
+//
+// Created by lotus mile on 2026-10-17.
+//
+
+#pragma once
+
+#include <optional>
+#include <string>
+#include <memory>
+
+#include "milecsa.hpp"
+#include "milecsa_error.hpp"
+#include "json.hpp"
+
+namespace milecsa::rpc {
+
+    namespace detail { class BlockStoreState; }
+
+    /**
+     * Persistent block store survives client restarts.
+     *
+     * Blocks are appended to the segment file in compact CBOR encoding, the dense index file maps
+     * block id to the segment offset. Both files are memory-mapped, so the lookup of a stored block
+     * costs one index load and one decoding of the mapped record. Index entry is set after
+     * the record is written, so readers of an open store never see a partial record.
+     * Writes are not synced to disk: after a crash the index page may have been written back
+     * before the record, entries pointing past the segment end are dropped on open and
+     * a lost record is reported by get as a decoding error.
+     * Store can be shared by many clients and threads of one process, copies share the same files.
+     */
+    class BlockStore {
+
+    public:
+
+        /**
+         * Max block id can be stored, index file is dense
+         */
+        static uint64_t max_block_id;
+
+        /**
+         * Open or create block store
+         * @param directory - store directory, it is created if it does not exist
+         * @param error_handler - store error handler
+         * @return optional BlockStore object
+         */
+        static std::optional<BlockStore> Open(
+                const std::string &directory,
+                const ErrorHandler &error_handler = default_error_handler);
+
+        BlockStore(const BlockStore &store);
+
+        ~BlockStore();
+
+        /**
+         * Get stored block
+         * @param id - block id
+         * @return block or nullopt if it is not stored
+         */
+        std::optional<nlohmann::json> get(const uint256_t &id) const;
+
+        /**
+         * Check whether block is stored
+         * @param id - block id
+         * @return true if block is stored
+         */
+        bool contains(const uint256_t &id) const;
+
+        /**
+         * Append block to store, stored block is never replaced
+         * @param id - block id
+         * @param block - block structure
+         * @return false if block can't be stored
+         */
+        bool put(const uint256_t &id, const nlohmann::json &block) const;
+
+        /**
+         * Get stored blocks count
+         * @return count
+         */
+        uint64_t size() const;
+
+        /**
+         * Flush mapped index and segment to disk
+         */
+        void flush() const;
+
+        BlockStore& operator=(const BlockStore&);
+
+    private:
+
+        BlockStore(const std::shared_ptr<detail::BlockStoreState> &state);
+
+        std::shared_ptr<detail::BlockStoreState> state;
+    };
+}
@@ -0,0 +1,156 @@
+//
+// Created by lotus mile on 2026-10-17.
+//
+
+#pragma once
+
+#include <optional>
+#include <string>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+#include "milecsa.hpp"
+#include "json.hpp"
+
+namespace milecsa::rpc {
+
+    /**
+     * Cache usage statistic
+     */
+    struct CacheStat {
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t evictions;
+        size_t entries;
+        size_t bytes;
+    };
+
+    /**
+     * Size-bounded LRU cache of blocks keyed by block id.
+     * Blocks are immutable once produced, so cached blocks never expire, they are only evicted
+     * when the byte budget is exhausted. Budget bounds the estimated memory of the cached json DOMs,
+     * allocator overhead is not counted. Cache is sharded by block id to avoid lock contention
+     * and can be shared by many clients and threads.
+     */
+    class BlockCache {
+
+    public:
+
+        /**
+         * Create block cache
+         * @param capacity - byte budget of the cached blocks, see estimate_size
+         * @param shards - independent LRU shards, every shard gets equal part of the budget
+         */
+        BlockCache(size_t capacity = 64 * 1024 * 1024, size_t shards = 16);
+
+        /**
+         * Get cached block
+         * @param id - block id
+         * @return block or nullopt if it is not cached
+         */
+        std::optional<nlohmann::json> get(const uint256_t &id);
+
+        /**
+         * Put block to cache
+         * @param id - block id
+         * @param block - block structure
+         */
+        void put(const uint256_t &id, const nlohmann::json &block);
+
+        /**
+         * Drop all cached blocks, counters are kept
+         */
+        void clear();
+
+        /**
+         * Get cache usage statistic
+         * @return stat
+         */
+        CacheStat get_stat() const;
+
+        /**
+         * Estimate memory taken by the block DOM: values, strings and containers,
+         * block is walked once and never serialized
+         * @param block - block structure
+         * @return bytes
+         */
+        static size_t estimate_size(const nlohmann::json &block);
+
+    private:
+
+        struct Shard {
+            typedef std::pair<std::string, std::pair<nlohmann::json, size_t>> Entry;
+
+            std::mutex mutex;
+            std::list<Entry> lru;
+            std::unordered_map<std::string, std::list<Entry>::iterator> index;
+            size_t bytes = 0;
+        };
+
+        Shard &shard(const std::string &key);
+
+        const size_t shard_capacity;
+        std::vector<std::unique_ptr<Shard>> shards;
+
+        std::atomic<uint64_t> hits;
+        std::atomic<uint64_t> misses;
+        std::atomic<uint64_t> evictions;
+    };
+
+    /**
+     * Short-TTL cache of rarely changed responses keyed by method name, e.g. get-blockchain-info
+     */
+    class TtlCache {
+
+    public:
+
+        /**
+         * Create TTL cache
+         * @param ttl - time to live of the cached response
+         */
+        TtlCache(std::chrono::milliseconds ttl = std::chrono::seconds(5));
+
+        /**
+         * Get cached response if it is not expired
+         * @param key - method name
+         * @return response or nullopt
+         */
+        std::optional<nlohmann::json> get(const std::string &key);
+
+        /**
+         * Put response to cache
+         * @param key - method name
+         * @param value - response
+         */
+        void put(const std::string &key, const nlohmann::json &value);
+
+        /**
+         * Drop all cached responses, counters are kept
+         */
+        void clear();
+
+        /**
+         * Get cache usage statistic
+         * @return stat, evictions are expired responses
+         */
+        CacheStat get_stat() const;
+
+    private:
+
+        typedef std::chrono::steady_clock clock;
+
+        const std::chrono::milliseconds ttl;
+
+        mutable std::mutex mutex;
+        std::unordered_map<std::string, std::pair<nlohmann::json, clock::time_point>> entries;
+
+        std::atomic<uint64_t> hits;
+        std::atomic<uint64_t> misses;
+        std::atomic<uint64_t> evictions;
+    };
+}
@@ -0,0 +1,233 @@
+//
+// Created by lotus mile on 2026-10-17.
+//
+
+#pragma once
+
+#include <optional>
+#include <functional>
+#include <vector>
+#include <string>
+#include <memory>
+
+#include "milecsa_jsonrpc.hpp"
+
+namespace milecsa::rpc {
+
+    namespace detail { class PoolState; }
+
+    /**
+     * MILE Json-Rpc multi-node client pool.
+     *
+     * Pool keeps several warm sessions per node, tracks rolling latency of every node
+     * from the real traffic and ping probes, and routes each call to the fastest healthy node.
+     * Excluded nodes are probed by a single call once their retry interval has passed, the probe bypasses
+     * the caches. Calls served from the caches are not taken as latency samples or health results.
+     * Pool object is cheap to copy, all copies share the same nodes and sessions,
+     * and can be used from several threads: every call leases its own session.
+     */
+    class ClientPool {
+
+    public:
+
+        /**
+         * Node routing statistic
+         */
+        struct NodeStat {
+            /**
+             * Node url
+             */
+            std::string url;
+
+            /**
+             * Rolling (exponentially weighted) latency in microseconds, 0 if node has not answered yet
+             */
+            time_t latency;
+
+            /**
+             * Node is used to route calls
+             */
+            bool healthy;
+
+            /**
+             * Completed calls
+             */
+            uint64_t requests;
+
+            /**
+             * Failed calls
+             */
+            uint64_t failures;
+
+            /**
+             * Connected sessions kept by node
+             */
+            size_t sessions;
+        };
+
+        /**
+         * Consecutive transport failures after that the node is excluded from routing
+         */
+        static unsigned int max_failures;
+
+        /**
+         * Interval in seconds after that an excluded node takes one probe call, it comes back if the call succeeds
+         */
+        static time_t retry_interval;
+
+        /**
+         * Create MILE json-rpc client pool
+         * @param urls - MILE nodes run on json-rpcd mode
+         * @param sessions_per_node - warm sessions are kept open to every node
+         * @param verify_ssl - if url contains https protocol it will enable SSL verification
+         * @param response_fail_handler - response fail handler
+         * @param error_handler - connection error handler
+         * @return optional ClientPool object, nullopt if no one node is available
+         */
+        static std::optional<ClientPool> Connect(
+                const std::vector<std::string> &urls,
+                size_t sessions_per_node = 2,
+                bool verify_ssl = true,
+                const http::ResponseHandler &response_fail_handler = http::default_response_handler,
+                const ErrorHandler &error_handler = default_error_handler);
+
+        ClientPool(const ClientPool &pool);
+
+        ~ClientPool();
+
+        /**
+         * Ping every node of the pool and update their latencies.
+         * Nodes excluded from routing are probed too and come back if they answer.
+         * @return the best node latency in microseconds
+         */
+        std::optional<time_t> ping() const;
+
+        /**
+         * Put block cache in front of get_block and get_blocks of all nodes,
+         * must be set before the pool is shared between threads
+         * @param cache - block cache or nullptr to disable caching
+         */
+        void set_block_cache(const std::shared_ptr<BlockCache> &cache);
+
+        /**
+         * Put persistent block store behind the block cache of all nodes,
+         * must be set before the pool is shared between threads
+         * @param store - block store or nullopt to disable it
+         */
+        void set_block_store(const std::optional<BlockStore> &store);
+
+        /**
+         * Take block id of new transactions from the background tracker on all nodes,
+         * must be set before the pool is shared between threads
+         * @param tracker - block id tracker or nullopt to disable it
+         */
+        void set_block_id_tracker(const std::optional<BlockIdTracker> &tracker);
+
+        /**
+         * Put short-TTL cache in front of get_blockchain_info of all nodes,
+         * must be set before the pool is shared between threads
+         * @param cache - response cache or nullptr to disable caching
+         */
+        void set_info_cache(const std::shared_ptr<TtlCache> &cache);
+
+        /**
+         * Get nodes routing statistic
+         * @return nodes stat in the order of urls passed to Connect
+         */
+        std::vector<NodeStat> get_stat() const;
+
+        /**
+         * @see Client::get_current_block_id
+         */
+        std::optional<uint256_t> get_current_block_id() const;
+
+        /**
+         * @see Client::get_network_state
+         */
+        response get_network_state() const;
+
+        /**
+         * @see Client::get_nodes
+         */
+        response get_nodes() const;
+
+        /**
+         * @see Client::get_blockchain_info
+         */
+        response get_blockchain_info() const;
+
+        /**
+         * @see Client::get_blockchain_state
+         */
+        response get_blockchain_state() const;
+
+        /**
+         * @see Client::get_block
+         */
+        response get_block(uint256_t id) const;
+
+        /**
+         * @see Client::get_blocks
+         */
+        std::vector<response> get_blocks(const std::vector<uint256_t> &ids) const;
+
+        /**
+         * @see Client::get_wallet_states
+         */
+        std::vector<response> get_wallet_states(const std::vector<std::string> &publicKeys) const;
+
+        /**
+         * @see Client::get_wallet_state
+         */
+        response get_wallet_state(const std::string &publicKey) const;
+
+        /**
+         * @see Client::get_wallet_transactions
+         */
+        response get_wallet_transactions(const std::string &publicKey,
+                                         const unsigned int limit = 1) const;
+
+        /**
+         * @see Client::get_wallet_state
+         */
+        response get_wallet_state(const milecsa::keys::Pair &pair) const;
+
+        /**
+         * @see Client::get_wallet_transactions
+         */
+        response get_wallet_transactions(const milecsa::keys::Pair &pair,
+                                         const unsigned int limit = 1) const;
+
+        /**
+         * Send transaction through the fastest node. Transaction is never resent to another node
+         * if the node has taken the request and failed to answer.
+         * @see Client::send_transaction
+         */
+        response send_transaction(const milecsa::keys::Pair &pair,
+                                  json transactionData) const;
+
+        /**
+         * @see Client::call
+         */
+        CallResult call(const std::string &method,
+                        const request &params) const;
+
+        /**
+         * Run user operation with a client leased from the fastest healthy node.
+         * Operation is retried on the next node if a transport error occurred.
+         * @param operation - returns true if the client call is succeeded
+         * @param idempotent - operation can be retried on another node
+         * @return true if operation is succeeded
+         */
+        bool route(const std::function<bool(const Client &client)> &operation,
+                   bool idempotent = true) const;
+
+        ClientPool& operator=(const ClientPool&);
+
+    private:
+
+        ClientPool(const std::shared_ptr<detail::PoolState> &state);
+
+        std::shared_ptr<detail::PoolState> state;
+    };
+}
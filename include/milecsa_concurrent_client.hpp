@@ -0,0 +1,188 @@
+//
+// Created by lotus mile on 2026-10-17.
+//
+
+#pragma once
+
+#include <optional>
+#include <functional>
+#include <vector>
+#include <string>
+#include <memory>
+
+#include "milecsa_jsonrpc.hpp"
+
+namespace milecsa::rpc {
+
+    namespace detail { class ConcurrentState; }
+
+    /**
+     * MILE Json-Rpc client can be shared across worker threads.
+     *
+     * Client runs its own io threads and multiplexes concurrent callers over a small set of
+     * pipelined connections to one node. Request ids are allocated lock-free, every response
+     * is checked against id of the caller request. Copies share the same connections.
+     * Blocking calls must not be made from handlers of async calls, the last copy can be released by them.
+     */
+    class ConcurrentClient {
+
+    public:
+
+        /**
+         * Create MILE json-rpc concurrent client
+         * @param urlString - MILE node runs on json-rpcd mode
+         * @param connections - connections are opened to the node
+         * @param pipeline_depth - requests are written to a connection before their responses are read
+         * @param io_threads - threads run connections io
+         * @param verify_ssl - if url contains https protocol it will enable SSL verification
+         * @param response_fail_handler - response fail handler, called from io threads
+         * @param error_handler - connection error handler, called from io threads
+         * @return optional ConcurrentClient object or nullopt if any connection can't be opened
+         */
+        static std::optional<ConcurrentClient> Connect(
+                const std::string &urlString,
+                size_t connections = 2,
+                size_t pipeline_depth = 8,
+                size_t io_threads = 1,
+                bool verify_ssl = true,
+                const http::ResponseHandler &response_fail_handler = http::default_response_handler,
+                const ErrorHandler &error_handler = default_error_handler);
+
+        ConcurrentClient(const ConcurrentClient &client);
+
+        ~ConcurrentClient();
+
+        /**
+         * Get the current url
+         * @return url
+         */
+        const Url &get_url() const;
+
+        /**
+         * Put block cache in front of get_block of all connections,
+         * must be set before the client is shared between threads
+         * @param cache - block cache or nullptr to disable caching
+         */
+        void set_block_cache(const std::shared_ptr<BlockCache> &cache);
+
+        /**
+         * Put persistent block store behind the block cache of all connections,
+         * must be set before the client is shared between threads
+         * @param store - block store or nullopt to disable it
+         */
+        void set_block_store(const std::optional<BlockStore> &store);
+
+        /**
+         * Take block id of new transactions from the background tracker on all connections,
+         * must be set before the client is shared between threads
+         * @param tracker - block id tracker or nullopt to disable it
+         */
+        void set_block_id_tracker(const std::optional<BlockIdTracker> &tracker);
+
+        /**
+         * Put short-TTL cache in front of get_blockchain_info of all connections,
+         * must be set before the client is shared between threads
+         * @param cache - response cache or nullptr to disable caching
+         */
+        void set_info_cache(const std::shared_ptr<TtlCache> &cache);
+
+        /**
+         * Set timeout of every network operation of all connections,
+         * must be set before the client is shared between threads
+         * @param timeout - operation timeout
+         */
+        void set_timeout(std::chrono::milliseconds timeout);
+
+        /**
+         * Derive operation timeouts of all connections from the observed latency of the node,
+         * must be set before the client is shared between threads
+         * @param min - timeout lower bound
+         * @param max - timeout upper bound, it is used until the first response
+         */
+        void set_adaptive_timeout(std::chrono::milliseconds min, std::chrono::milliseconds max);
+
+        /**
+         * Set response compression of all connections,
+         * must be set before the client is shared between threads
+         * @param settings - compression settings
+         */
+        void set_compression(const http::Compression &settings);
+
+        /**
+         * Get the next connection client to run async_* calls, connections are taken round robin
+         * @return client runs on the shared io threads
+         */
+        const Client &next() const;
+
+        /**
+         * @see Client::ping
+         */
+        std::optional<time_t> ping() const;
+
+        /**
+         * @see Client::get_current_block_id
+         */
+        std::optional<uint256_t> get_current_block_id() const;
+
+        /**
+         * @see Client::get_network_state
+         */
+        response get_network_state() const;
+
+        /**
+         * @see Client::get_nodes
+         */
+        response get_nodes() const;
+
+        /**
+         * @see Client::get_blockchain_info
+         */
+        response get_blockchain_info() const;
+
+        /**
+         * @see Client::get_blockchain_state
+         */
+        response get_blockchain_state() const;
+
+        /**
+         * @see Client::get_block
+         */
+        response get_block(uint256_t id) const;
+
+        /**
+         * @see Client::get_wallet_state
+         */
+        response get_wallet_state(const std::string &publicKey) const;
+
+        /**
+         * @see Client::get_wallet_transactions
+         */
+        response get_wallet_transactions(const std::string &publicKey,
+                                         const unsigned int limit = 1) const;
+
+        /**
+         * @see Client::get_wallet_state
+         */
+        response get_wallet_state(const milecsa::keys::Pair &pair) const;
+
+        /**
+         * @see Client::get_wallet_transactions
+         */
+        response get_wallet_transactions(const milecsa::keys::Pair &pair,
+                                         const unsigned int limit = 1) const;
+
+        /**
+         * @see Client::send_transaction
+         */
+        response send_transaction(const milecsa::keys::Pair &pair,
+                                  json transactionData) const;
+
+        ConcurrentClient& operator=(const ConcurrentClient&);
+
+    private:
+
+        ConcurrentClient(const std::shared_ptr<detail::ConcurrentState> &state);
+
+        std::shared_ptr<detail::ConcurrentState> state;
+    };
+}
@@ -0,0 +1,144 @@
+//
+// Created by lotus mile on 2026-10-17.
+//
+
+#pragma once
+
+#include <optional>
+#include <functional>
+#include <vector>
+#include <string>
+#include <memory>
+
+#include "milecsa_concurrent_client.hpp"
+
+namespace milecsa::rpc {
+
+    namespace detail { class HedgeState; }
+
+    /**
+     * Hedging policy of idempotent reads
+     */
+    struct HedgePolicy {
+        /**
+         * Call is sent to the second node when the first one has not answered within
+         * this percentile of its observed latency
+         */
+        double percentile = 0.95;
+
+        /**
+         * Hedge delay bounds in microseconds, max_delay is used until the node has enough samples
+         */
+        time_t min_delay = 1000;
+        time_t max_delay = 1000000;
+
+        /**
+         * Max share of hedged calls of all calls
+         */
+        double max_extra_load = 0.05;
+
+        /**
+         * Latency samples are kept per node
+         */
+        size_t window = 512;
+    };
+
+    /**
+     * Hedged reads across nodes.
+     *
+     * Every call goes to the node with the lowest hedge delay. If it has not answered within
+     * the delay, the same call is sent to the next node, the first answer is taken and the other
+     * call is cancelled: it is dropped if it has not been written yet, otherwise its response is
+     * discarded. A failed call is sent to the next node at once. Delay is the policy percentile
+     * of the latency samples of the node, hedges are bounded by the policy share of all calls.
+     * Client is cheap to copy, copies share the same nodes and statistic.
+     * Blocking calls must not be made from handlers of async calls.
+     */
+    class HedgedClient {
+
+    public:
+
+        /**
+         * Node hedging statistic
+         */
+        struct NodeStat {
+            /**
+             * Node url
+             */
+            std::string url;
+
+            /**
+             * The current hedge delay in microseconds
+             */
+            time_t delay;
+
+            /**
+             * Calls sent to node first
+             */
+            uint64_t requests;
+
+            /**
+             * Calls sent to node as hedges or retries
+             */
+            uint64_t hedges;
+
+            /**
+             * Hedges answered before the first node
+             */
+            uint64_t wins;
+
+            /**
+             * Failed calls
+             */
+            uint64_t failures;
+        };
+
+        /**
+         * Create hedged client
+         * @param clients - clients of two or more nodes, one client per node
+         * @param policy - hedging policy
+         * @param error_handler - error handler
+         * @return optional HedgedClient object, nullopt if clients are empty
+         */
+        static std::optional<HedgedClient> Start(
+                const std::vector<ConcurrentClient> &clients,
+                const HedgePolicy &policy = HedgePolicy(),
+                const ErrorHandler &error_handler = default_error_handler);
+
+        HedgedClient(const HedgedClient &client);
+
+        ~HedgedClient();
+
+        /**
+         * @see Client::get_current_block_id
+         */
+        std::optional<uint256_t> get_current_block_id() const;
+        void async_get_current_block_id(const std::function<void(const std::optional<uint256_t> &)> &handler) const;
+
+        /**
+         * @see Client::get_block
+         */
+        response get_block(uint256_t id) const;
+        void async_get_block(uint256_t id, const ResultHandler &handler) const;
+
+        /**
+         * @see Client::get_wallet_state
+         */
+        response get_wallet_state(const std::string &publicKey) const;
+        void async_get_wallet_state(const std::string &publicKey, const ResultHandler &handler) const;
+
+        /**
+         * Get nodes hedging statistic
+         * @return nodes stat in the order of clients passed to Start
+         */
+        std::vector<NodeStat> get_stat() const;
+
+        HedgedClient& operator=(const HedgedClient&);
+
+    private:
+
+        HedgedClient(const std::shared_ptr<detail::HedgeState> &state);
+
+        std::shared_ptr<detail::HedgeState> state;
+    };
+}
@@ -51,6 +51,12 @@ namespace milecsa {
              */
             std::optional<std::string> get();
 
+            /**
+             * Set response compression settings, gzip and deflate are accepted by default
+             * @param settings - compression settings
+             */
+            void set_compression(const Compression &settings);
+
             Client& operator=(const Client&);
 
         private:
@@ -0,0 +1,131 @@
+//
+// Created by lotus mile on 2026-10-17.
+//
+
+#pragma once
+
+#include <boost/beast/http/string_body.hpp>
+#include <boost/beast/http/message.hpp>
+#include <boost/beast/http/field.hpp>
+#include <boost/asio/buffer.hpp>
+#include <boost/optional.hpp>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
+
+namespace milecsa::http {
+
+    namespace detail { class Inflater; }
+
+    /**
+     * Consumer of decoded content of a successful response, it gets the content while the response is read
+     */
+    struct BodySink {
+
+        virtual ~BodySink() = default;
+
+        /**
+         * Content of a new response starts, the sink drops what it has got before
+         */
+        virtual void start() = 0;
+
+        /**
+         * Next piece of decoded content
+         */
+        virtual void write(const char *data, std::size_t size) = 0;
+
+        /**
+         * Content is complete
+         */
+        virtual void finish() = 0;
+    };
+
+    /**
+     * String body decodes gzip and deflate content encoding while the response is read,
+     * the body keeps decoded content. Body without content encoding is taken as is.
+     */
+    struct inflate_body: public boost::beast::http::string_body {
+
+        /**
+         * Decoded content, body decoded to more than limit bytes is refused with http::error::body_limit
+         */
+        struct value_type: public std::string {
+            using std::string::string;
+            using std::string::operator=;
+
+            size_t limit = std::numeric_limits<size_t>::max();
+
+            /**
+             * Content of 200 OK response is passed to the sink, the body keeps its first bytes only
+             */
+            BodySink *sink = nullptr;
+
+            /**
+             * Content has been passed to the sink
+             */
+            bool streamed = false;
+
+            /**
+             * Decoded content size
+             */
+            size_t content_size() const { return streamed ? streamed_size : size(); }
+
+            size_t streamed_size = 0;
+        };
+
+        class reader {
+
+        public:
+
+            /**
+             * Reader is created with the parser before the header is read, encoding and status are taken in init
+             */
+            template<bool isRequest, class Fields>
+            explicit reader(boost::beast::http::header<isRequest, Fields> &header, value_type &body):
+                    reader([&header]{
+                        return std::string(header[boost::beast::http::field::content_encoding]);
+                    }, [&header]{
+                        if constexpr (isRequest)
+                            return false;
+                        else
+                            return header.result() == boost::beast::http::status::ok;
+                    }, body) {}
+
+            reader(const reader &) = delete;
+            reader &operator=(const reader &) = delete;
+
+            ~reader();
+
+            void init(const boost::optional<std::uint64_t> &length, boost::system::error_code &ec);
+
+            template<class ConstBufferSequence>
+            std::size_t put(const ConstBufferSequence &buffers, boost::system::error_code &ec) {
+                std::size_t taken = 0;
+                for (auto it = boost::asio::buffer_sequence_begin(buffers); it != boost::asio::buffer_sequence_end(buffers); ++it) {
+                    boost::asio::const_buffer buffer = *it;
+                    write(static_cast<const char *>(buffer.data()), buffer.size(), ec);
+                    if (ec)
+                        return taken;
+                    taken += buffer.size();
+                }
+                return taken;
+            }
+
+            void finish(boost::system::error_code &ec);
+
+        private:
+
+            reader(std::function<std::string()> encoding, std::function<bool()> succeeded, value_type &body);
+
+            void write(const char *data, std::size_t size, boost::system::error_code &ec);
+
+            std::function<std::string()> encoding;
+            std::function<bool()> succeeded;
+            value_type &body;
+            std::unique_ptr<detail::Inflater> inflater;
+            BodySink *sink = nullptr;
+            std::string decoded;
+        };
+    };
+}
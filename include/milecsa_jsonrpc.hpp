@@ -2,7 +2,10 @@
 
 #include <optional>
 #include <functional>
-#include <any>
+#include <variant>
+#include <future>
+#include <utility>
+#include <vector>
 #include <boost/asio.hpp>
 #include <boost/filesystem/path.hpp>
 #include <boost/beast/http.hpp>
@@ -10,6 +13,11 @@
 #include "milecsa.hpp"
 #include "milecsa_url.hpp"
 #include "milecsa_rpc_session.hpp"
+#include "milecsa_cache.hpp"
+#include "milecsa_block_store.hpp"
+#include "milecsa_block_id_tracker.hpp"
+#include "milecsa_rpc_types.hpp"
+#include "milecsa_rpc_methods.hpp"
 #include "json.hpp"
 
 namespace milecsa {
@@ -18,6 +26,8 @@ namespace milecsa {
 
         namespace detail { class RpcSession; }
 
+        class ClientPool;
+
         /**
          * MILE Json-Rpc client
          */
@@ -27,6 +37,11 @@ namespace milecsa {
 
             static time_t timeout;
 
+            /**
+             * Maximum commands are sent in one batch request
+             */
+            static size_t batch_limit;
+
             /**
              * Create MILE json-rpc client controller
              * @param urlString - MILE node runs on json-rpcd mode
@@ -41,6 +56,23 @@ namespace milecsa {
                     const http::ResponseHandler &response_fail_handler = http::default_response_handler,
                     const ErrorHandler &error_handler = default_error_handler);
 
+            /**
+             * Create MILE json-rpc client controller runs on the shared io context.
+             * Client should be used through async_* interface, connection is established on the first call.
+             * @param ioc - io context shared by many clients, caller runs it
+             * @param urlString - MILE node runs on json-rpcd mode
+             * @param verify_ssl - if url contains https protocol it will enable SSL verification
+             * @param response_fail_handler - response fail handler
+             * @param error_handler - connection error handler
+             * @return options Client object
+             */
+            static std::optional<Client> Connect(
+                    boost::asio::io_context &ioc,
+                    const std::string &urlString,
+                    bool verify_ssl = true,
+                    const http::ResponseHandler &response_fail_handler = http::default_response_handler,
+                    const ErrorHandler &error_handler = default_error_handler);
+
             Client(const Client &client);
 
             ~Client();
@@ -51,6 +83,57 @@ namespace milecsa {
              */
             const Url &get_url() const { return *url_; }
 
+            /**
+             * Put block cache in front of get_block and get_blocks, cache can be shared by many clients
+             * @param cache - block cache or nullptr to disable caching
+             */
+            void set_block_cache(const std::shared_ptr<BlockCache> &cache) { block_cache = cache; }
+
+            /**
+             * Put short-TTL cache in front of get_blockchain_info
+             * @param cache - response cache or nullptr to disable caching
+             */
+            void set_info_cache(const std::shared_ptr<TtlCache> &cache) { info_cache = cache; }
+
+            /**
+             * Put persistent block store behind the block cache, get_block and get_blocks consult it
+             * before the network and append every fetched block to it
+             * @param store - block store or nullopt to disable it
+             */
+            void set_block_store(const std::optional<BlockStore> &store) { block_store = store; }
+
+            /**
+             * Take block id of new transactions from the background tracker instead of the node,
+             * block id is requested from the node when tracked one is stale
+             * @param tracker - block id tracker or nullopt to disable it
+             */
+            void set_block_id_tracker(const std::optional<BlockIdTracker> &tracker) { block_id_tracker = tracker; }
+
+            /**
+             * Get the current block id tracker
+             * @return tracker or nullopt
+             */
+            const std::optional<BlockIdTracker> &get_block_id_tracker() const { return block_id_tracker; }
+
+            /**
+             * Get the current block cache
+             * @return cache or nullptr
+             */
+            const std::shared_ptr<BlockCache> &get_block_cache() const { return block_cache; }
+
+            /**
+             * Get the current blockchain info cache
+             * @return cache or nullptr
+             */
+            const std::shared_ptr<TtlCache> &get_info_cache() const { return info_cache; }
+
+            /**
+             * Look up block in the cache and the store, the node is not asked
+             * @param id - block id
+             * @return block or nullopt if it is not kept locally
+             */
+            response find_block(const uint256_t &id) const;
+
             /**
              * Ping jsonrpc node service.
              * @return interval between start request and response finish in microseconds
@@ -99,6 +182,20 @@ namespace milecsa {
              */
             response get_block(uint256_t id) const;
 
+            /**
+             * Get blocks by id list in batch requests
+             * @param ids - block id list
+             * @return blocks in the order of ids, nullopt for blocks are not received
+             */
+            std::vector<response> get_blocks(const std::vector<uint256_t> &ids) const;
+
+            /**
+             * Get wallet states by public key list in batch requests
+             * @param publicKeys - wallet public keys
+             * @return wallet states in the order of public keys, nullopt for states are not received
+             */
+            std::vector<response> get_wallet_states(const std::vector<std::string> &publicKeys) const;
+
             /**
              * Get wallet state by public key
              * @param publicKey - wallet public key
@@ -146,23 +243,220 @@ namespace milecsa {
             response send_transaction(const milecsa::keys::Pair &pair,
                                       json transactionData) const;
             /**
-             * Run rpc method by name with parameters
+             * Run rpc method by name with parameters, built-in and registered methods are supported
+             * @see Methods::Register
              * @param method - method name
              * @param params - json-rpc params
-             * @return rpc object respons
+             * @return result variant, std::monostate if method is failed
              */
-            std::any call(const std::string &method,
-                          const request &params) const;
+            CallResult call(const std::string &method,
+                            const request &params) const;
+
+            /**
+             * Run rpc method and pass events of the result value to SAX handler, the response DOM
+             * is not built, e.g. long wallet transaction lists can be filtered while they are parsed
+             * @param method - method name
+             * @param params - json-rpc params
+             * @param sax - result value events handler
+             * @return true if result is received
+             */
+            bool stream(const std::string &method,
+                        const request &params,
+                        ResultSax &sax) const;
+
+            /**
+             * Run rpc method returns typed result, e.g. get<WalletState>({{"public-key", pk}}).
+             * Result is decoded from the response events without json DOM, caches and block store are not used.
+             * @tparam T - result structure: CurrentBlockId, WalletState, WalletTransactions, Block, BlockchainState, NodeList
+             * @param params - json-rpc params
+             * @return optional result
+             */
+            template <typename T>
+            std::optional<T> get(const request &params = {}) const {
+                detail::TypedSax<T> sax;
+                if (!stream(T::method, params, sax))
+                    return std::nullopt;
+                return std::move(sax.value);
+            }
+
+            /**
+             * Run rpc methods in batch requests
+             * @param commands - method name and params pairs
+             * @return responses in the order of commands
+             */
+            std::vector<response> batch(const std::vector<std::pair<std::string, request>> &commands) const;
+
+            /**
+             * Run rpc methods over HTTP/1.1 pipeline
+             * @see Client::set_pipeline_depth
+             * @param commands - method name and params pairs
+             * @return responses in the order of commands
+             */
+            std::vector<response> pipeline(const std::vector<std::pair<std::string, request>> &commands) const;
+
+            /**
+             * Set how many requests are written to the client connection before their responses are read,
+             * affects pipeline() and async_* calls. Default is 1: strict request/response mode.
+             * @param depth - pipeline depth
+             */
+            void set_pipeline_depth(size_t depth);
+
+            /**
+             * Get copy of the client, its calls share the context: composite calls like send-transfer
+             * run all their requests within the same absolute deadline. Cancelled calls return nullopt,
+             * error handler is not called.
+             *
+             *   auto token = rpc::CancelToken();
+             *   client.with(rpc::CallContext::Timeout(std::chrono::milliseconds(1500), token)).call("send-transfer", params);
+             *
+             * @param context - deadline and cancellation token
+             * @return client copy shares the same session
+             */
+            Client with(const CallContext &context) const;
+
+            /**
+             * Set timeout of every network operation of the client session, Client::timeout is the default
+             * @param timeout - operation timeout
+             */
+            void set_timeout(std::chrono::milliseconds timeout);
+
+            /**
+             * Derive operation timeouts from the observed latency of the node
+             * @param adaptive - latency estimator, can be shared by clients of the same node; nullptr turns it off
+             */
+            void set_adaptive_timeout(const std::shared_ptr<AdaptiveTimeout> &adaptive);
+
+            /**
+             * Set response compression of the client session, gzip and deflate are accepted by default
+             * @param settings - compression settings
+             */
+            void set_compression(const http::Compression &settings);
+
+            /**
+             * Asynchronous versions of the client calls, client must be connected with the shared io context.
+             * Handler is called from the thread runs io context, future variants must not be waited
+             * from that thread.
+             * @see Client::ping
+             */
+            void async_ping(const std::function<void(const std::optional<time_t> &)> &handler) const;
+            std::future<std::optional<time_t>> async_ping() const;
+
+            /**
+             * @see Client::get_current_block_id
+             */
+            void async_get_current_block_id(const std::function<void(const std::optional<uint256_t> &)> &handler) const;
+            std::future<std::optional<uint256_t>> async_get_current_block_id() const;
+
+            /**
+             * @see Client::get_network_state
+             */
+            void async_get_network_state(const ResultHandler &handler) const;
+            std::future<response> async_get_network_state() const;
+
+            /**
+             * @see Client::get_nodes
+             */
+            void async_get_nodes(const ResultHandler &handler) const;
+            std::future<response> async_get_nodes() const;
+
+            /**
+             * @see Client::get_blockchain_info
+             */
+            void async_get_blockchain_info(const ResultHandler &handler) const;
+            std::future<response> async_get_blockchain_info() const;
+
+            /**
+             * @see Client::get_blockchain_state
+             */
+            void async_get_blockchain_state(const ResultHandler &handler) const;
+            std::future<response> async_get_blockchain_state() const;
+
+            /**
+             * @see Client::get_block
+             */
+            void async_get_block(uint256_t id, const ResultHandler &handler) const;
+            std::future<response> async_get_block(uint256_t id) const;
+
+            /**
+             * @see Client::get_wallet_state
+             */
+            void async_get_wallet_state(const std::string &publicKey, const ResultHandler &handler) const;
+            std::future<response> async_get_wallet_state(const std::string &publicKey) const;
+
+            /**
+             * @see Client::get_wallet_state
+             */
+            void async_get_wallet_state(const milecsa::keys::Pair &pair, const ResultHandler &handler) const;
+            std::future<response> async_get_wallet_state(const milecsa::keys::Pair &pair) const;
+
+            /**
+             * @see Client::get_wallet_transactions
+             */
+            void async_get_wallet_transactions(const std::string &publicKey,
+                                               const unsigned int limit,
+                                               const ResultHandler &handler) const;
+            std::future<response> async_get_wallet_transactions(const std::string &publicKey,
+                                                                const unsigned int limit = 1) const;
+
+            /**
+             * @see Client::get_wallet_transactions
+             */
+            void async_get_wallet_transactions(const milecsa::keys::Pair &pair,
+                                               const unsigned int limit,
+                                               const ResultHandler &handler) const;
+            std::future<response> async_get_wallet_transactions(const milecsa::keys::Pair &pair,
+                                                                const unsigned int limit = 1) const;
+
+            /**
+             * @see Client::send_transaction
+             */
+            void async_send_transaction(const milecsa::keys::Pair &pair,
+                                        json transactionData,
+                                        const ResultHandler &handler) const;
+            std::future<response> async_send_transaction(const milecsa::keys::Pair &pair,
+                                                         json transactionData) const;
+
+            /**
+             * Send transaction body is signed offline
+             * @see Client::send_transaction
+             */
+            void async_send_transaction(json transactionData, const ResultHandler &handler) const;
+
+            /**
+             * Send transaction body is signed offline, handler learns if the request has been written:
+             * failed written transaction could be accepted by node
+             * @see Client::send_transaction
+             */
+            void async_send_transaction(json transactionData, const DeliveryHandler &handler) const;
 
             Client& operator=(const Client&);
 
         private:
 
+            friend class ClientPool;
+            friend class ConcurrentClient;
+
+            Client(const Url &url,
+                   bool verify_ssl,
+                   const http::ResponseHandler &response_handler,
+                   const ErrorHandler &error_handler);
+
             Client(const Url &url,
+                   const std::shared_ptr<detail::RpcSession> &session,
                    bool verify_ssl,
                    const http::ResponseHandler &response_handler,
                    const ErrorHandler &error_handler);
 
+            /**
+             * Put fetched block to the cache and the store
+             */
+            void keep_block(const uint256_t &id, const json &block) const;
+
+            /**
+             * Post cached result to the io context, handler is called the same way as on the fetched one
+             */
+            void delivered(const rpc::response &result, const ResultHandler &handler) const;
+
             Client():verify_ssl_(true),
                      response_fail_handler(http::default_response_handler),
                      error_handler(default_error_handler){};
@@ -171,6 +465,12 @@ namespace milecsa {
             bool verify_ssl_;
             std::shared_ptr<detail::RpcSession> session;
 
+            std::shared_ptr<BlockCache> block_cache;
+            std::shared_ptr<TtlCache> info_cache;
+            std::optional<BlockStore> block_store;
+            std::optional<BlockIdTracker> block_id_tracker;
+            CallContext context;
+
             http::ResponseHandler response_fail_handler;
             ErrorHandler error_handler;
         };
@@ -0,0 +1,129 @@
+//
+// Created by lotus mile on 2026-10-17.
+//
+
+#pragma once
+
+#include "milecsa_jsonrpc.hpp"
+
+#if defined(BOOST_ASIO_HAS_CO_AWAIT)
+
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <boost/asio/async_result.hpp>
+#include <boost/asio/dispatch.hpp>
+
+namespace milecsa::rpc {
+
+    /**
+     * Awaitable result of the coroutine client
+     */
+    template <typename T>
+    using awaitable = boost::asio::awaitable<T>;
+
+    /**
+     * MILE Json-Rpc coroutine client, requires C++20 coroutines (MILECSA_WITH_COROUTINES build option).
+     * Calls suspend the caller coroutine until response is read:
+     *
+     *     co_await client.get_block(id)
+     *
+     * Client runs on the shared io context, coroutines are resumed on their own executor.
+     */
+    class CoClient {
+
+    public:
+
+        /**
+         * Create MILE json-rpc coroutine client, connection is established on the first call
+         * @param ioc - io context shared by many clients, caller runs it
+         * @param urlString - MILE node runs on json-rpcd mode
+         * @param verify_ssl - if url contains https protocol it will enable SSL verification
+         * @param response_fail_handler - response fail handler
+         * @param error_handler - connection error handler
+         * @return options CoClient object
+         */
+        static std::optional<CoClient> Connect(
+                boost::asio::io_context &ioc,
+                const std::string &urlString,
+                bool verify_ssl = true,
+                const http::ResponseHandler &response_fail_handler = http::default_response_handler,
+                const ErrorHandler &error_handler = default_error_handler);
+
+        /**
+         * Get underlying callback client
+         * @return client
+         */
+        const Client &get_client() const { return client_; }
+
+        /**
+         * @see Client::ping
+         */
+        awaitable<std::optional<time_t>> ping() const;
+
+        /**
+         * @see Client::get_current_block_id
+         */
+        awaitable<std::optional<uint256_t>> get_current_block_id() const;
+
+        /**
+         * @see Client::get_network_state
+         */
+        awaitable<response> get_network_state() const;
+
+        /**
+         * @see Client::get_nodes
+         */
+        awaitable<response> get_nodes() const;
+
+        /**
+         * @see Client::get_blockchain_info
+         */
+        awaitable<response> get_blockchain_info() const;
+
+        /**
+         * @see Client::get_blockchain_state
+         */
+        awaitable<response> get_blockchain_state() const;
+
+        /**
+         * @see Client::get_block
+         */
+        awaitable<response> get_block(uint256_t id) const;
+
+        /**
+         * @see Client::get_wallet_state
+         */
+        awaitable<response> get_wallet_state(std::string publicKey) const;
+
+        /**
+         * @see Client::get_wallet_state
+         */
+        awaitable<response> get_wallet_state(const milecsa::keys::Pair &pair) const;
+
+        /**
+         * @see Client::get_wallet_transactions
+         */
+        awaitable<response> get_wallet_transactions(std::string publicKey,
+                                                    const unsigned int limit = 1) const;
+
+        /**
+         * @see Client::get_wallet_transactions
+         */
+        awaitable<response> get_wallet_transactions(const milecsa::keys::Pair &pair,
+                                                    const unsigned int limit = 1) const;
+
+        /**
+         * @see Client::send_transaction
+         */
+        awaitable<response> send_transaction(milecsa::keys::Pair pair,
+                                             json transactionData) const;
+
+    private:
+
+        CoClient(const Client &client): client_(client) {}
+
+        Client client_;
+    };
+}
+
+#endif
@@ -0,0 +1,79 @@
+//
+// Created by lotus mile on 2026-10-17.
+//
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <functional>
+#include <boost/asio/ip/tcp.hpp>
+
+namespace milecsa::rpc {
+
+    namespace detail { class ResolverState; }
+
+    /**
+     * Singleton DNS cache shared by all sessions.
+     *
+     * Resolved endpoints are kept for ttl. Endpoints past ttl are returned at once while the host
+     * is resolved again on the cache thread, so reconnects after a node restart do not wait for DNS.
+     * Endpoints expired by a connection failure are returned only if the fresh query fails.
+     * Concurrent lookups of the same host share one query. Endpoints are ordered for parallel
+     * connect: address families alternate starting from the first resolved one.
+     */
+    class ResolverCache {
+
+    public:
+
+        typedef std::vector<boost::asio::ip::tcp::endpoint> Endpoints;
+
+        /**
+         * Lookup completion handler, called from the cache thread or from the caller thread
+         * if the host is cached
+         */
+        typedef std::function<void(const boost::system::error_code &ec, const Endpoints &endpoints)> Handler;
+
+        static ResolverCache& Instance();
+
+        /**
+         * Set how long resolved endpoints are fresh, default is 60 seconds
+         * @param ttl - time to live
+         */
+        void set_ttl(std::chrono::seconds ttl);
+
+        /**
+         * Resolve host, caller is blocked if the host is not cached
+         * @param host - host name or address
+         * @param port - port
+         * @param ec - lookup error
+         * @return endpoints
+         */
+        Endpoints resolve(const std::string &host, const std::string &port, boost::system::error_code &ec);
+
+        /**
+         * Resolve host asynchronously
+         * @param host - host name or address
+         * @param port - port
+         * @param handler - completion handler
+         */
+        void async_resolve(const std::string &host, const std::string &port, const Handler &handler);
+
+        /**
+         * Mark cached endpoints stale, e.g. when none of them accepts connection:
+         * the next lookup waits for the fresh query and falls back to them if the query fails
+         * @param host - host name or address
+         * @param port - port
+         */
+        void expire(const std::string &host, const std::string &port);
+
+    private:
+
+        ResolverCache();
+        ~ResolverCache();
+
+        std::unique_ptr<detail::ResolverState> state;
+    };
+}
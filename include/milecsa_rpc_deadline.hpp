@@ -0,0 +1,132 @@
+//
+// Created by lotus mile on 2026-10-17.
+//
+
+#pragma once
+
+#include <optional>
+#include <functional>
+#include <chrono>
+#include <memory>
+#include <mutex>
+
+namespace milecsa::rpc {
+
+    namespace detail { class CancelState; }
+
+    /**
+     * Cancellation token of one or more calls. Token is cheap to copy, copies share the same state.
+     */
+    class CancelToken {
+
+    public:
+
+        typedef std::function<void()> Callback;
+
+        CancelToken();
+
+        /**
+         * Cancel calls of the token, subscribed callbacks are called once from the cancelling thread
+         */
+        void cancel() const;
+
+        /**
+         * Check whether the token is cancelled
+         * @return true if cancelled
+         */
+        bool is_cancelled() const;
+
+        /**
+         * Subscribe to cancellation, callback is called at once if the token is cancelled already.
+         * Callback must not subscribe or unsubscribe.
+         * @param callback - cancellation callback
+         * @return subscription id
+         */
+        size_t subscribe(const Callback &callback) const;
+
+        /**
+         * Unsubscribe from cancellation, callback is not running when it returns
+         * @param id - subscription id
+         */
+        void unsubscribe(size_t id) const;
+
+    private:
+
+        std::shared_ptr<detail::CancelState> state;
+    };
+
+    /**
+     * Call deadline and cancellation, composite calls of one context share its absolute deadline
+     */
+    struct CallContext {
+
+        typedef std::chrono::steady_clock clock;
+
+        /**
+         * Call fails with timeout when the deadline is reached
+         */
+        std::optional<clock::time_point> deadline;
+
+        /**
+         * Call is abandoned when the token is cancelled
+         */
+        std::optional<CancelToken> token;
+
+        /**
+         * Create context with deadline after the timeout
+         * @param timeout - call timeout
+         * @param token - optional cancellation token
+         * @return call context
+         */
+        static CallContext Timeout(std::chrono::milliseconds timeout,
+                                   const std::optional<CancelToken> &token = std::nullopt);
+
+        bool is_cancelled() const;
+
+        bool is_expired() const;
+
+        /**
+         * Bound operation timeout by the deadline
+         * @param timeout - operation timeout
+         * @return the rest of timeout, zero if the deadline is reached
+         */
+        std::chrono::milliseconds bound(std::chrono::milliseconds timeout) const;
+    };
+
+    /**
+     * Timeout derived from the observed latency of one node: smoothed latency plus
+     * multiplier of its mean deviation, bounded by min and max. Estimator can be shared
+     * by all sessions of the node.
+     */
+    class AdaptiveTimeout {
+
+    public:
+
+        AdaptiveTimeout(std::chrono::milliseconds min,
+                        std::chrono::milliseconds max,
+                        double multiplier = 4);
+
+        /**
+         * Add latency sample of the completed request
+         * @param latency - request latency
+         */
+        void observe(std::chrono::microseconds latency);
+
+        /**
+         * Get the current timeout, max until the first sample
+         * @return timeout
+         */
+        std::chrono::milliseconds get() const;
+
+    private:
+
+        const std::chrono::milliseconds min;
+        const std::chrono::milliseconds max;
+        const double multiplier;
+
+        mutable std::mutex mutex;
+        double latency;
+        double deviation;
+        bool observed;
+    };
+}
@@ -4,11 +4,13 @@
 
 #pragma once
 
+#include <atomic>
+
 namespace milecsa::rpc {
 
     template <typename T>
     /**
-     * Singleton ID counter
+     * Singleton ID counter, ids are allocated lock-free and can be taken from any thread
      * @tparam T
      * */
     class IdCounter {
@@ -20,7 +22,7 @@ namespace milecsa::rpc {
          * @return next ID
          */
         T get_next() {
-            return id_++;
+            return id_.fetch_add(1, std::memory_order_relaxed);
         }
 
     public:
@@ -41,7 +43,7 @@ namespace milecsa::rpc {
         ~IdCounter() {}
 
     private:
-        T id_;
+        std::atomic<T> id_;
 
     };
 }
@@ -0,0 +1,70 @@
+//
+// Created by lotus mile on 2026-10-17.
+//
+
+#pragma once
+
+#include <string>
+#include <variant>
+#include <functional>
+
+#include "milecsa.hpp"
+#include "milecsa_error.hpp"
+#include "json.hpp"
+
+namespace milecsa::rpc {
+
+    class Client;
+
+    /**
+     * Result of method called by name: nothing, ping time, block id or json response
+     */
+    typedef std::variant<std::monostate, time_t, uint256_t, nlohmann::json> CallResult;
+
+    /**
+     * User method called by name through Client::call
+     */
+    typedef std::function<CallResult(const Client &client,
+                                     const std::string &method,
+                                     const nlohmann::json &params,
+                                     const ErrorHandler &error_handler)> MethodHandler;
+
+    /**
+     * Methods can be called by name. Built-in methods are dispatched through the perfect hash table
+     * is built at compile time, user methods are looked up after them.
+     */
+    class Methods {
+
+    public:
+
+        /**
+         * Register user method, it is available to every client
+         * @param name - method name
+         * @param handler - method handler
+         * @return false if name is taken by built-in method
+         */
+        static bool Register(const std::string &name, const MethodHandler &handler);
+
+        /**
+         * Unregister user method
+         * @param name - method name
+         */
+        static void Unregister(const std::string &name);
+
+        /**
+         * Check method is known
+         * @param name - method name
+         * @return true for built-in and registered methods
+         */
+        static bool Contains(const std::string &name);
+    };
+
+    /**
+     * Check call has result
+     * @param result - call result
+     * @return true if result is not empty
+     */
+    inline bool has_result(const CallResult &result) {
+        return !std::holds_alternative<std::monostate>(result);
+    }
+}
@@ -0,0 +1,245 @@
+//
+// Created by lotus mile on 2026-10-17.
+//
+
+#pragma once
+
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "json.hpp"
+#include "milecsa_inflate_body.hpp"
+
+#if NLOHMANN_JSON_VERSION_MAJOR > 3 || (NLOHMANN_JSON_VERSION_MAJOR == 3 && NLOHMANN_JSON_VERSION_MINOR >= 8)
+#define MILECSA_JSON_SAX_BINARY 1
+#endif
+
+namespace milecsa::rpc {
+
+    /**
+     * SAX events handler of json-rpc result value.
+     * Response envelope is skipped, handler gets the events of "result" value only,
+     * so the caller can keep what it needs without building the DOM of the whole response.
+     * @see https://nlohmann.github.io/json/features/parsing/sax_interface/
+     */
+    typedef nlohmann::json_sax<nlohmann::json> ResultSax;
+
+    namespace detail {
+
+        /**
+         * Build json value from SAX events
+         */
+        class DomSax: public ResultSax {
+
+        public:
+
+            bool null() override;
+            bool boolean(bool val) override;
+            bool number_integer(number_integer_t val) override;
+            bool number_unsigned(number_unsigned_t val) override;
+            bool number_float(number_float_t val, const string_t &s) override;
+            bool string(string_t &val) override;
+#ifdef MILECSA_JSON_SAX_BINARY
+            bool binary(binary_t &val) override;
+#endif
+            bool start_object(std::size_t elements) override;
+            bool key(string_t &val) override;
+            bool end_object() override;
+            bool start_array(std::size_t elements) override;
+            bool end_array() override;
+            bool parse_error(std::size_t position,
+                             const std::string &last_token,
+                             const nlohmann::detail::exception &ex) override;
+
+            /**
+             * Built value
+             */
+            nlohmann::json value;
+
+        private:
+
+            nlohmann::json *add(nlohmann::json &&val);
+
+            std::vector<nlohmann::json *> stack;
+            std::string pending_key;
+        };
+
+        /**
+         * Route "result" value events of json-rpc response to the sink and collect the envelope id.
+         * Sink stopped by returning false gets no more events, the envelope is read to the end anyway
+         */
+        class EnvelopeSax: public ResultSax {
+
+        public:
+
+            EnvelopeSax(ResultSax &sink): sink(sink) {}
+
+            /**
+             * Forget the events of the previous response
+             */
+            void reset();
+
+            bool null() override;
+            bool boolean(bool val) override;
+            bool number_integer(number_integer_t val) override;
+            bool number_unsigned(number_unsigned_t val) override;
+            bool number_float(number_float_t val, const string_t &s) override;
+            bool string(string_t &val) override;
+#ifdef MILECSA_JSON_SAX_BINARY
+            bool binary(binary_t &val) override;
+#endif
+            bool start_object(std::size_t elements) override;
+            bool key(string_t &val) override;
+            bool end_object() override;
+            bool start_array(std::size_t elements) override;
+            bool end_array() override;
+            bool parse_error(std::size_t position,
+                             const std::string &last_token,
+                             const nlohmann::detail::exception &ex) override;
+
+            /**
+             * Envelope id, string or dumped number, nullopt if the id is null or missing
+             */
+            std::optional<std::string> id;
+
+            /**
+             * Result value has been passed to sink and it is not null
+             */
+            bool has_result = false;
+
+            /**
+             * Sink has stopped taking the result
+             */
+            bool stopped = false;
+
+            /**
+             * Parse error message
+             */
+            std::optional<std::string> error;
+
+        private:
+
+            template <typename Call>
+            bool result_scalar(bool is_null, Call call);
+            template <typename Call>
+            bool forward(Call call);
+            bool envelope_scalar(const nlohmann::json &val);
+
+            ResultSax &sink;
+
+            size_t depth = 0;
+            size_t result_depth = 0;
+            bool in_result = false;
+            std::string current_key;
+        };
+
+        /**
+         * Incremental json parser: text is written piece by piece as it arrives,
+         * SAX events are sent as soon as a token is complete.
+         * Strings are checked to be well-formed UTF-8, numbers out of double range are parse errors
+         */
+        class JsonPushParser {
+
+        public:
+
+            JsonPushParser(ResultSax &sax): sax(sax) {}
+
+            /**
+             * Forget the previous text
+             */
+            void reset();
+
+            /**
+             * Parse next piece of text
+             * @return false if text is malformed or handler has stopped parsing
+             */
+            bool write(const char *data, size_t size);
+
+            /**
+             * Text is complete
+             * @return false if text is malformed
+             */
+            bool finish();
+
+            /**
+             * Parse error message
+             */
+            std::optional<std::string> error;
+
+            /**
+             * Handler has stopped parsing
+             */
+            bool stopped = false;
+
+        private:
+
+            enum class token { none, string, number, literal };
+            enum class expect { value, value_or_end_array, key, key_or_end_object, colon, comma_or_end, done };
+
+            bool consume(char c);
+            bool structural(char c);
+            bool value_start(char c);
+            bool string_char(char c);
+            bool unicode_char();
+            bool utf8_char(unsigned char c);
+            bool close(char open);
+            bool complete_value();
+            bool emit_string();
+            bool emit_number();
+            bool emit_literal();
+            bool fail(const std::string &what);
+            bool stop();
+
+            ResultSax &sax;
+
+            std::vector<char> containers;
+            expect state = expect::value;
+            token lexeme = token::none;
+            std::string text;
+            bool is_key = false;
+            bool escape = false;
+            int hex_digits = 0;
+            uint32_t code_point = 0;
+            uint32_t high_surrogate = 0;
+            int utf8_pending = 0;
+            unsigned char utf8_low = 0x80;
+            unsigned char utf8_high = 0xbf;
+            size_t position = 0;
+        };
+
+        /**
+         * Json-rpc response parser fed by the response body reader
+         */
+        class ResponseParser: public http::BodySink {
+
+        public:
+
+            ResponseParser(ResultSax &sink): envelope(sink), parser(envelope) {}
+
+            void start() override;
+            void write(const char *data, std::size_t size) override;
+            void finish() override;
+
+            EnvelopeSax envelope;
+            JsonPushParser parser;
+        };
+
+        /**
+         * Json-rpc response parsed to the result value
+         */
+        class DomResponse: public http::BodySink {
+
+        public:
+
+            DomResponse(): parser(dom) {}
+
+            void start() override;
+            void write(const char *data, std::size_t size) override;
+            void finish() override;
+
+            DomSax dom;
+            ResponseParser parser;
+        };
+    }
+}
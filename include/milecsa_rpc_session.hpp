@@ -7,6 +7,9 @@
 #include "json.hpp"
 #include "milecsa_url.hpp"
 #include "milecsa_rpc_id.hpp"
+#include "milecsa_rpc_sax.hpp"
+#include "milecsa_rpc_deadline.hpp"
+#include "milecsa_inflate_body.hpp"
 
 #include <optional>
 #include <chrono>
@@ -22,6 +25,15 @@
 #include <cstdlib>
 #include <boost/asio/ssl/error.hpp>
 #include <boost/asio/ssl/stream.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/strand.hpp>
+#include <memory>
+#include <atomic>
+#include <deque>
+#include <vector>
+#include <unordered_map>
+#include <future>
+#include <mutex>
 
 namespace milecsa {
 
@@ -32,9 +44,9 @@ namespace milecsa {
         typedef boost::beast::http::status status;
 
         /**
-         * JSON-RPC  HTTP response string body
+         * JSON-RPC  HTTP response string body, gzip and deflate encoded bodies are decoded while read
          */
-        typedef boost::beast::http::response<boost::beast::http::string_body> response;
+        typedef boost::beast::http::response<inflate_body> response;
 
         /**
          * JSON-RPC HTTP response fail handler
@@ -48,11 +60,118 @@ namespace milecsa {
         static auto default_response_handler = [](const status code, const std::string &method,
                                                   const response &response) {};
 
+        /**
+         * HTTP request with string body
+         */
+        typedef boost::beast::http::request<boost::beast::http::string_body> request;
+
+        /**
+         * Serializes json into a kept string through the json stream output, the string capacity is reused
+         */
+        class BodyWriter: private std::streambuf {
+
+        public:
+
+            BodyWriter(): out(this) {}
+
+            void write(std::string &target, const nlohmann::json &value) {
+                target.clear();
+                this->target = &target;
+                out << value;
+                this->target = nullptr;
+            }
+
+        private:
+
+            int_type overflow(int_type c) override {
+                if (!traits_type::eq_int_type(c, traits_type::eof()))
+                    target->push_back(traits_type::to_char_type(c));
+                return traits_type::not_eof(c);
+            }
+
+            std::streamsize xsputn(const char *s, std::streamsize n) override {
+                target->append(s, static_cast<size_t>(n));
+                return n;
+            }
+
+            std::string *target = nullptr;
+            std::ostream out;
+        };
+
         using namespace boost::asio::ip;
         namespace ssl = boost::asio::ssl;
 
-        class Session {
+        namespace detail { class ParallelConnect; }
+
+        /**
+         * Response compression settings
+         */
+        struct Compression {
+            /**
+             * Advertise Accept-Encoding: gzip, deflate
+             */
+            bool enabled = true;
+
+            /**
+             * Method or target answered with a smaller decoded body than this is requested without compression
+             */
+            size_t min_size = 1024;
+
+            /**
+             * Response decoded to a larger body than this is failed with http::error::body_limit
+             */
+            size_t max_size = 64 * 1024 * 1024;
+        };
+
+        /**
+         * Asynchronous request/response exchange
+         */
+        struct Exchange {
+
+            /**
+             * Exchange completion handler
+             * @param ec - error code, empty if response is read
+             * @param stage - failed stage description
+             */
+            typedef std::function<void(const boost::system::error_code &ec, const std::string &stage)> Handler;
+
+            request req;
+            response res;
+            Handler done;
+
+            /**
+             * Request can be sent again if connection is closed before response is read
+             */
+            bool idempotent = true;
+            unsigned int retries = 0;
+
+            /**
+             * Exchange fails with timeout at the context deadline and is abandoned when its token
+             * is cancelled: queued exchange is dropped, response of the written one is read and discarded
+             */
+            rpc::CallContext context;
+
+            /**
+             * Completion handler has been called
+             */
+            bool finished = false;
+
+            /**
+             * Request writing start, epoch if request has never been written
+             */
+            std::chrono::steady_clock::time_point sent;
+            std::unique_ptr<boost::asio::steady_timer> timer;
+            std::optional<size_t> subscription;
+        };
+
+        class Session: public std::enable_shared_from_this<Session> {
         public:
+
+            /**
+             * Connection attempts to resolved addresses are started in parallel with this delay,
+             * the next attempt is started at once when one fails. The first connected socket is kept.
+             */
+            static std::chrono::milliseconds connection_attempt_delay;
             /**
              * Create single JSON-RPC over HTTP/HTTPS session
              *
@@ -69,6 +188,60 @@ namespace milecsa {
                     bool verify = true,
                     time_t timeout = 3);
 
+            /**
+             * Create single JSON-RPC over HTTP/HTTPS session runs on the shared io context.
+             * Session must be owned by std::shared_ptr and should be used through async_* interface,
+             * connection is established on the first exchange.
+             *
+             * @param ioc - io context shared by many sessions, caller runs it
+             * @param host - json-rpc host
+             * @param port - http/s port
+             * @param target - target path
+             * @param protocol - protocol, supported http or https
+             * @param verify - verify ssl certs
+             */
+            Session(boost::asio::io_context &ioc,
+                    const std::string &host,
+                    uint64_t port,
+                    const std::string &target,
+                    Url::protocol protocol,
+                    bool verify = true,
+                    time_t timeout = 3);
+
+            /**
+             * Queue asynchronous exchange. Exchanges of one session are written in order, up to pipeline depth
+             * requests are written before their responses are read. Connection is (re)established when it needs.
+             * @param exchange - prepared request and completion handler
+             */
+            void async_exchange(const std::shared_ptr<Exchange> &exchange);
+
+            /**
+             * Set HTTP/1.1 pipeline depth: how many requests are written before their responses are read.
+             * Depth 1 is the strict request/response mode, session falls back to it when node closes
+             * connection with pipelined requests.
+             * @param depth - pipeline depth
+             */
+            void set_pipeline_depth(size_t depth);
+
+            /**
+             * Get the current pipeline depth
+             * @return depth
+             */
+            size_t get_pipeline_depth() const { return pipeline_depth; }
+
+            /**
+             * Get count of network operations run by the synchronous calls,
+             * call served without it has not reached the node
+             * @return count
+             */
+            uint64_t get_operations() const { return operation; }
+
+            /**
+             * Get the session io context
+             * @return io context
+             */
+            boost::asio::io_context &get_io_context() { return ioc; }
+
 
             /**
              * Prepare rpc session connection
@@ -77,6 +250,13 @@ namespace milecsa {
              */
             bool connect(const milecsa::ErrorHandler &error);
 
+            /**
+             * Close the current connection and connect again
+             * @param error
+             * @return false in case when conection failed
+             */
+            bool reconnect(const milecsa::ErrorHandler &error);
+
             /**
              * Get the current uri target
              * @return string
@@ -99,7 +279,45 @@ namespace milecsa {
              * Get the current operations timeout
              * @return time
              */
-            time_t get_timeout() const { return timeout;}
+            std::chrono::milliseconds get_timeout() const;
+
+            /**
+             * Set timeout of every network operation
+             * @param timeout - operation timeout
+             */
+            void set_timeout(std::chrono::milliseconds timeout);
+
+            /**
+             * Derive operation timeouts from the observed latency, nullptr turns the fixed timeout back
+             * @param adaptive - latency estimator, it can be shared by sessions of the same node
+             */
+            void set_adaptive_timeout(const std::shared_ptr<rpc::AdaptiveTimeout> &adaptive);
+
+            /**
+             * Set response compression settings
+             * @param settings - compression settings
+             */
+            void set_compression(const Compression &settings);
+
+            /**
+             * Get response compression settings
+             * @return settings
+             */
+            Compression get_compression() const;
+
+            /**
+             * Set or erase Accept-Encoding of the request by the learned response size of the method or target
+             * @param fields - request header fields
+             * @param key - method or target
+             */
+            void prepare_encoding(boost::beast::http::fields &fields, const std::string &key) const;
+
+            /**
+             * Learn decoded response size of the method or target
+             * @param key - method or target
+             * @param res - read response
+             */
+            void observe_encoding(const std::string &key, const response &res) const;
 
             /**
              * Write request body
@@ -112,29 +330,19 @@ namespace milecsa {
             bool write(T &req,
                        const milecsa::ErrorHandler &error_handler){
 
-                boost::posix_time::time_duration tm = boost::posix_time::seconds(get_timeout());
-                boost::system::error_code ec = boost::asio::error::would_block;
-
-                deadline.expires_from_now(tm);
-
-                if (use_ssl) {
-                    boost::beast::http::async_write(*stream, req, [&ec](const boost::system::error_code& error, size_t){
-                        ec = error;
-                    });
-                } else {
-                    boost::beast::http::async_write(*socket, req, [&ec](const boost::system::error_code& error, size_t){
-                        ec = error;
-                    });
-                }
-
-                do ioc.run_one(); while (ec == boost::asio::error::would_block);
-
-                if (ec || !check_socket()) {
-                    error_handler(result::TIMEOUT, ErrorFormat("%s %s: %s:%s",
-                                                               "Sending request timeout",
-                                                               boost::system::system_error(
-                                                                       ec ? ec : boost::asio::error::operation_aborted).what(),
-                                                               host.c_str(), port.c_str()));
+                auto ec = run_operation([this, &req](const Completion &done){
+                    if (use_ssl)
+                        boost::beast::http::async_write(*stream, req, [done](const boost::system::error_code& error, size_t){
+                            done(error);
+                        });
+                    else
+                        boost::beast::http::async_write(*socket, req, [done](const boost::system::error_code& error, size_t){
+                            done(error);
+                        });
+                });
+
+                if (ec) {
+                    report_operation(ec, "Sending request timeout", error_handler);
                     return false;
                 }
 
@@ -151,33 +359,37 @@ namespace milecsa {
             template<typename T>
             bool read(T &response,
                       const milecsa::ErrorHandler &error_handler){
+                return read(response, read_buffer, error_handler);
+            }
 
-                boost::posix_time::time_duration tm = boost::posix_time::seconds(get_timeout());
-                boost::system::error_code ec = boost::asio::error::would_block;
-
-                boost::beast::flat_buffer buffer;
-
-                deadline.expires_from_now(tm);
-                ec = boost::asio::error::would_block;
-
-                if (use_ssl) {
-                    boost::beast::http::async_read(*stream, buffer, response, [&ec](const boost::system::error_code& error, size_t){
-                        ec = error;
-                    });
-                } else {
-                    boost::beast::http::async_read(*socket, buffer, response,  [&ec](const boost::system::error_code& error, size_t){
-                        ec = error;
-                    });
-                }
-
-                do ioc.run_one(); while (ec == boost::asio::error::would_block);
+            /**
+             * Read response keeping the rest of received data in the buffer, e.g. pipelined responses
+             * @tparam T
+             * @param response - response message
+             * @param buffer - read buffer is kept between reads
+             * @param error_handler
+             * @return true if operation is completed successfully
+             */
+            template<typename T>
+            bool read(T &response,
+                      boost::beast::flat_buffer &buffer,
+                      const milecsa::ErrorHandler &error_handler){
 
-                if (ec || !check_socket()) {
-                    error_handler(result::TIMEOUT, ErrorFormat("%s %s: %s:%s",
-                                                               "Reading response timeout",
-                                                               boost::system::system_error(
-                                                                       ec ? ec : boost::asio::error::operation_aborted).what(),
-                                                               host.c_str(), port.c_str()));
+                limit_body(response);
+
+                auto ec = run_operation([this, &buffer, &response](const Completion &done){
+                    if (use_ssl)
+                        boost::beast::http::async_read(*stream, buffer, response, [done](const boost::system::error_code& error, size_t){
+                            done(error);
+                        });
+                    else
+                        boost::beast::http::async_read(*socket, buffer, response, [done](const boost::system::error_code& error, size_t){
+                            done(error);
+                        });
+                });
+
+                if (ec) {
+                    report_operation(ec, "Reading response timeout", error_handler);
                     return false;
                 }
 
@@ -186,24 +398,119 @@ namespace milecsa {
 
             ~Session();
 
+        protected:
+
+            /**
+             * Limit decoded body of the response to be read by the compression settings
+             * @param res - response message
+             */
+            void limit_body(response &res) const;
+
+            template<typename T>
+            void limit_body(T &) const {}
+
+            /**
+             * Deadline and cancellation of the current blocking call
+             */
+            rpc::CallContext call_context;
+
+            /**
+             * Keep call context while blocking call is running, nested calls restore the outer one
+             */
+            class ContextScope {
+            public:
+                ContextScope(Session &session, const rpc::CallContext &context);
+                ~ContextScope();
+            private:
+                Session &session;
+                rpc::CallContext outer;
+            };
+
+            /**
+             * Add latency sample of the completed request to the adaptive estimator
+             * @param started - request writing start
+             */
+            void observe_latency(std::chrono::steady_clock::time_point started);
+
         private:
+
+            typedef std::function<void(const boost::system::error_code &ec)> Completion;
+
+            /**
+             * Start asynchronous operation and run the private io context until it completes.
+             * Socket is closed when operation timeout expires or the call is cancelled.
+             * @param start - operation starter, completion must be called once
+             * @param abort - stops operation does not run on the session socket
+             * @return operation error, timed_out or operation_aborted if socket has been closed
+             */
+            boost::system::error_code run_operation(const std::function<void(const Completion &done)> &start,
+                                                    const std::function<void()> &abort = nullptr);
+
+            void report_operation(const boost::system::error_code &ec,
+                                  const std::string &stage,
+                                  const milecsa::ErrorHandler &error_handler) const;
+
+            /**
+             * Resolve the session host through the DNS cache, waiting is bounded by the operation timeout
+             * and the call deadline and is abandoned when the call is cancelled
+             * @param ec - lookup error, timed_out or operation_aborted if the lookup has not completed
+             * @return endpoints
+             */
+            std::vector<tcp::endpoint> resolve(boost::system::error_code &ec) const;
+
             bool use_ssl;
             bool verify_ssl;
 
             const std::string host;
             const std::string port;
             const std::string target;
-            time_t timeout;
+            std::chrono::milliseconds timeout;
+            std::shared_ptr<rpc::AdaptiveTimeout> adaptive_timeout;
+
+            mutable std::mutex compression_mutex;
+            Compression compression;
+            mutable std::unordered_map<std::string, size_t> response_sizes;
 
-            boost::asio::io_context ioc;
+            std::unique_ptr<boost::asio::io_context> own_ioc;
+            boost::asio::io_context &ioc;
             tcp::socket   *socket;
             ssl::stream<tcp::socket> *stream;
 
-            boost::asio::deadline_timer deadline;
+            boost::asio::steady_timer deadline;
+            uint64_t operation;
+
+            boost::beast::flat_buffer read_buffer;
+
+            boost::asio::strand<boost::asio::io_context::executor_type> strand;
+            std::shared_ptr<detail::ParallelConnect> connecting;
+            boost::asio::steady_timer exchange_deadline;
+            boost::beast::flat_buffer exchange_buffer;
+            std::deque<std::shared_ptr<Exchange>> exchanges;
+            std::deque<std::shared_ptr<Exchange>> inflight;
+            size_t pipeline_depth;
+            bool opening;
+            bool writing;
+            bool reading;
+            bool connected;
 
             bool prepare();
-            void wait_deadline();
+            void reset();
             bool check_socket();
+            void close_socket();
+            tcp::socket &lowest_layer();
+            bool prepare_handshake();
+
+            void arm_exchange_deadline();
+            void async_open(const Exchange::Handler &done);
+            void next_exchange();
+            void write_exchange();
+            void read_exchange();
+            void watch_exchange(const std::shared_ptr<Exchange> &exchange);
+            void finish_exchange(const std::shared_ptr<Exchange> &exchange,
+                                 const boost::system::error_code &ec,
+                                 const std::string &stage);
+            void requeue_exchanges(const boost::system::error_code &ec, const std::string &stage);
+            void fail_exchanges(const boost::system::error_code &ec, const std::string &stage);
         };
     }
 
@@ -223,6 +530,17 @@ namespace milecsa {
          * Request as JSON body
          */
         typedef json request;
+
+        /**
+         * Asynchronous request completion handler
+         */
+        typedef std::function<void(const response &result)> ResultHandler;
+
+        /**
+         * Asynchronous request completion handler learns if the request has been written:
+         * failed written request could be executed by node
+         */
+        typedef std::function<void(const response &result, bool written)> DeliveryHandler;
     }
 
     namespace rpc {
@@ -267,6 +585,24 @@ namespace milecsa {
                            bool verify = true,
                            time_t timeout = 3);
 
+                /**
+                 * Create single JSON-RPC over HTTP/HTTPS session runs on the shared io context
+                 *
+                 * @param ioc - io context shared by many sessions, caller runs it
+                 * @param host - json-rpc host
+                 * @param port - http/s port
+                 * @param target - target path
+                 * @param protocol - protocol, supported http or https
+                 * @param verify - verify ssl certs
+                 */
+                RpcSession(boost::asio::io_context &ioc,
+                           const std::string &host,
+                           uint64_t port,
+                           const std::string &target,
+                           Url::protocol protocol,
+                           bool verify = true,
+                           time_t timeout = 3);
+
                 /**
                  * Prepare rpc session connection
                  * @param error
@@ -279,11 +615,112 @@ namespace milecsa {
                  * @param body - body of json repc request
                  * @param response_fail_handler - response fail handler
                  * @param error_handler - connection error handler
+                 * @param context - call deadline and cancellation
                  * @return response body
                  */
                 rpc::response request(const rpc::request &body,
                                       const http::ResponseHandler &response_fail_handler = http::default_response_handler,
-                                      const milecsa::ErrorHandler &error_handler = default_error_handler);
+                                      const milecsa::ErrorHandler &error_handler = default_error_handler,
+                                      const rpc::CallContext &context = {});
+
+                /**
+                 * Send JSON-RPC request and pass events of the result value to SAX handler,
+                 * the response DOM is not built
+                 * @param body - body of json repc request
+                 * @param sax - result value events handler, it can stop parsing when it has taken what it needs
+                 * @param response_fail_handler - response fail handler
+                 * @param error_handler - connection error handler
+                 * @param context - call deadline and cancellation
+                 * @return true if result is received
+                 */
+                bool request(const rpc::request &body,
+                             ResultSax &sax,
+                             const http::ResponseHandler &response_fail_handler = http::default_response_handler,
+                             const milecsa::ErrorHandler &error_handler = default_error_handler,
+                             const rpc::CallContext &context = {});
+
+                /**
+                 * Send JSON-RPC 2.0 batch request, responses are matched to commands by id.
+                 * If node does not support batches, i.e. replies 200 with not an array, idempotent
+                 * commands are sent one by one and the rest are reported as lost. Commands of
+                 * a failed HTTP status are passed to response_fail_handler and never sent again.
+                 * @param commands - commands are built by next_command
+                 * @param response_fail_handler - response fail handler
+                 * @param error_handler - connection error handler
+                 * @param context - call deadline and cancellation
+                 * @return responses in the order of commands, nullopt for failed commands
+                 */
+                std::vector<rpc::response> batch(const std::vector<rpc::request> &commands,
+                                                 const http::ResponseHandler &response_fail_handler = http::default_response_handler,
+                                                 const milecsa::ErrorHandler &error_handler = default_error_handler,
+                                                 const rpc::CallContext &context = {});
+
+                /**
+                 * Send JSON-RPC requests over HTTP/1.1 pipeline: up to pipeline depth requests are written
+                 * back to back and responses are read in order. If node closes connection the rest of
+                 * commands are sent in the strict request/response mode, not idempotent commands
+                 * are never sent twice.
+                 * @param commands - commands are built by next_command
+                 * @param response_fail_handler - response fail handler
+                 * @param error_handler - connection error handler
+                 * @param context - call deadline and cancellation
+                 * @return responses in the order of commands, nullopt for failed commands
+                 */
+                std::vector<rpc::response> pipeline(const std::vector<rpc::request> &commands,
+                                                    const http::ResponseHandler &response_fail_handler = http::default_response_handler,
+                                                    const milecsa::ErrorHandler &error_handler = default_error_handler,
+                                                    const rpc::CallContext &context = {});
+
+                /**
+                 * Command can be safely sent again
+                 * @param command - json-rpc command
+                 * @return true for ping and get-* methods
+                 */
+                static bool is_idempotent(const rpc::request &command);
+
+                /**
+                 * Method can be safely called again
+                 * @param method - json-rpc method name
+                 * @return true for ping and get-* methods
+                 */
+                static bool is_idempotent(const std::string &method);
+
+                /**
+                 * Send JSON-RPC request asynchronously, session must be owned by std::shared_ptr.
+                 * Handler is called from the thread runs session io context.
+                 * @param body - body of json repc request
+                 * @param handler - completion handler gets response body or nullopt
+                 * @param response_fail_handler - response fail handler
+                 * @param error_handler - connection error handler
+                 * @param context - request fails with timeout at the deadline, cancelled request
+                 *                  is abandoned and handler gets nullopt
+                 */
+                void async_request(const rpc::request &body,
+                                   const rpc::ResultHandler &handler,
+                                   const http::ResponseHandler &response_fail_handler = http::default_response_handler,
+                                   const milecsa::ErrorHandler &error_handler = default_error_handler,
+                                   const rpc::CallContext &context = {});
+
+                /**
+                 * Send JSON-RPC request asynchronously, handler learns if the request has been written
+                 * @see RpcSession::async_request
+                 */
+                void async_deliver(const rpc::request &body,
+                                   const rpc::DeliveryHandler &handler,
+                                   const http::ResponseHandler &response_fail_handler = http::default_response_handler,
+                                   const milecsa::ErrorHandler &error_handler = default_error_handler,
+                                   const rpc::CallContext &context = {});
+
+                /**
+                 * Send JSON-RPC request asynchronously, session must be owned by std::shared_ptr
+                 * @param body - body of json repc request
+                 * @param response_fail_handler - response fail handler
+                 * @param error_handler - connection error handler
+                 * @return future response body
+                 */
+                std::future<rpc::response> async_request(const rpc::request &body,
+                                                         const http::ResponseHandler &response_fail_handler = http::default_response_handler,
+                                                         const milecsa::ErrorHandler &error_handler = default_error_handler);
 
                 /**
                  * Get next command body with method and their parameters
@@ -294,6 +731,35 @@ namespace milecsa {
                 rpc::request next_command(const std::string &method, const rpc::request &params = {}) const;
 
                 ~RpcSession();
+
+            private:
+
+                void prepare_request(http::request &req, const rpc::request &body, http::BodyWriter &writer) const;
+
+                /**
+                 * Write request and read response reusing the session messages,
+                 * content of successful response is passed to the sink while it is read
+                 * @return response or nullptr if exchange failed
+                 */
+                const http::response *exchange(const rpc::request &body,
+                                               http::BodySink &sink,
+                                               const milecsa::ErrorHandler &error_handler);
+
+                http::request request_message;
+                http::response response_message;
+                http::BodyWriter body_writer;
+
+                milecsa::result scan_response(const rpc::request &body,
+                                              const http::response &res,
+                                              ResponseParser &parser,
+                                              const http::ResponseHandler &response_fail_handler,
+                                              const milecsa::ErrorHandler &error_handler) const;
+
+                rpc::response parse_response(const rpc::request &body,
+                                             const http::response &res,
+                                             DomResponse &response,
+                                             const http::ResponseHandler &response_fail_handler,
+                                             const milecsa::ErrorHandler &error_handler) const;
             };
         }
     }
@@ -0,0 +1,260 @@
+//
+// Created by lotus mile on 2026-10-17.
+//
+
+#pragma once
+
+#include <optional>
+#include <string>
+#include <vector>
+#include <initializer_list>
+
+#include "milecsa.hpp"
+#include "milecsa_rpc_sax.hpp"
+
+namespace milecsa::rpc {
+
+    /**
+     * Typed results of json-rpc calls. Structures are decoded from the response events,
+     * the response DOM is not built and uint256 fields are parsed once.
+     * Every structure declares the json-rpc method returns it, unknown response fields are skipped.
+     * @see Client::get
+     */
+
+    /**
+     * Result of get-current-block-id
+     */
+    struct CurrentBlockId {
+        static constexpr const char *method = "get-current-block-id";
+
+        std::optional<uint256_t> id;
+    };
+
+    /**
+     * Asset amount: wallet balance or transaction movement
+     */
+    struct Balance {
+        unsigned short asset_code = 0;
+        std::string amount;
+    };
+
+    /**
+     * Result of get-wallet-state
+     */
+    struct WalletState {
+        static constexpr const char *method = "get-wallet-state";
+
+        std::vector<Balance> balance;
+        std::string tags;
+        std::string node_address;
+        uint256_t last_transaction_id = 0;
+        bool exist = false;
+    };
+
+    /**
+     * Transaction of wallet history or block
+     */
+    struct Transaction {
+        std::string type;
+        uint256_t id = 0;
+        std::string from;
+        std::string to;
+        /**
+         * Moved assets: the flat asset-code and amount or every item of the asset array
+         */
+        std::vector<Balance> assets;
+        std::string fee;
+        std::string digest;
+        std::string status;
+    };
+
+    /**
+     * Result of get-wallet-transactions
+     */
+    struct WalletTransactions {
+        static constexpr const char *method = "get-wallet-transactions";
+
+        std::vector<Transaction> transactions;
+    };
+
+    /**
+     * Result of get-block-by-id
+     */
+    struct Block {
+        static constexpr const char *method = "get-block-by-id";
+
+        uint256_t id = 0;
+        std::string version;
+        std::string previous_block_digest;
+        std::string merkle_root;
+        std::string timestamp;
+        uint64_t transaction_count = 0;
+        std::vector<Transaction> transactions;
+    };
+
+    /**
+     * Asset supported by blockchain
+     */
+    struct AssetInfo {
+        unsigned short code = 0;
+        std::string name;
+    };
+
+    /**
+     * Result of get-blockchain-state
+     */
+    struct BlockchainState {
+        static constexpr const char *method = "get-blockchain-state";
+
+        std::string project;
+        std::string version;
+        uint256_t block_count = 0;
+        uint64_t node_count = 0;
+        uint64_t voting_transaction_count = 0;
+        uint64_t pending_transaction_count = 0;
+        std::string blockchain_state;
+        uint64_t consensus_round = 0;
+        std::vector<AssetInfo> supported_assets;
+    };
+
+    /**
+     * Consensus node
+     */
+    struct NodeInfo {
+        std::string public_key;
+        std::string address;
+        uint256_t node_id = 0;
+    };
+
+    /**
+     * Result of get-nodes
+     */
+    struct NodeList {
+        static constexpr const char *method = "get-nodes";
+
+        std::vector<NodeInfo> nodes;
+    };
+
+    /**
+     * Amounts are counted in fixed-width integers of amount_scale units
+     */
+    static const int64_t amount_scale = 100000;
+
+    /**
+     * Parse amount: "12.5" -> 1250000 of amount_scale units, extra fraction digits are truncated
+     * @param amount - amount string, [-]digits[.digits]
+     * @return amount_scale units, nullopt if amount is malformed or does not fit int64_t
+     */
+    std::optional<int64_t> parse_amount(const std::string &amount);
+
+    /**
+     * Decode get-current-block-id result got as json, e.g. from Client::async_request
+     * @param result - get-current-block-id result
+     * @return typed result, its id is nullopt if it is missed or is not a number
+     */
+    std::optional<CurrentBlockId> decode_current_block_id(const nlohmann::json &result);
+
+    /**
+     * Decode block got as json, e.g. from Client::get_block or BlockIterator
+     * @param block - get-block-by-id result
+     * @return typed block or nullopt
+     */
+    std::optional<Block> decode_block(const nlohmann::json &block);
+
+    namespace detail {
+
+        /**
+         * Location of the current value in the result: object keys, "[]" for array items
+         */
+        struct FieldPath {
+            const std::string *keys;
+            size_t size;
+
+            bool is(std::initializer_list<const char *> path) const;
+            bool starts_with(std::initializer_list<const char *> prefix) const;
+            FieldPath tail(size_t skip) const { return {keys + skip, size - skip}; }
+        };
+
+        /**
+         * Turn SAX events into object entries and scalar fields addressed by path,
+         * scalars are passed as text
+         */
+        class FieldSax: public ResultSax {
+
+        public:
+
+            bool null() override;
+            bool boolean(bool val) override;
+            bool number_integer(number_integer_t val) override;
+            bool number_unsigned(number_unsigned_t val) override;
+            bool number_float(number_float_t val, const string_t &s) override;
+            bool string(string_t &val) override;
+#ifdef MILECSA_JSON_SAX_BINARY
+            bool binary(binary_t &val) override;
+#endif
+            bool start_object(std::size_t elements) override;
+            bool key(string_t &val) override;
+            bool end_object() override;
+            bool start_array(std::size_t elements) override;
+            bool end_array() override;
+            bool parse_error(std::size_t position,
+                             const std::string &last_token,
+                             const nlohmann::detail::exception &ex) override;
+
+        protected:
+
+            /**
+             * Object begins at path, e.g. the next array item
+             */
+            virtual void object(const FieldPath &path) {}
+
+            /**
+             * Scalar value at path
+             */
+            virtual void field(const FieldPath &path, std::string &value) = 0;
+
+        private:
+
+            FieldPath current() const { return {path.data(), path.size()}; }
+
+            std::vector<std::string> path;
+            std::string text;
+        };
+
+        void decode_object(CurrentBlockId &value, const FieldPath &path);
+        void decode_field(CurrentBlockId &value, const FieldPath &path, std::string &text);
+
+        void decode_object(WalletState &value, const FieldPath &path);
+        void decode_field(WalletState &value, const FieldPath &path, std::string &text);
+
+        void decode_object(WalletTransactions &value, const FieldPath &path);
+        void decode_field(WalletTransactions &value, const FieldPath &path, std::string &text);
+
+        void decode_object(Block &value, const FieldPath &path);
+        void decode_field(Block &value, const FieldPath &path, std::string &text);
+
+        void decode_object(BlockchainState &value, const FieldPath &path);
+        void decode_field(BlockchainState &value, const FieldPath &path, std::string &text);
+
+        void decode_object(NodeList &value, const FieldPath &path);
+        void decode_field(NodeList &value, const FieldPath &path, std::string &text);
+
+        /**
+         * Decode typed result
+         * @tparam T - result structure
+         */
+        template <typename T>
+        class TypedSax: public FieldSax {
+
+        public:
+
+            T value;
+
+        protected:
+
+            void object(const FieldPath &path) override { decode_object(value, path); }
+
+            void field(const FieldPath &path, std::string &text) override { decode_field(value, path, text); }
+        };
+    }
+}
@@ -0,0 +1,79 @@
+//
+// Created by lotus mile on 2026-10-17.
+//
+
+#pragma once
+
+#include <string>
+#include <memory>
+#include <boost/asio/ssl/context.hpp>
+
+namespace milecsa::http {
+
+    namespace detail { class TlsState; }
+
+    /**
+     * Singleton TLS client context shared by all sessions.
+     *
+     * Trust store is loaded once. Sessions and tickets issued by nodes are cached per host and port,
+     * reconnects and additional connections to the same node resume them with an abbreviated handshake.
+     * Session which fails handshake is dropped from the cache.
+     */
+    class TlsContext {
+
+    public:
+
+        /**
+         * Handshakes statistic
+         */
+        struct Stat {
+            uint64_t handshakes;
+            uint64_t resumed;
+        };
+
+        static TlsContext& Instance();
+
+        /**
+         * Get the shared context, new ssl streams are created with it
+         * @return ssl context
+         */
+        boost::asio::ssl::context &get();
+
+        /**
+         * Turn session resumption on or off, it is on by default
+         * @param enable - resume cached sessions
+         */
+        void set_resumption(bool enable);
+
+        /**
+         * Set server name and cached session of the node before handshake
+         * @param ssl - ssl connection
+         * @param host - node host
+         * @param port - node port
+         * @return false if server name is not set
+         */
+        bool prepare(SSL *ssl, const std::string &host, const std::string &port);
+
+        /**
+         * Account completed handshake, failed one drops the cached session of the node
+         * @param ssl - ssl connection
+         * @param host - node host
+         * @param port - node port
+         * @param ec - handshake error
+         */
+        void handshaken(SSL *ssl, const std::string &host, const std::string &port, const boost::system::error_code &ec);
+
+        /**
+         * Get handshakes statistic
+         * @return full and resumed handshakes
+         */
+        Stat get_stat() const;
+
+    private:
+
+        TlsContext();
+        ~TlsContext();
+
+        std::unique_ptr<detail::TlsState> state;
+    };
+}
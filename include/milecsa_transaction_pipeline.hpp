@@ -0,0 +1,166 @@
+//
+// Created by lotus mile on 2026-10-17.
+//
+
+#pragma once
+
+#include <optional>
+#include <functional>
+#include <future>
+#include <string>
+#include <memory>
+
+#include "milecsa.hpp"
+#include "milecsa_error.hpp"
+#include "milecsa_concurrent_client.hpp"
+
+namespace milecsa::rpc {
+
+    namespace detail { class PipelineState; }
+
+    /**
+     * Transfers are signed and submitted in parallel.
+     *
+     * Signer threads create transfer requests while previously signed bodies are sent, at most
+     * window requests are in flight over connections of the concurrent client. Results are delivered
+     * in submission or completion order. Copies share the same pipeline, the last copy waits
+     * for all submitted transfers are completed.
+     */
+    class TransactionPipeline {
+
+    public:
+
+        /**
+         * Order results are delivered in
+         */
+        enum class Order {
+            submission,
+            completion
+        };
+
+        /**
+         * Transfer to be signed and sent
+         */
+        struct Transfer {
+            milecsa::keys::Pair pair;
+            std::string to;
+            unsigned short asset_code;
+            float amount;
+            float fee;
+            std::string description;
+        };
+
+        /**
+         * Transfer result handler, called from io threads or from signer threads if signing fails,
+         * handler must not submit transfers or wait for the pipeline
+         * @param sequence - sequence number returned by submit
+         * @param result - send-transaction response or nullopt
+         */
+        typedef std::function<void(size_t sequence, const response &result)> CompletionHandler;
+
+        /**
+         * Transfer result handler learns if a failed transaction could have reached the node
+         * @param sequence - sequence number returned by submit
+         * @param result - send-transaction response or nullopt
+         * @param written - request has been written, failed transaction could be accepted by node
+         */
+        typedef std::function<void(size_t sequence, const response &result, bool written)> DeliveryHandler;
+
+        /**
+         * Start pipeline
+         * @param client - client submits transfers, its block id tracker is used if it is set
+         * @param signers - signer threads, 0 is one thread per core
+         * @param window - requests are in flight, submit blocks when as many transfers are waiting to be signed
+         * @param order - results delivering order
+         * @param error_handler - signing error handler
+         * @return optional TransactionPipeline object, nullopt if the current block id can't be got
+         */
+        static std::optional<TransactionPipeline> Start(
+                const ConcurrentClient &client,
+                size_t signers = 0,
+                size_t window = 64,
+                Order order = Order::submission,
+                const ErrorHandler &error_handler = default_error_handler);
+
+        /**
+         * Start pipeline for transactions are signed offline, the current block id is not fetched
+         * @param client - client sends transactions
+         * @param window - requests are in flight, broadcast blocks when as many transactions are waiting
+         * @param order - results delivering order
+         * @param error_handler - error handler
+         * @return TransactionPipeline object
+         */
+        static TransactionPipeline StartBroadcast(
+                const ConcurrentClient &client,
+                size_t window = 64,
+                Order order = Order::submission,
+                const ErrorHandler &error_handler = default_error_handler);
+
+        TransactionPipeline(const TransactionPipeline &pipeline);
+
+        ~TransactionPipeline();
+
+        /**
+         * Submit transfer
+         * @param transfer - transfer
+         * @param handler - result handler
+         * @return sequence number of the transfer
+         */
+        size_t submit(const Transfer &transfer, const CompletionHandler &handler);
+
+        /**
+         * Submit transfer
+         * @param transfer - transfer
+         * @return future send-transaction response
+         */
+        std::future<response> submit(const Transfer &transfer);
+
+        /**
+         * Submit transfer
+         * @param transfer - transfer
+         * @param handler - result handler learns if the transaction has been written
+         * @return sequence number of the transfer
+         */
+        size_t submit(const Transfer &transfer, const DeliveryHandler &handler);
+
+        /**
+         * Submit transaction is signed offline, it is sent as is
+         * @param body - signed transaction body
+         * @param handler - result handler
+         * @return sequence number of the transaction
+         */
+        size_t broadcast(const json &body, const CompletionHandler &handler);
+
+        /**
+         * Submit transaction is signed offline, it is sent as is
+         * @param body - signed transaction body
+         * @param handler - result handler learns if the transaction has been written
+         * @return sequence number of the transaction
+         */
+        size_t broadcast(const json &body, const DeliveryHandler &handler);
+
+        /**
+         * Sign transfer, the pipeline signers use it
+         * @param transfer - transfer
+         * @param block_id - current block id
+         * @param error_handler - signing error handler
+         * @return signed transaction body or nullopt
+         */
+        static std::optional<json> Sign(const Transfer &transfer,
+                                        const uint256_t &block_id,
+                                        const ErrorHandler &error_handler = default_error_handler);
+
+        /**
+         * Wait until results of all submitted transfers are delivered
+         */
+        void wait() const;
+
+        TransactionPipeline& operator=(const TransactionPipeline&);
+
+    private:
+
+        TransactionPipeline(const std::shared_ptr<detail::PipelineState> &state);
+
+        std::shared_ptr<detail::PipelineState> state;
+    };
+}
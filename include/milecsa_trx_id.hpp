@@ -0,0 +1,79 @@
+//
+// Created by lotus mile on 2026-10-17.
+//
+
+#pragma once
+
+#include <string>
+#include <memory>
+
+#include "milecsa.hpp"
+#include "milecsa_error.hpp"
+
+namespace milecsa::rpc {
+
+    namespace detail { class TrxIdState; }
+
+    /**
+     * Singleton transaction id allocator, ids are monotonic per wallet and can be taken from any thread.
+     *
+     * Every wallet has its own atomic counter, threads keep their own lookup of wallet counters,
+     * so an id costs one atomic increment. Counter starts from the current time in microseconds,
+     * ids keep growing across restarts unless more than a million per second are taken.
+     * High-water marks can be persisted, then counters start above the marks of the previous run.
+     */
+    class TrxIdAllocator {
+
+    public:
+
+        /**
+         * Ids are reserved by persisted high-water mark, the mark file is rewritten once per step
+         */
+        static uint64_t reserve_step;
+
+        static TrxIdAllocator& Instance();
+
+        /**
+         * Get next transaction id of wallet
+         * @param public_key - wallet public key
+         * @return next id
+         */
+        uint64_t get_next(const std::string &public_key);
+
+        /**
+         * Get next transaction id of wallet
+         * @param pair - wallet keys pair
+         * @return next id
+         */
+        uint64_t get_next(const milecsa::keys::Pair &pair);
+
+        /**
+         * Move wallet counter past the known transaction id, e.g. last-transaction-id of wallet state
+         * @param public_key - wallet public key
+         * @param id - known transaction id
+         */
+        void seed(const std::string &public_key, uint64_t id);
+
+        /**
+         * Persist high-water marks, marks of the previous run are loaded from the file
+         * @param path - high-water mark file
+         * @param error_handler - persistence error handler, called from the thread takes id
+         * @return false if the existing file can't be read
+         */
+        bool persist(const std::string &path, const ErrorHandler &error_handler = default_error_handler);
+
+        TrxIdAllocator(TrxIdAllocator const&) = delete;
+        TrxIdAllocator(TrxIdAllocator&&) = delete;
+        TrxIdAllocator& operator=(TrxIdAllocator const&) = delete;
+        TrxIdAllocator& operator=(TrxIdAllocator &&) = delete;
+
+    protected:
+
+        TrxIdAllocator();
+        ~TrxIdAllocator();
+
+    private:
+
+        std::unique_ptr<detail::TrxIdState> state;
+    };
+}
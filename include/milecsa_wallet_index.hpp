@@ -0,0 +1,130 @@
+//
+// Created by lotus mile on 2026-10-17.
+//
+
+#pragma once
+
+#include <optional>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <limits>
+
+#include "milecsa.hpp"
+#include "milecsa_error.hpp"
+#include "milecsa_rpc_types.hpp"
+#include "milecsa_concurrent_client.hpp"
+
+namespace milecsa::rpc {
+
+    namespace detail { class WalletIndexState; }
+
+    /**
+     * Local wallet history index built from synced blocks.
+     *
+     * Transactions of ingested blocks are appended to the transactions segment, the postings file
+     * maps wallet public key to the block, the transaction offset in the block, the transaction
+     * record and the balance delta. Postings are loaded into memory on open, so history and
+     * balance delta queries do not touch the network. Blocks are ingested strictly in order.
+     * The checkpoint is written every few hundred blocks and on flush, files are truncated
+     * to the checkpoint on open, so blocks after it are ingested again.
+     * Index can be shared by many threads of one process, copies share the same files.
+     */
+    class WalletIndex {
+
+    public:
+
+        /**
+         * Indexed transaction
+         */
+        struct Entry {
+            uint256_t block_id = 0;
+            uint32_t offset = 0;
+            Transaction transaction;
+        };
+
+        /**
+         * Open or create wallet index
+         * @param directory - index directory, it is created if it does not exist
+         * @param error_handler - index error handler
+         * @return optional WalletIndex object
+         */
+        static std::optional<WalletIndex> Open(
+                const std::string &directory,
+                const ErrorHandler &error_handler = default_error_handler);
+
+        WalletIndex(const WalletIndex &index);
+
+        ~WalletIndex();
+
+        /**
+         * Ingest block, blocks before get_next_block are skipped
+         * @param block - block, its id must be equal to get_next_block
+         * @return false if block can't be ingested
+         */
+        bool add(const Block &block) const;
+
+        /**
+         * Ingest blocks from get_next_block up to the last one
+         * @param clients - clients of one or more nodes
+         * @param last - the last block id, the current one of the first client if it is not set
+         * @param window - initial read-ahead window
+         * @return false if sync is stopped before the last block
+         */
+        bool sync(const std::vector<ConcurrentClient> &clients,
+                  const std::optional<uint256_t> &last = std::nullopt,
+                  size_t window = 16) const;
+
+        /**
+         * Get id of the block is expected by the next add
+         * @return block id
+         */
+        uint256_t get_next_block() const;
+
+        /**
+         * Get wallet history, the latest transactions first
+         * @param public_key - wallet public key
+         * @param limit - max entries
+         * @param first - the first block id
+         * @param last - the last block id, inclusive
+         * @return indexed transactions
+         */
+        std::vector<Entry> get_history(const std::string &public_key,
+                                       size_t limit = std::numeric_limits<size_t>::max(),
+                                       const uint256_t &first = 0,
+                                       const uint256_t &last = std::numeric_limits<uint64_t>::max()) const;
+
+        /**
+         * Get wallet balance change over the block range, fees are charged to the sender,
+         * only transfer and emission amounts are counted
+         * @param public_key - wallet public key
+         * @param first - the first block id
+         * @param last - the last block id, inclusive
+         * @return amount_scale units by asset code
+         */
+        std::map<unsigned short, int64_t> get_balance_delta(const std::string &public_key,
+                                                            const uint256_t &first = 0,
+                                                            const uint256_t &last = std::numeric_limits<uint64_t>::max()) const;
+
+        /**
+         * Get wallet transactions count
+         * @param public_key - wallet public key
+         * @return count
+         */
+        size_t count(const std::string &public_key) const;
+
+        /**
+         * Flush segment and postings to disk
+         */
+        void flush() const;
+
+        WalletIndex& operator=(const WalletIndex&);
+
+    private:
+
+        WalletIndex(const std::shared_ptr<detail::WalletIndexState> &state);
+
+        std::shared_ptr<detail::WalletIndexState> state;
+    };
+}
@@ -0,0 +1,487 @@
+//
+// Created by lotus mile on 2026-10-17.
+//
+#include <optional>
+#include <functional>
+#include <fstream>
+#include <filesystem>
+#include <unordered_map>
+#include <vector>
+#include "milecsa.hpp"
+#include "milecsa_jsonrpc.hpp"
+#include "milecsa_concurrent_client.hpp"
+#include "milecsa_block_iterator.hpp"
+#include <boost/program_options.hpp>
+#include <zlib.h>
+
+///
+/// Columnar export file, all integers are little-endian:
+///
+///   file      := "MILECOL1" u32:version u64:amount_scale group*
+///   group     := "RGRP" u64:first_block u64:last_block u32:columns column*
+///   column    := u16:name_size name u8:type u32:rows u64:raw_size u64:compressed_size zlib(data)
+///
+/// Column types: 0 - u64, 1 - i64, 2 - u32, 3 - u16, 4 - strings: u32:size bytes.
+/// Columns named block.* have row per block, tx.* - row per transaction, transfer.* - row per asset
+/// moved by a transaction, transfer.tx is the transaction row in the group. Dictionaries of the group:
+/// keys - public keys referenced by tx.from and tx.to, types - transaction types referenced by tx.type.
+/// Amounts are fixed-width integers of amount_scale units.
+///
+
+static std::vector<std::string> opt_urls = {"http://lotus000.testnet.mile.global/v1/api"};
+static std::string opt_output = "";
+static std::string opt_first = "0";
+static std::string opt_last = "";
+static size_t opt_group_size = 1024;
+static size_t opt_connections = 4;
+static int opt_compression = Z_DEFAULT_COMPRESSION;
+
+static const uint32_t format_version = 2;
+using milecsa::rpc::amount_scale;
+using milecsa::rpc::parse_amount;
+
+namespace po = boost::program_options;
+
+static bool parse_cmdline(int ac, char *av[]);
+
+enum class ColumnType: uint8_t {
+    u64 = 0,
+    i64 = 1,
+    u32 = 2,
+    u16 = 3,
+    strings = 4
+};
+
+template <typename T>
+static inline void put(std::string &data, T value) {
+    for (size_t i = 0; i < sizeof(T); ++i)
+        data.push_back(static_cast<char>((static_cast<uint64_t>(value) >> (8 * i)) & 0xff));
+}
+
+struct Column {
+    std::string name;
+    ColumnType type;
+    uint32_t rows = 0;
+    std::string data;
+
+    Column(const std::string &name, ColumnType type): name(name), type(type) {}
+
+    template <typename T>
+    void add(T value) {
+        put(data, value);
+        ++rows;
+    }
+
+    void add(const std::string &value) {
+        put(data, static_cast<uint32_t>(value.size()));
+        data += value;
+        ++rows;
+    }
+};
+
+class Group {
+
+public:
+
+    Group():
+            block_id("block.id", ColumnType::u64),
+            block_timestamp("block.timestamp", ColumnType::strings),
+            block_transaction_count("block.transaction_count", ColumnType::u32),
+            block_previous_digest("block.previous_block_digest", ColumnType::strings),
+            block_merkle_root("block.merkle_root", ColumnType::strings),
+            tx_block_id("tx.block_id", ColumnType::u64),
+            tx_id("tx.id", ColumnType::u64),
+            tx_type("tx.type", ColumnType::u32),
+            tx_from("tx.from", ColumnType::u32),
+            tx_to("tx.to", ColumnType::u32),
+            tx_fee("tx.fee", ColumnType::i64),
+            tx_digest("tx.digest", ColumnType::strings),
+            transfer_tx("transfer.tx", ColumnType::u32),
+            transfer_asset_code("transfer.asset_code", ColumnType::u16),
+            transfer_amount("transfer.amount", ColumnType::i64),
+            keys("keys", ColumnType::strings),
+            types("types", ColumnType::strings) {}
+
+    /**
+     * Amounts are checked before any column is written, a malformed one fails the block,
+     * a transaction without fee is charged nothing
+     */
+    bool add(const milecsa::rpc::Block &block) {
+
+        std::vector<int64_t> amounts;
+        std::vector<int64_t> fees;
+
+        for (auto &tx: block.transactions) {
+            for (auto &asset: tx.assets) {
+                auto amount = parse_amount(asset.amount);
+                if (!amount)
+                    return false;
+                amounts.push_back(*amount);
+            }
+            auto fee = tx.fee.empty() ? std::optional<int64_t>(0) : parse_amount(tx.fee);
+            if (!fee)
+                return false;
+            fees.push_back(*fee);
+        }
+
+        auto id = static_cast<uint64_t>(block.id);
+
+        if (block_id.rows == 0)
+            first = id;
+        last = id;
+
+        block_id.add(id);
+        block_timestamp.add(block.timestamp);
+        block_transaction_count.add(static_cast<uint32_t>(block.transactions.size()));
+        block_previous_digest.add(block.previous_block_digest);
+        block_merkle_root.add(block.merkle_root);
+
+        auto amount = amounts.begin();
+        auto fee = fees.begin();
+
+        for (auto &tx: block.transactions) {
+
+            for (auto &asset: tx.assets) {
+                transfer_tx.add(tx_id.rows);
+                transfer_asset_code.add(asset.asset_code);
+                transfer_amount.add(*amount++);
+            }
+
+            tx_block_id.add(id);
+            tx_id.add(static_cast<uint64_t>(tx.id));
+            tx_type.add(lookup(type_index, types, tx.type));
+            tx_from.add(lookup(key_index, keys, tx.from));
+            tx_to.add(lookup(key_index, keys, tx.to));
+            tx_fee.add(*fee++);
+            tx_digest.add(tx.digest);
+        }
+
+        return true;
+    }
+
+    bool empty() const { return block_id.rows == 0; }
+
+    uint64_t get_last() const { return last; }
+
+    bool write(std::ostream &out) const {
+
+        std::string header = "RGRP";
+        put(header, first);
+        put(header, last);
+
+        auto columns = all();
+        put(header, static_cast<uint32_t>(columns.size()));
+        out.write(header.data(), header.size());
+
+        for (auto column: columns) {
+
+            auto bound = compressBound(column->data.size());
+            std::string compressed(bound, '\0');
+
+            if (compress2(reinterpret_cast<Bytef *>(&compressed[0]), &bound,
+                          reinterpret_cast<const Bytef *>(column->data.data()), column->data.size(),
+                          opt_compression) != Z_OK) {
+                std::cerr << "Column " << column->name << " can't be compressed" << std::endl;
+                return false;
+            }
+            compressed.resize(bound);
+
+            std::string meta;
+            put(meta, static_cast<uint16_t>(column->name.size()));
+            meta += column->name;
+            put(meta, static_cast<uint8_t>(column->type));
+            put(meta, column->rows);
+            put(meta, static_cast<uint64_t>(column->data.size()));
+            put(meta, static_cast<uint64_t>(compressed.size()));
+
+            out.write(meta.data(), meta.size());
+            out.write(compressed.data(), compressed.size());
+        }
+
+        return static_cast<bool>(out);
+    }
+
+private:
+
+    static uint32_t lookup(std::unordered_map<std::string, uint32_t> &index, Column &dictionary, const std::string &value) {
+        auto it = index.find(value);
+        if (it != index.end())
+            return it->second;
+        auto position = dictionary.rows;
+        dictionary.add(value);
+        index.emplace(value, position);
+        return position;
+    }
+
+    std::vector<const Column *> all() const {
+        return {&block_id, &block_timestamp, &block_transaction_count, &block_previous_digest, &block_merkle_root,
+                &tx_block_id, &tx_id, &tx_type, &tx_from, &tx_to, &tx_fee, &tx_digest,
+                &transfer_tx, &transfer_asset_code, &transfer_amount,
+                &keys, &types};
+    }
+
+    uint64_t first = 0;
+    uint64_t last = 0;
+
+    Column block_id;
+    Column block_timestamp;
+    Column block_transaction_count;
+    Column block_previous_digest;
+    Column block_merkle_root;
+
+    Column tx_block_id;
+    Column tx_id;
+    Column tx_type;
+    Column tx_from;
+    Column tx_to;
+    Column tx_fee;
+    Column tx_digest;
+
+    Column transfer_tx;
+    Column transfer_asset_code;
+    Column transfer_amount;
+
+    Column keys;
+    Column types;
+
+    std::unordered_map<std::string, uint32_t> key_index;
+    std::unordered_map<std::string, uint32_t> type_index;
+};
+
+///
+/// Checkpoint: the next block id and the output size after the last complete group
+///
+struct Checkpoint {
+    uint64_t next_block = 0;
+    uint64_t size = 0;
+
+    static std::optional<Checkpoint> Read(const std::string &path) {
+        std::ifstream file(path);
+        Checkpoint checkpoint;
+        if (file >> checkpoint.next_block >> checkpoint.size)
+            return checkpoint;
+        return std::nullopt;
+    }
+
+    bool write(const std::string &path) const {
+        auto temp = path + ".tmp";
+        {
+            std::ofstream file(temp, std::ios::trunc);
+            file << next_block << " " << size << "\n";
+            if (!file.flush())
+                return false;
+        }
+        std::error_code ec;
+        std::filesystem::rename(temp, path, ec);
+        return !ec;
+    }
+};
+
+int main(int argc, char *argv[]) {
+
+    setlocale(LC_ALL, "");
+
+    if (!parse_cmdline(argc, argv))
+        return 1;
+
+    milecsa::http::ResponseHandler response_fail_handler = [](
+            const milecsa::http::status code,
+            const std::string &method,
+            const milecsa::http::response &http){
+        std::cerr << "Response["<<code<<"] "<<method<<" error: " << http.result() << std::endl << http << std::endl;
+    };
+
+    milecsa::ErrorHandler error_handler = [](
+            milecsa::result code,
+            const std::string &error){
+        std::cerr << "Export error: " << error << std::endl;
+    };
+
+    std::vector<milecsa::rpc::ConcurrentClient> nodes;
+
+    for (auto &url: opt_urls) {
+        if (auto rpc = milecsa::rpc::ConcurrentClient::Connect(url, opt_connections, 8, 1, true, response_fail_handler, error_handler))
+            nodes.push_back(*rpc);
+    }
+
+    if (nodes.empty())
+        return 1;
+
+    uint256_t first = 0, last = 0;
+
+    if (!StringToUInt256(opt_first, first, false)) {
+        std::cerr << "First block id " << opt_first << " is not valid" << std::endl;
+        return 1;
+    }
+
+    if (!opt_last.empty()) {
+        if (!StringToUInt256(opt_last, last, false)) {
+            std::cerr << "Last block id " << opt_last << " is not valid" << std::endl;
+            return 1;
+        }
+    }
+    else if (auto current = nodes.front().get_current_block_id())
+        last = *current;
+    else
+        return 1;
+
+    auto checkpoint_path = opt_output + ".checkpoint";
+    auto checkpoint = Checkpoint::Read(checkpoint_path);
+
+    std::fstream out;
+
+    if (checkpoint && std::filesystem::exists(opt_output)) {
+        //
+        // torn group after the checkpoint is dropped
+        //
+        std::filesystem::resize_file(opt_output, checkpoint->size);
+        out.open(opt_output, std::ios::in | std::ios::out | std::ios::binary);
+
+        std::string header(12, '\0');
+        std::string expected = "MILECOL1";
+        put(expected, format_version);
+        if (!out.read(&header[0], header.size()) || header != expected) {
+            std::cerr << "Output " << opt_output << " is written in another format version, it can't be resumed" << std::endl;
+            return 1;
+        }
+        out.seekp(0, std::ios::end);
+        first = checkpoint->next_block;
+        std::cout << "Resume from block " << checkpoint->next_block << std::endl;
+    }
+    else {
+        out.open(opt_output, std::ios::out | std::ios::binary | std::ios::trunc);
+        std::string header = "MILECOL1";
+        put(header, format_version);
+        put(header, static_cast<uint64_t>(amount_scale));
+        out.write(header.data(), header.size());
+        checkpoint = Checkpoint{static_cast<uint64_t>(first), static_cast<uint64_t>(header.size())};
+    }
+
+    if (!out) {
+        std::cerr << "Output " << opt_output << " can't be written" << std::endl;
+        return 1;
+    }
+
+    if (first > last) {
+        std::cout << "Nothing to export" << std::endl;
+        return 0;
+    }
+
+    auto blocks = milecsa::rpc::BlockIterator::Start(nodes, first, last, 16, error_handler);
+    if (!blocks)
+        return 1;
+
+    Group group;
+    size_t exported = 0;
+
+    auto flush = [&]{
+        if (!group.write(out) || !out.flush())
+            return false;
+        checkpoint->next_block = group.get_last() + 1;
+        checkpoint->size = static_cast<uint64_t>(out.tellp());
+        if (!checkpoint->write(checkpoint_path)) {
+            std::cerr << "Checkpoint " << checkpoint_path << " can't be written" << std::endl;
+            return false;
+        }
+        group = Group();
+        return true;
+    };
+
+    while (auto json = blocks->next()) {
+
+        auto block = milecsa::rpc::decode_block(*json);
+        if (!block) {
+            std::cerr << "Block " << UInt256ToDecString(blocks->get_position() - 1) << " can't be decoded" << std::endl;
+            return 1;
+        }
+
+        if (!group.add(*block)) {
+            std::cerr << "Block " << UInt256ToDecString(blocks->get_position() - 1) << " has a malformed amount" << std::endl;
+            return 1;
+        }
+
+        if (++exported % opt_group_size == 0 && !flush())
+            return 1;
+    }
+
+    if (!group.empty() && !flush())
+        return 1;
+
+    if (blocks->get_position() <= last) {
+        std::cerr << "Export is stopped at block " << UInt256ToDecString(blocks->get_position()) << ", run again to resume" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Blocks exported: " << exported << std::endl;
+
+    return 0;
+}
+
+static bool parse_cmdline(int ac, char *av[]) {
+
+    try {
+
+        po::options_description desc("Allowed options");
+
+        desc.add_options()
+                ("help", "produce help message")
+
+                ("debug", "print debug messages")
+
+                ("url,u", po::value<std::vector<std::string>>(&opt_urls)->
+                         default_value(opt_urls, opt_urls.front()),
+                 "RPC url, can be repeated to read from several nodes")
+
+                ("output,o", po::value<std::string>(&opt_output),
+                 "columnar output file, export is resumed if its checkpoint exists")
+
+                ("first,f", po::value<std::string>(&opt_first)->
+                         default_value(opt_first),
+                 "the first block id")
+
+                ("last,l", po::value<std::string>(&opt_last),
+                 "the last block id, current one if it is not set")
+
+                ("group-size,g", po::value<size_t>(&opt_group_size)->
+                         default_value(opt_group_size),
+                 "blocks per column group")
+
+                ("connections,c", po::value<size_t>(&opt_connections)->
+                         default_value(opt_connections),
+                 "connections are opened to every node")
+
+                ("compression,z", po::value<int>(&opt_compression)->
+                         default_value(opt_compression),
+                 "zlib compression level")
+                ;
+
+        po::variables_map vm;
+        po::store(po::parse_command_line(ac, av, desc), vm);
+        po::notify(vm);
+
+        if (vm.count("help") || opt_output.empty()) {
+            std::cout << desc << "\n";
+            exit(0);
+        }
+
+        if (opt_group_size == 0) {
+            std::cerr << "error: group size must be positive" << "\n";
+            return false;
+        }
+
+        if (vm.count("debug")) {
+            milecsa::rpc::detail::RpcSession::debug_on = true;
+        }
+    }
+
+    catch (std::exception &e) {
+        std::cerr << "error: " << e.what() << "\n";
+        return false;
+    }
+    catch (...) {
+        std::cerr << "Exception of unknown type!\n";
+        return false;
+    }
+
+    return true;
+}
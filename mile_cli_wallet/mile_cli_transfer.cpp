@@ -3,8 +3,17 @@
 //
 #include <optional>
 #include <functional>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <set>
+#include <mutex>
+#include <atomic>
 #include "milecsa.hpp"
 #include "milecsa_jsonrpc.hpp"
+#include "milecsa_concurrent_client.hpp"
+#include "milecsa_transaction_pipeline.hpp"
+#include "milecsa_trx_id.hpp"
 #include <boost/program_options.hpp>
 #include <termios.h>
 
@@ -19,12 +28,428 @@ static std::string opt_memo = "";
 static int opt_reconnections = 3;
 static bool opt_test = false;
 static time_t opt_timeout = 3;
+static std::string opt_payouts = "";
+static std::string opt_journal = "";
+static bool opt_resume = false;
+static bool opt_force = false;
+static size_t opt_concurrency = 16;
+static size_t opt_connections = 4;
+static std::string opt_sign = "";
+static std::string opt_broadcast = "";
+static std::string opt_block_id = "";
 
 namespace po = boost::program_options;
 
 static bool parse_cmdline(int ac, char *av[]);
 ssize_t getpasswd (std::string &pwd, size_t sz, int mask, FILE *fp);
 
+///
+/// Payout is read from the line of CSV: to,asset,amount,memo or NDJSON: {"to":..., "asset":..., "amount":..., "memo":...}
+///
+struct Payout {
+    size_t line;
+    std::string to;
+    unsigned short asset_code;
+    float amount;
+    std::string memo;
+};
+
+static bool is_blank(const std::string &text) {
+    auto begin = text.find_first_not_of(" \t\r");
+    return begin == std::string::npos || text[begin] == '#';
+}
+
+static std::optional<Payout> parse_payout(size_t line, const std::string &text) {
+    try {
+        if (text[text.find_first_not_of(" \t\r")] == '{') {
+            auto json = nlohmann::json::parse(text);
+            return Payout{
+                    line,
+                    json.at("to").get<std::string>(),
+                    json.at("asset").get<unsigned short>(),
+                    json.at("amount").get<float>(),
+                    json.value("memo", "")};
+        }
+
+        std::istringstream fields(text);
+        std::string to, asset, amount, memo;
+        std::getline(fields, to, ',');
+        std::getline(fields, asset, ',');
+        std::getline(fields, amount, ',');
+        std::getline(fields, memo);
+        if (!memo.empty() && memo.back() == '\r')
+            memo.pop_back();
+
+        return Payout{line, to, static_cast<unsigned short>(std::stoul(asset)), std::stof(amount), memo};
+    }
+    catch (...) {
+        return std::nullopt;
+    }
+}
+
+static bool read_payouts(const std::string &path, std::vector<Payout> &payouts) {
+
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Payouts " << path << " can't be read" << std::endl;
+        return false;
+    }
+
+    std::string text;
+    for (size_t line = 1; std::getline(file, text); ++line) {
+        if (is_blank(text))
+            continue;
+        if (auto payout = parse_payout(line, text))
+            payouts.push_back(*payout);
+        else if (line > 1)
+            //
+            // the first line can be CSV header
+            //
+            std::cerr << "Payouts " << path << ":" << line << " is skipped: " << text << std::endl;
+    }
+
+    return true;
+}
+
+///
+/// Journal is NDJSON: pending record is written before payout is submitted, result record
+/// when it is completed: sent, failed-before-send if the request has not been written,
+/// unknown if it has been written but no result is received. Only failed-before-send payouts
+/// are resent on resume, pending and unknown ones could have been accepted and must be checked by hand.
+///
+static void read_journal(const std::string &path, std::set<size_t> &done) {
+
+    std::ifstream file(path);
+    std::set<size_t> pending;
+    std::string text;
+
+    while (std::getline(file, text)) {
+        try {
+            auto record = nlohmann::json::parse(text);
+            auto line = record.at("line").get<size_t>();
+            auto status = record.at("status").get<std::string>();
+            if (status == "sent") {
+                pending.erase(line);
+                done.insert(line);
+            }
+            else if (status == "failed-before-send")
+                pending.erase(line);
+            else
+                //
+                // pending, unknown and failed records of the earlier journals are in doubt
+                //
+                pending.insert(line);
+        }
+        catch (...) {
+            //
+            // torn tail of the journal
+            //
+        }
+    }
+
+    for (auto line: pending) {
+        std::cerr << "Payout at line " << line << " has been sent without result, check it and remove from payouts" << std::endl;
+        done.insert(line);
+    }
+}
+
+///
+/// Journal of the earlier run is never overwritten silently: payouts it has sent would be sent again
+///
+static bool check_journal(const std::string &source) {
+
+    if (opt_journal.empty())
+        opt_journal = source + ".journal";
+
+    if (opt_resume || opt_force)
+        return true;
+
+    if (std::ifstream(opt_journal)) {
+        std::cerr << "error: journal " << opt_journal
+                  << " exists, use --resume to continue the payouts or --force to send them all again" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+///
+/// Journal records are written from io threads
+///
+struct Journal {
+    std::ofstream file;
+    std::mutex mutex;
+
+    Journal(const std::string &path, bool append): file(path, append ? std::ios::app : std::ios::trunc) {}
+
+    void write(size_t line, const std::string &status, const milecsa::rpc::response &result, nlohmann::json record = {}) {
+        record["line"] = line;
+        record["status"] = status;
+        if (result)
+            record["result"] = *result;
+        std::lock_guard<std::mutex> lock(mutex);
+        file << record.dump() << std::endl;
+    }
+
+    static const char *status(const milecsa::rpc::response &result, bool written) {
+        if (result)
+            return "sent";
+        return written ? "unknown" : "failed-before-send";
+    }
+};
+
+///
+/// Signed transactions are broadcast without fetching the current block id
+///
+static std::optional<milecsa::rpc::TransactionPipeline> start_pipeline(
+        bool sign,
+        const milecsa::http::ResponseHandler &response_fail_handler,
+        const milecsa::ErrorHandler &error_handler) {
+
+    auto rpc = milecsa::rpc::ConcurrentClient::Connect(
+            opt_mile_node_address,
+            opt_connections,
+            std::max<size_t>(opt_concurrency / std::max<size_t>(opt_connections, 1), 1),
+            1,
+            true,
+            response_fail_handler,
+            error_handler);
+
+    if (!rpc)
+        return std::nullopt;
+
+    if (!sign)
+        return milecsa::rpc::TransactionPipeline::StartBroadcast(
+                *rpc,
+                opt_concurrency,
+                milecsa::rpc::TransactionPipeline::Order::completion,
+                error_handler);
+
+    return milecsa::rpc::TransactionPipeline::Start(
+            *rpc,
+            0,
+            opt_concurrency,
+            milecsa::rpc::TransactionPipeline::Order::completion,
+            error_handler);
+}
+
+static int send_payouts(const milecsa::keys::Pair &pair,
+                        const milecsa::http::ResponseHandler &response_fail_handler,
+                        const milecsa::ErrorHandler &error_handler) {
+
+    std::vector<Payout> payouts;
+    if (!read_payouts(opt_payouts, payouts))
+        return 1;
+
+    std::set<size_t> done;
+    if (opt_resume)
+        read_journal(opt_journal, done);
+
+    Journal journal(opt_journal, opt_resume);
+    if (!journal.file) {
+        std::cerr << "Journal " << opt_journal << " can't be written" << std::endl;
+        return 1;
+    }
+
+    milecsa::rpc::TrxIdAllocator::Instance().persist(opt_journal + ".trx-id", error_handler);
+
+    auto pipeline = start_pipeline(true, response_fail_handler, error_handler);
+    if (!pipeline)
+        return 1;
+
+    std::atomic<size_t> sent(0), failed(0), unknown(0);
+
+    for (auto &payout: payouts) {
+
+        if (done.count(payout.line) > 0)
+            continue;
+
+        nlohmann::json record = {{"to", payout.to}, {"amount", payout.amount}};
+
+        journal.write(payout.line, "pending", std::nullopt, record);
+
+        pipeline->submit({pair, payout.to, payout.asset_code, payout.amount, 0.0, payout.memo},
+                         [&, payout, record](size_t, const milecsa::rpc::response &result, bool written){
+                             journal.write(payout.line, Journal::status(result, written), result, record);
+                             if (result)
+                                 ++sent;
+                             else if (written)
+                                 ++unknown;
+                             else
+                                 ++failed;
+                         });
+    }
+
+    pipeline->wait();
+
+    std::cout << "Payouts sent: " << sent << " failed: " << failed << " unknown: " << unknown
+              << " skipped: " << done.size() << std::endl;
+
+    return failed + unknown > 0 ? 1 : 0;
+}
+
+///
+/// Payouts are signed by chunks: every chunk is signed in parallel and written in order
+///
+static int sign_payouts(const milecsa::keys::Pair &pair,
+                        const milecsa::http::ResponseHandler &response_fail_handler,
+                        const milecsa::ErrorHandler &error_handler) {
+
+    std::vector<Payout> payouts;
+    if (!read_payouts(opt_payouts, payouts))
+        return 1;
+
+    uint256_t block_id = 0;
+
+    if (!opt_block_id.empty()) {
+        if (!StringToUInt256(opt_block_id, block_id, false)) {
+            std::cerr << "Block id " << opt_block_id << " is not valid" << std::endl;
+            return 1;
+        }
+    }
+    else if (auto rpc = milecsa::rpc::Client::Connect(opt_mile_node_address, true, response_fail_handler, error_handler)) {
+        if (auto id = rpc->get_current_block_id())
+            block_id = *id;
+        else
+            return 1;
+    }
+    else
+        return 1;
+
+    std::ofstream file(opt_sign, std::ios::trunc);
+    if (!file) {
+        std::cerr << "Signed transactions " << opt_sign << " can't be written" << std::endl;
+        return 1;
+    }
+
+    //
+    // ids of the next signing run must not repeat these ones
+    //
+    milecsa::rpc::TrxIdAllocator::Instance().persist(opt_sign + ".trx-id", error_handler);
+
+    const size_t chunk = 4096;
+    size_t threads = std::max<unsigned>(std::thread::hardware_concurrency(), 1);
+    size_t failed = 0;
+
+    std::vector<std::optional<nlohmann::json>> bodies;
+
+    for (size_t offset = 0; offset < payouts.size(); offset += chunk) {
+
+        auto count = std::min(chunk, payouts.size() - offset);
+        bodies.assign(count, std::nullopt);
+
+        std::atomic<size_t> next(0);
+        std::vector<std::thread> signers;
+
+        for (size_t i = 0; i < threads; ++i) {
+            signers.emplace_back([&]{
+                for (size_t index; (index = next.fetch_add(1)) < count;) {
+                    auto &payout = payouts[offset + index];
+                    bodies[index] = milecsa::rpc::TransactionPipeline::Sign(
+                            {pair, payout.to, payout.asset_code, payout.amount, 0.0, payout.memo},
+                            block_id,
+                            error_handler);
+                }
+            });
+        }
+
+        for (auto &signer: signers)
+            signer.join();
+
+        for (size_t index = 0; index < count; ++index) {
+            auto &payout = payouts[offset + index];
+            if (!bodies[index]) {
+                std::cerr << "Payout at line " << payout.line << " can't be signed" << std::endl;
+                ++failed;
+                continue;
+            }
+            nlohmann::json record = {{"line", payout.line}, {"to", payout.to}, {"amount", payout.amount}, {"body", *bodies[index]}};
+            file << record.dump() << "\n";
+        }
+    }
+
+    if (!file.flush()) {
+        std::cerr << "Signed transactions " << opt_sign << " can't be written" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Payouts signed: " << payouts.size() - failed << " failed: " << failed << std::endl;
+
+    return failed > 0 ? 1 : 0;
+}
+
+///
+/// Signed transactions file is streamed: lines are read as the in-flight window frees
+///
+static int broadcast_signed(const milecsa::http::ResponseHandler &response_fail_handler,
+                            const milecsa::ErrorHandler &error_handler) {
+
+    std::ifstream file(opt_broadcast);
+    if (!file) {
+        std::cerr << "Signed transactions " << opt_broadcast << " can't be read" << std::endl;
+        return 1;
+    }
+
+    std::set<size_t> done;
+    if (opt_resume)
+        read_journal(opt_journal, done);
+
+    Journal journal(opt_journal, opt_resume);
+    if (!journal.file) {
+        std::cerr << "Journal " << opt_journal << " can't be written" << std::endl;
+        return 1;
+    }
+
+    auto pipeline = start_pipeline(false, response_fail_handler, error_handler);
+    if (!pipeline)
+        return 1;
+
+    std::atomic<size_t> sent(0), failed(0), unknown(0);
+    size_t skipped = 0;
+    std::string text;
+
+    for (size_t line = 1; std::getline(file, text); ++line) {
+
+        if (is_blank(text))
+            continue;
+
+        if (done.count(line) > 0) {
+            ++skipped;
+            continue;
+        }
+
+        nlohmann::json body;
+        try {
+            body = nlohmann::json::parse(text).at("body");
+        }
+        catch (...) {
+            std::cerr << "Signed transactions " << opt_broadcast << ":" << line << " is not valid" << std::endl;
+            journal.write(line, "failed-before-send", std::nullopt);
+            ++failed;
+            continue;
+        }
+
+        journal.write(line, "pending", std::nullopt);
+
+        pipeline->broadcast(body, [&, line](size_t, const milecsa::rpc::response &result, bool written){
+            journal.write(line, Journal::status(result, written), result);
+            if (result)
+                ++sent;
+            else if (written)
+                ++unknown;
+            else
+                ++failed;
+        });
+    }
+
+    pipeline->wait();
+
+    std::cout << "Transactions sent: " << sent << " failed: " << failed << " unknown: " << unknown
+              << " skipped: " << skipped << std::endl;
+
+    return failed + unknown > 0 ? 1 : 0;
+}
+
 int main(int argc, char *argv[]) {
 
     setlocale(LC_ALL, "");
@@ -32,6 +457,33 @@ int main(int argc, char *argv[]) {
     if (!parse_cmdline(argc, argv))
         return 1;
 
+    std::atomic<milecsa::result> last_error(milecsa::result::OK);
+
+    milecsa::http::ResponseHandler response_fail_handler = [](
+            const milecsa::http::status code,
+            const std::string &method,
+            const milecsa::http::response &http){
+        std::cerr << "Response["<<code<<"] "<<method<<" error: " << http.result() << std::endl << http << std::endl;
+    };
+
+    milecsa::ErrorHandler error_handler = [&](
+            milecsa::result code,
+            const std::string &error){
+        std::cerr << "Call error: " << error << std::endl;
+
+        if (opt_test) {
+            exit(-1);
+        }
+
+        last_error = code;
+    };
+
+    ///
+    /// signed transactions are broadcast without private key
+    ///
+    if (!opt_broadcast.empty())
+        return broadcast_signed(response_fail_handler, error_handler);
+
     bool is_valid = false;
 
     if (opt_private.empty()){
@@ -57,10 +509,17 @@ int main(int argc, char *argv[]) {
         exit(-1);
     }
 
-    milecsa::http::ResponseHandler response_fail_handler;
-    milecsa::ErrorHandler error_handler;
-
     auto ppk = milecsa::keys::Pair::FromPrivateKey(opt_private,error_handler);
+
+    if (!ppk)
+        return 1;
+
+    if (!opt_sign.empty())
+        return sign_payouts(*ppk, response_fail_handler, error_handler);
+
+    if (!opt_payouts.empty())
+        return send_payouts(*ppk, response_fail_handler, error_handler);
+
     using transfer = milecsa::transaction::Transfer<nlohmann::json>;
 
     auto do_request = [&]{
@@ -77,10 +536,10 @@ int main(int argc, char *argv[]) {
             auto block_id = rpc->get_current_block_id();
 
             if(!block_id)
-                return;
+                return false;
 
             auto asset = milecsa::assets::TokenFromCode(opt_asset_code);
-            uint64_t trx_id = rand();
+            uint64_t trx_id = milecsa::rpc::TrxIdAllocator::Instance().get_next(*ppk);
 
             auto request =
                     transfer::CreateRequest(
@@ -99,7 +558,7 @@ int main(int argc, char *argv[]) {
 
                 if (opt_test) {
                     std::cout << request->dump() << std::endl;
-                    return;
+                    return true;
                 }
 
                 auto json_body = request->dump();
@@ -107,35 +566,29 @@ int main(int argc, char *argv[]) {
                 if(auto t = rpc->send_transaction(*ppk,*request)){
                     std::cout<< "Send transfer: ";
                     std::cout << t->dump() << std::endl;;
+                    return true;
                 }
             }
         }
+        return false;
     };
 
-    response_fail_handler = [](
-            const milecsa::http::status code,
-            const std::string &method,
-            const milecsa::http::response &http){
-        std::cerr << "Response["<<code<<"] "<<method<<" error: " << http.result() << std::endl << http << std::endl;
-    };
+    ///
+    /// only connection failures are retried: the transfer could have been accepted on other errors
+    ///
+    for (int reconnections = 0; ; ++reconnections) {
 
-    int reconnections=0;
-    error_handler = [&](
-            milecsa::result code,
-            const std::string &error){
-        std::cerr << "Call ["<<reconnections<<"] error: " << error << std::endl;
+        last_error = milecsa::result::OK;
 
-        if ((++reconnections >= opt_reconnections) || opt_test) {
-            exit(-1);
-        }
+        if (do_request())
+            return 0;
 
-        if (code == milecsa::result::FAIL) {
-            std::this_thread::sleep_for(std::chrono::seconds(opt_timeout));
-            do_request();
-        }
-    };
+        if (last_error != milecsa::result::FAIL || reconnections + 1 >= opt_reconnections)
+            return -1;
 
-    do_request();
+        std::cerr << "Reconnect [" << reconnections + 1 << "]" << std::endl;
+        std::this_thread::sleep_for(std::chrono::seconds(opt_timeout));
+    }
 }
 
 
@@ -248,6 +701,33 @@ static bool parse_cmdline(int ac, char *av[]) {
                 ("reconnections,r", po::value<int>(&opt_reconnections)->
                          default_value(opt_reconnections),
                  "try to connect again reconnection times if any connection error occurred")
+
+                ("payouts,f", po::value<std::string>(&opt_payouts),
+                 "send transfers listed in CSV (to,asset,amount,memo) or NDJSON file")
+
+                ("journal,j", po::value<std::string>(&opt_journal),
+                 "payouts results journal, default is payouts file name with .journal suffix")
+
+                ("resume", "skip payouts are sent or could have been sent according to the journal, resend the failed ones")
+
+                ("force", "overwrite the journal of the earlier run and send all payouts again")
+
+                ("concurrency,n", po::value<size_t>(&opt_concurrency)->
+                         default_value(opt_concurrency),
+                 "payouts are in flight")
+
+                ("connections", po::value<size_t>(&opt_connections)->
+                         default_value(opt_connections),
+                 "connections are opened to send payouts")
+
+                ("sign,s", po::value<std::string>(&opt_sign),
+                 "sign payouts offline into NDJSON file instead of sending them")
+
+                ("block-id", po::value<std::string>(&opt_block_id),
+                 "block id payouts are signed with offline, current one is requested from the node if it is not set")
+
+                ("broadcast,b", po::value<std::string>(&opt_broadcast),
+                 "send transactions signed offline from NDJSON file")
                 ;
 
         po::variables_map vm;
@@ -273,19 +753,50 @@ static bool parse_cmdline(int ac, char *av[]) {
             exit(0);
         }
 
-        if (opt_to.empty()) {
-            std::cout << desc << "\n";
-            exit(0);
+        if (vm.count("resume")) {
+            opt_resume = true;
         }
 
-        if (opt_asset_code==100){
-            std::cout << desc << "\n";
-            exit(0);
+        if (vm.count("force")) {
+            opt_force = true;
         }
 
-        if (opt_amount <= 0 ){
-            std::cout << desc << "\n";
-            exit(0);
+        if (opt_resume && opt_force) {
+            std::cerr << "error: resume and force can't be used together" << "\n";
+            return false;
+        }
+
+        if ((!opt_payouts.empty() || !opt_broadcast.empty()) && vm.count("test")) {
+            std::cerr << "error: test mode can't be used with payouts" << "\n";
+            return false;
+        }
+
+        if (!opt_sign.empty() && opt_payouts.empty()) {
+            std::cerr << "error: payouts must be set to sign them" << "\n";
+            return false;
+        }
+
+        if (!opt_broadcast.empty() && !check_journal(opt_broadcast))
+            return false;
+
+        if (!opt_payouts.empty() && opt_sign.empty() && !check_journal(opt_payouts))
+            return false;
+
+        if (opt_payouts.empty() && opt_broadcast.empty()) {
+            if (opt_to.empty()) {
+                std::cout << desc << "\n";
+                exit(0);
+            }
+
+            if (opt_asset_code==100){
+                std::cout << desc << "\n";
+                exit(0);
+            }
+
+            if (opt_amount <= 0 ){
+                std::cout << desc << "\n";
+                exit(0);
+            }
         }
 
         if (vm.count("debug")) {
@@ -47,24 +47,20 @@ int main(int argc, char *argv[]) {
 
                 auto result = rpc->call(opt_method,params);
 
-                if (!result.has_value()) {
+                if (!milecsa::rpc::has_result(result)) {
                     std::cerr << "Rpc error: response does not have any result"<< std::endl;
                     exit(-1);
                 }
 
                 std::cout<< "Call " << opt_method << ": ";
 
-                if (result.type() == typeid(time_t))
-                    std::cout << std::any_cast<time_t>(result);
-
-
-                else if (result.type() == typeid(uint256_t)){
-                    std::cout << std::any_cast<uint256_t>(result);
-                }
-
-                else if (result.type() == typeid(milecsa::rpc::response)){
-                    std::cout << std::any_cast<milecsa::rpc::response>(result)->dump();
-                }
+                std::visit([](auto &&value){
+                    using T = std::decay_t<decltype(value)>;
+                    if constexpr (std::is_same_v<T, nlohmann::json>)
+                        std::cout << value.dump();
+                    else if constexpr (!std::is_same_v<T, std::monostate>)
+                        std::cout << value;
+                }, result);
 
                 std::cout << std::endl;
             }
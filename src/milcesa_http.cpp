@@ -22,14 +22,18 @@ namespace milecsa::http {
             req.set(boost::beast::http::field::host, session->get_host());
             req.set(boost::beast::http::field::user_agent, user_agent);
 
+            session->prepare_encoding(req, session->get_target());
+
             if (!session->write(req,error_handler))
                 return std::nullopt;
 
-            boost::beast::http::response<boost::beast::http::string_body> res;
+            http::response res;
 
             if (!session->read(res,error_handler))
                 return std::nullopt;
 
+            session->observe_encoding(session->get_target(), res);
+
             auto status = res.result();
 
             if (status == boost::beast::http::status::ok) {
@@ -50,6 +54,10 @@ namespace milecsa::http {
     }
 
 
+    void Client::set_compression(const Compression &settings) {
+        session->set_compression(settings);
+    }
+
     Client& Client::operator = (const Client& client) {
         url_ = client.url_;
         verify_ssl_=client.verify_ssl_;
@@ -0,0 +1,205 @@
+//
+// Created by lotus mile on 2026-10-17.
+//
+
+#include "milecsa_block_id_tracker.hpp"
+#include "milecsa_jsonrpc.hpp"
+
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace milecsa::rpc::detail {
+
+    typedef std::chrono::steady_clock clock;
+
+    static const size_t block_id_words = 4;
+
+    class TrackerState {
+
+    public:
+
+        TrackerState(const Client &client, std::chrono::milliseconds interval):
+                client(client),
+                interval(interval),
+                sequence(0),
+                updated_at(0),
+                stopped(false),
+                wakeup(false) {
+            for (auto &word: words)
+                word.store(0, std::memory_order_relaxed);
+        }
+
+        ~TrackerState() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopped = true;
+            }
+            changed.notify_all();
+            if (thread.joinable())
+                thread.join();
+        }
+
+        /**
+         * Single writer: the tracker thread
+         */
+        void publish(const uint256_t &id) {
+            auto seq = sequence.load(std::memory_order_relaxed);
+            sequence.store(seq + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+
+            for (size_t i = 0; i < block_id_words; ++i)
+                words[i].store(static_cast<uint64_t>(id >> (64 * i)), std::memory_order_relaxed);
+            updated_at.store(clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+
+            sequence.store(seq + 2, std::memory_order_release);
+        }
+
+        std::pair<uint256_t, clock::time_point> read() const {
+            uint64_t copy[block_id_words];
+            clock::rep at;
+            uint64_t before, after;
+
+            do {
+                before = sequence.load(std::memory_order_acquire);
+                for (size_t i = 0; i < block_id_words; ++i)
+                    copy[i] = words[i].load(std::memory_order_relaxed);
+                at = updated_at.load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                after = sequence.load(std::memory_order_relaxed);
+            } while (before != after || (before & 1) != 0);
+
+            uint256_t id = 0;
+            for (size_t i = block_id_words; i-- > 0;) {
+                id <<= 64;
+                id |= copy[i];
+            }
+
+            return {id, clock::time_point(clock::duration(at))};
+        }
+
+        bool poll() {
+            auto id = client.get_current_block_id();
+            if (!id)
+                return false;
+
+            auto known = read();
+            publish(*id);
+
+            if (*id != known.first) {
+                std::lock_guard<std::mutex> lock(mutex);
+                changed.notify_all();
+            }
+
+            return true;
+        }
+
+        void run() {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (!stopped) {
+                changed.wait_for(lock, interval, [this]{ return stopped || wakeup; });
+                if (stopped)
+                    break;
+                wakeup = false;
+                lock.unlock();
+                poll();
+                lock.lock();
+            }
+        }
+
+        Client client;
+        const std::chrono::milliseconds interval;
+
+        std::atomic<uint64_t> sequence;
+        std::atomic<uint64_t> words[block_id_words];
+        std::atomic<clock::rep> updated_at;
+
+        std::mutex mutex;
+        std::condition_variable changed;
+        bool stopped;
+        bool wakeup;
+
+        std::thread thread;
+    };
+}
+
+namespace milecsa::rpc {
+
+    std::chrono::milliseconds BlockIdTracker::max_staleness = std::chrono::seconds(10);
+
+    BlockIdTracker::BlockIdTracker(const std::shared_ptr<detail::TrackerState> &state): state(state) {}
+
+    BlockIdTracker::BlockIdTracker(const BlockIdTracker &tracker): state(tracker.state) {}
+
+    BlockIdTracker& BlockIdTracker::operator = (const BlockIdTracker& tracker) {
+        state = tracker.state;
+        return *this;
+    }
+
+    BlockIdTracker::~BlockIdTracker(){
+        state.reset();
+    }
+
+    std::optional<BlockIdTracker> BlockIdTracker::Start(
+            const std::string &urlString,
+            std::chrono::milliseconds interval,
+            bool verify_ssl,
+            const http::ResponseHandler &response_fail_handler,
+            const milecsa::ErrorHandler &error_handler) {
+
+        //
+        // tracker has its own connection: sync client calls must not be shared between threads
+        //
+        auto client = Client::Connect(urlString, verify_ssl, response_fail_handler, error_handler);
+        if (!client)
+            return std::nullopt;
+
+        auto state = std::make_shared<detail::TrackerState>(*client, interval);
+
+        if (!state->poll())
+            return std::nullopt;
+
+        auto raw = state.get();
+        state->thread = std::thread([raw]{ raw->run(); });
+
+        return BlockIdTracker(state);
+    }
+
+    std::optional<uint256_t> BlockIdTracker::get() const {
+        return get(max_staleness);
+    }
+
+    std::optional<uint256_t> BlockIdTracker::get(std::chrono::milliseconds staleness) const {
+        auto current = state->read();
+        if (detail::clock::now() - current.second > staleness) {
+            refresh();
+            return std::nullopt;
+        }
+        return current.first;
+    }
+
+    std::chrono::milliseconds BlockIdTracker::get_age() const {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(detail::clock::now() - state->read().second);
+    }
+
+    void BlockIdTracker::refresh() const {
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->wakeup = true;
+        }
+        state->changed.notify_all();
+    }
+
+    std::optional<uint256_t> BlockIdTracker::wait_next(const uint256_t &id, std::chrono::milliseconds timeout) const {
+        std::unique_lock<std::mutex> lock(state->mutex);
+        uint256_t current = id;
+        auto next = state->changed.wait_for(lock, timeout, [&]{
+            current = state->read().first;
+            return state->stopped || current != id;
+        });
+        if (!next || current == id)
+            return std::nullopt;
+        return current;
+    }
+}
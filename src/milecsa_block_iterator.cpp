@@ -0,0 +1,255 @@
+//
+// Created by lotus mile on 2026-10-17.
+//
+
+#include "milecsa_block_iterator.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <deque>
+
+namespace milecsa::rpc::detail {
+
+    typedef std::chrono::steady_clock clock;
+
+    /**
+     * Latency baseline is the minimum of this many last samples
+     */
+    static const size_t baseline_samples = 64;
+
+    class IteratorState {
+
+    public:
+
+        IteratorState(const std::vector<ConcurrentClient> &clients,
+                      const uint256_t &first,
+                      const uint256_t &last,
+                      size_t window,
+                      const ErrorHandler &error_handler):
+                clients(clients),
+                next_client(0),
+                head(first),
+                issued(first),
+                last(last),
+                capacity(std::max<size_t>(BlockIterator::max_window, 1)),
+                window(std::clamp<size_t>(window, std::max<size_t>(BlockIterator::min_window, 1), capacity)),
+                ring(capacity),
+                in_flight(0),
+                failed(false),
+                latency(0),
+                since_shrink(0),
+                error_handler(error_handler) {}
+
+        ~IteratorState() {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [this]{ return in_flight == 0; });
+        }
+
+        /**
+         * Called under mutex, ids are requested after the mutex is released:
+         * block kept locally is received before request returns
+         */
+        std::vector<uint256_t> fill() {
+            std::vector<uint256_t> ids;
+            while (!failed && issued <= last && issued - head < window) {
+                ids.push_back(issued++);
+                ++in_flight;
+            }
+            return ids;
+        }
+
+        void request(const std::vector<uint256_t> &ids) {
+            for (auto &id: ids)
+                request(id, 0);
+        }
+
+        void request(const uint256_t &id, size_t attempt) {
+            auto &client = clients[next_client.fetch_add(1, std::memory_order_relaxed) % clients.size()];
+            auto &node = client.next();
+
+            //
+            // blocks kept in the cache or the store tell nothing of the node latency
+            //
+            if (auto block = node.find_block(id)) {
+                received(id, attempt, std::nullopt, block);
+                return;
+            }
+
+            auto start = clock::now();
+            node.async_get_block(id, [this, id, attempt, start](const response &block){
+                received(id, attempt, start, block);
+            });
+        }
+
+        void received(const uint256_t &id, size_t attempt, std::optional<clock::time_point> start, const response &block) {
+
+            std::unique_lock<std::mutex> lock(mutex);
+
+            if (!block) {
+                if (!failed && attempt + 1 < BlockIterator::max_attempts) {
+                    lock.unlock();
+                    request(id, attempt + 1);
+                    return;
+                }
+                if (!failed) {
+                    failed = true;
+                    error_handler(result::FAIL, ErrorFormat("block %s can't be got", UInt256ToDecString(id).c_str()));
+                }
+                --in_flight;
+                changed.notify_all();
+                return;
+            }
+
+            if (start)
+                adapt(std::chrono::duration<double, std::milli>(clock::now() - *start).count());
+
+            ring[slot(id)] = block;
+            --in_flight;
+            changed.notify_all();
+        }
+
+        /**
+         * Latency rising over the minimum of the recent samples means the nodes are saturated,
+         * the baseline follows the nodes when their latency changes for good
+         */
+        void adapt(double sample) {
+            sample = std::max(sample, 1.0);
+            recent.push_back(sample);
+            if (recent.size() > baseline_samples)
+                recent.pop_front();
+            auto min_latency = *std::min_element(recent.begin(), recent.end());
+            latency = latency == 0 ? sample : latency * 0.8 + sample * 0.2;
+            if (++since_shrink >= window && latency > 2 * min_latency) {
+                window = std::max<size_t>(std::max<size_t>(BlockIterator::min_window, 1), window * 3 / 4);
+                since_shrink = 0;
+            }
+        }
+
+        size_t slot(const uint256_t &id) const {
+            return static_cast<size_t>(id % capacity);
+        }
+
+        response next() {
+
+            std::unique_lock<std::mutex> lock(mutex);
+
+            if (failed || head > last)
+                return std::nullopt;
+
+            auto &block = ring[slot(head)];
+
+            if (!block) {
+                //
+                // consumer waits: read-ahead is too short
+                //
+                window = std::min(window + 1, capacity);
+                auto ids = fill();
+                lock.unlock();
+                request(ids);
+                lock.lock();
+                changed.wait(lock, [this, &block]{ return block || failed; });
+                if (!block)
+                    return std::nullopt;
+            }
+
+            response result;
+            std::swap(result, block);
+            ++head;
+
+            auto ids = fill();
+            lock.unlock();
+            request(ids);
+
+            return result;
+        }
+
+        std::vector<ConcurrentClient> clients;
+        std::atomic<size_t> next_client;
+
+        uint256_t head;
+        uint256_t issued;
+        const uint256_t last;
+
+        const size_t capacity;
+        size_t window;
+        std::vector<response> ring;
+        size_t in_flight;
+        bool failed;
+
+        std::deque<double> recent;
+        double latency;
+        size_t since_shrink;
+
+        const ErrorHandler error_handler;
+
+        mutable std::mutex mutex;
+        std::condition_variable changed;
+    };
+}
+
+namespace milecsa::rpc {
+
+    size_t BlockIterator::min_window = 4;
+    size_t BlockIterator::max_window = 256;
+    size_t BlockIterator::max_attempts = 3;
+
+    BlockIterator::BlockIterator(const std::shared_ptr<detail::IteratorState> &state): state(state) {}
+
+    BlockIterator::BlockIterator(const BlockIterator &iterator): state(iterator.state) {}
+
+    BlockIterator& BlockIterator::operator = (const BlockIterator& iterator) {
+        state = iterator.state;
+        return *this;
+    }
+
+    BlockIterator::~BlockIterator(){
+        state.reset();
+    }
+
+    std::optional<BlockIterator> BlockIterator::Start(
+            const std::vector<ConcurrentClient> &clients,
+            const uint256_t &first,
+            const uint256_t &last,
+            size_t window,
+            const milecsa::ErrorHandler &error_handler) {
+
+        if (clients.empty()) {
+            error_handler(result::FAIL, ErrorFormat("block iterator has no clients"));
+            return std::nullopt;
+        }
+
+        if (first > last) {
+            error_handler(result::FAIL, ErrorFormat("block range %s-%s is empty",
+                                                    UInt256ToDecString(first).c_str(),
+                                                    UInt256ToDecString(last).c_str()));
+            return std::nullopt;
+        }
+
+        auto state = std::make_shared<detail::IteratorState>(clients, first, last, window, error_handler);
+
+        std::vector<uint256_t> ids;
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            ids = state->fill();
+        }
+        state->request(ids);
+
+        return BlockIterator(state);
+    }
+
+    response BlockIterator::next() {
+        return state->next();
+    }
+
+    uint256_t BlockIterator::get_position() const {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        return state->head;
+    }
+
+    size_t BlockIterator::get_window() const {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        return state->window;
+    }
+}
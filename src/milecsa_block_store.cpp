@@ -0,0 +1,315 @@
+//
+// Created by lotus mile on 2026-10-17.
+//
+
+#include "milecsa_block_store.hpp"
+
+#include <fstream>
+#include <filesystem>
+#include <shared_mutex>
+#include <atomic>
+#include <mutex>
+#include <limits>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+namespace milecsa::rpc::detail {
+
+    namespace fs = std::filesystem;
+    namespace bip = boost::interprocess;
+
+    /**
+     * Segment record: 4 bytes little-endian length of the CBOR block following it.
+     * Index entry: segment offset of the record + 1, zero means the block is not stored.
+     */
+    static const size_t record_header_size = sizeof(uint32_t);
+    static const uint64_t index_min_capacity = 64 * 1024;
+
+    class BlockStoreState {
+
+    public:
+
+        BlockStoreState(const std::string &directory, const ErrorHandler &error_handler):
+                segment_path(fs::path(directory) / "blocks.segment"),
+                index_path(fs::path(directory) / "blocks.index"),
+                segment_size(0),
+                index_capacity(0),
+                count(0),
+                error_handler(error_handler){}
+
+        bool open() {
+            try {
+                fs::create_directories(segment_path.parent_path());
+
+                segment.open(segment_path, std::ios::binary | std::ios::app);
+                if (!segment) {
+                    error_handler(result::FAIL, ErrorFormat("Block store segment %s can't be opened", segment_path.c_str()));
+                    return false;
+                }
+                segment_size = fs::file_size(segment_path);
+
+                if (!fs::exists(index_path))
+                    std::ofstream(index_path, std::ios::binary);
+
+                if (!map_index(std::max<uint64_t>(fs::file_size(index_path) / sizeof(uint64_t), index_min_capacity)))
+                    return false;
+
+                map_segment();
+
+                //
+                // Entries point to records written before the crash only
+                //
+                auto entries = static_cast<uint64_t *>(index.get_address());
+                for (uint64_t i = 0; i < index_capacity; ++i) {
+                    if (entries[i] == 0)
+                        continue;
+                    if (!record_at(entries[i] - 1))
+                        entries[i] = 0;
+                    else
+                        ++count;
+                }
+
+                return true;
+            }
+            catch (std::exception const &e) {
+                error_handler(result::EXCEPTION, ErrorFormat("Block store %s: %s", segment_path.parent_path().c_str(), e.what()));
+                return false;
+            }
+        }
+
+        /**
+         * Grow the index file and map it, must be called under unique lock
+         */
+        bool map_index(uint64_t capacity) {
+            if (capacity > index_capacity && fs::file_size(index_path) < capacity * sizeof(uint64_t))
+                fs::resize_file(index_path, capacity * sizeof(uint64_t));
+            index = bip::mapped_region(bip::file_mapping(index_path.c_str(), bip::read_write), bip::read_write);
+            index_capacity = index.get_size() / sizeof(uint64_t);
+            return index_capacity >= capacity;
+        }
+
+        /**
+         * Drop the tail of failed append, so the next record is written at the known offset,
+         * must be called under unique lock
+         */
+        void truncate_segment(uint64_t size) {
+            segment.close();
+            segment.clear();
+
+            std::error_code ec;
+            fs::resize_file(segment_path, size, ec);
+
+            //
+            // tail can't be dropped, next record follows it
+            //
+            auto actual = fs::file_size(segment_path, ec);
+            segment_size = ec ? size : actual;
+
+            segment.open(segment_path, std::ios::binary | std::ios::app);
+        }
+
+        /**
+         * Map the whole segment written so far, must be called under unique lock
+         */
+        void map_segment() {
+            if (segment_size == 0)
+                return;
+            mapped = bip::mapped_region(bip::file_mapping(segment_path.c_str(), bip::read_only), bip::read_only);
+        }
+
+        /**
+         * Get mapped record, must be called under lock
+         */
+        std::optional<std::pair<const uint8_t *, uint32_t>> record_at(uint64_t offset) const {
+            auto region = static_cast<const uint8_t *>(mapped.get_address());
+            auto size = mapped.get_size();
+
+            if (!region || offset + record_header_size > size)
+                return std::nullopt;
+
+            uint32_t length = 0;
+            for (size_t i = 0; i < record_header_size; ++i)
+                length |= uint32_t(region[offset + i]) << (8 * i);
+
+            if (offset + record_header_size + length > size)
+                return std::nullopt;
+
+            return std::make_pair(region + offset + record_header_size, length);
+        }
+
+        std::optional<nlohmann::json> decode(uint64_t id, const std::pair<const uint8_t *, uint32_t> &record) const {
+            try {
+                return nlohmann::json::from_cbor(record.first, record.first + record.second);
+            }
+            catch (std::exception const &e) {
+                error_handler(result::EXCEPTION, ErrorFormat("Block store record %llu: %s", (unsigned long long) id, e.what()));
+                return std::nullopt;
+            }
+        }
+
+        uint64_t entry(uint64_t id) const {
+            if (id >= index_capacity)
+                return 0;
+            return static_cast<const uint64_t *>(index.get_address())[id];
+        }
+
+        const fs::path segment_path;
+        const fs::path index_path;
+
+        std::ofstream segment;
+        uint64_t segment_size;
+        bip::mapped_region mapped;
+
+        bip::mapped_region index;
+        uint64_t index_capacity;
+
+        std::atomic<uint64_t> count;
+
+        mutable std::shared_mutex mutex;
+
+        const ErrorHandler error_handler;
+    };
+}
+
+namespace milecsa::rpc {
+
+    uint64_t BlockStore::max_block_id = uint64_t(1) << 32;
+
+    BlockStore::BlockStore(const std::shared_ptr<detail::BlockStoreState> &state): state(state) {}
+
+    BlockStore::BlockStore(const BlockStore &store): state(store.state) {}
+
+    BlockStore& BlockStore::operator = (const BlockStore& store) {
+        state = store.state;
+        return *this;
+    }
+
+    BlockStore::~BlockStore(){
+        state.reset();
+    }
+
+    std::optional<BlockStore> BlockStore::Open(const std::string &directory, const ErrorHandler &error_handler) {
+        auto state = std::make_shared<detail::BlockStoreState>(directory, error_handler);
+        if (!state->open())
+            return std::nullopt;
+        return BlockStore(state);
+    }
+
+    std::optional<nlohmann::json> BlockStore::get(const uint256_t &id) const {
+
+        if (id > max_block_id)
+            return std::nullopt;
+
+        auto n = static_cast<uint64_t>(id);
+
+        {
+            std::shared_lock<std::shared_mutex> lock(state->mutex);
+
+            auto offset = state->entry(n);
+            if (offset == 0)
+                return std::nullopt;
+
+            if (auto record = state->record_at(offset - 1))
+                return state->decode(n, *record);
+        }
+
+        //
+        // Record has been appended after the segment was mapped,
+        // a reader queued on the lock may find it mapped by the previous one
+        //
+        std::unique_lock<std::shared_mutex> lock(state->mutex);
+
+        auto offset = state->entry(n);
+
+        if (auto record = state->record_at(offset - 1))
+            return state->decode(n, *record);
+
+        if (state->mapped.get_size() >= state->segment_size)
+            return std::nullopt;
+
+        try {
+            state->map_segment();
+        }
+        catch (std::exception const &e) {
+            state->error_handler(result::EXCEPTION, ErrorFormat("Block store: %s", e.what()));
+            return std::nullopt;
+        }
+
+        if (auto record = state->record_at(offset - 1))
+            return state->decode(n, *record);
+
+        return std::nullopt;
+    }
+
+    bool BlockStore::contains(const uint256_t &id) const {
+        if (id > max_block_id)
+            return false;
+        std::shared_lock<std::shared_mutex> lock(state->mutex);
+        return state->entry(static_cast<uint64_t>(id)) != 0;
+    }
+
+    bool BlockStore::put(const uint256_t &id, const nlohmann::json &block) const {
+
+        if (id > max_block_id) {
+            state->error_handler(result::NOT_SUPPORTED,
+                                 ErrorFormat("Block store: block id %s exceeds index limit", UInt256ToDecString(id).c_str()));
+            return false;
+        }
+
+        auto n = static_cast<uint64_t>(id);
+        auto data = nlohmann::json::to_cbor(block);
+
+        if (data.size() > std::numeric_limits<uint32_t>::max()) {
+            state->error_handler(result::NOT_SUPPORTED, ErrorFormat("Block store: block %llu is too large", (unsigned long long) n));
+            return false;
+        }
+
+        std::unique_lock<std::shared_mutex> lock(state->mutex);
+
+        if (state->entry(n) != 0)
+            return true;
+
+        try {
+            if (n >= state->index_capacity && !state->map_index(std::max(n + 1, state->index_capacity * 2)))
+                return false;
+
+            uint8_t header[detail::record_header_size];
+            auto length = static_cast<uint32_t>(data.size());
+            for (size_t i = 0; i < detail::record_header_size; ++i)
+                header[i] = uint8_t(length >> (8 * i));
+
+            auto offset = state->segment_size;
+
+            state->segment.write(reinterpret_cast<const char *>(header), sizeof(header));
+            state->segment.write(reinterpret_cast<const char *>(data.data()), data.size());
+            state->segment.flush();
+
+            if (!state->segment) {
+                state->truncate_segment(offset);
+                state->error_handler(result::FAIL, ErrorFormat("Block store: segment write failed"));
+                return false;
+            }
+
+            state->segment_size += sizeof(header) + data.size();
+
+            static_cast<uint64_t *>(state->index.get_address())[n] = offset + 1;
+            ++state->count;
+
+            return true;
+        }
+        catch (std::exception const &e) {
+            state->error_handler(result::EXCEPTION, ErrorFormat("Block store: %s", e.what()));
+            return false;
+        }
+    }
+
+    uint64_t BlockStore::size() const {
+        return state->count;
+    }
+
+    void BlockStore::flush() const {
+        std::unique_lock<std::shared_mutex> lock(state->mutex);
+        state->segment.flush();
+        state->index.flush();
+    }
+}
@@ -0,0 +1,165 @@
+//
+// Created by lotus mile on 2026-10-17.
+//
+
+#include "milecsa_cache.hpp"
+
+#include <algorithm>
+
+namespace milecsa::rpc {
+
+    BlockCache::BlockCache(size_t capacity, size_t shards_count):
+            shard_capacity(capacity / std::max<size_t>(shards_count, 1)),
+            hits(0),
+            misses(0),
+            evictions(0) {
+        for (size_t i = 0; i < std::max<size_t>(shards_count, 1); ++i)
+            shards.emplace_back(new Shard());
+    }
+
+    BlockCache::Shard &BlockCache::shard(const std::string &key) {
+        return *shards[std::hash<std::string>()(key) % shards.size()];
+    }
+
+    size_t BlockCache::estimate_size(const nlohmann::json &block) {
+
+        size_t size = sizeof(nlohmann::json);
+
+        switch (block.type()) {
+            case nlohmann::json::value_t::string:
+                size += sizeof(nlohmann::json::string_t) + block.get_ref<const nlohmann::json::string_t &>().size();
+                break;
+            case nlohmann::json::value_t::array:
+                size += sizeof(nlohmann::json::array_t);
+                for (auto &item: block)
+                    size += estimate_size(item);
+                break;
+            case nlohmann::json::value_t::object:
+                //
+                // every entry is a tree node: links, key string and value
+                //
+                size += sizeof(nlohmann::json::object_t);
+                for (auto &item: block.items())
+                    size += 4 * sizeof(void *) + sizeof(std::string) + item.key().size() + estimate_size(item.value());
+                break;
+            default:
+                break;
+        }
+
+        return size;
+    }
+
+    std::optional<nlohmann::json> BlockCache::get(const uint256_t &id) {
+
+        auto key = UInt256ToDecString(id);
+        auto &s = shard(key);
+
+        std::lock_guard<std::mutex> lock(s.mutex);
+
+        auto entry = s.index.find(key);
+        if (entry == s.index.end()) {
+            ++misses;
+            return std::nullopt;
+        }
+
+        s.lru.splice(s.lru.begin(), s.lru, entry->second);
+        ++hits;
+
+        return entry->second->second.first;
+    }
+
+    void BlockCache::put(const uint256_t &id, const nlohmann::json &block) {
+
+        auto key = UInt256ToDecString(id);
+        auto size = key.size() + estimate_size(block);
+
+        if (size > shard_capacity)
+            return;
+
+        auto &s = shard(key);
+
+        std::lock_guard<std::mutex> lock(s.mutex);
+
+        auto entry = s.index.find(key);
+        if (entry != s.index.end()) {
+            s.lru.splice(s.lru.begin(), s.lru, entry->second);
+            return;
+        }
+
+        while (!s.lru.empty() && s.bytes + size > shard_capacity) {
+            auto &last = s.lru.back();
+            s.bytes -= last.second.second;
+            s.index.erase(last.first);
+            s.lru.pop_back();
+            ++evictions;
+        }
+
+        s.lru.emplace_front(key, std::make_pair(block, size));
+        s.index[key] = s.lru.begin();
+        s.bytes += size;
+    }
+
+    void BlockCache::clear() {
+        for (auto &s: shards) {
+            std::lock_guard<std::mutex> lock(s->mutex);
+            s->lru.clear();
+            s->index.clear();
+            s->bytes = 0;
+        }
+    }
+
+    CacheStat BlockCache::get_stat() const {
+
+        CacheStat stat = {hits, misses, evictions, 0, 0};
+
+        for (auto &s: shards) {
+            std::lock_guard<std::mutex> lock(s->mutex);
+            stat.entries += s->index.size();
+            stat.bytes += s->bytes;
+        }
+
+        return stat;
+    }
+
+    TtlCache::TtlCache(std::chrono::milliseconds ttl):
+            ttl(ttl),
+            hits(0),
+            misses(0),
+            evictions(0) {}
+
+    std::optional<nlohmann::json> TtlCache::get(const std::string &key) {
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        auto entry = entries.find(key);
+        if (entry == entries.end()) {
+            ++misses;
+            return std::nullopt;
+        }
+
+        if (clock::now() - entry->second.second > ttl) {
+            entries.erase(entry);
+            ++evictions;
+            ++misses;
+            return std::nullopt;
+        }
+
+        ++hits;
+        return entry->second.first;
+    }
+
+    void TtlCache::put(const std::string &key, const nlohmann::json &value) {
+        std::lock_guard<std::mutex> lock(mutex);
+        entries[key] = std::make_pair(value, clock::now());
+    }
+
+    void TtlCache::clear() {
+        std::lock_guard<std::mutex> lock(mutex);
+        entries.clear();
+    }
+
+    CacheStat TtlCache::get_stat() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return {hits, misses, evictions, entries.size(), 0};
+    }
+}
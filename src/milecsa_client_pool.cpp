@@ -0,0 +1,542 @@
+//
+// Created by lotus mile on 2026-10-17.
+//
+
+#include "milecsa_client_pool.hpp"
+#include "milecsa_rpc_session.hpp"
+
+#include <mutex>
+#include <chrono>
+#include <limits>
+#include <algorithm>
+
+namespace milecsa::rpc::detail {
+
+    using clock = std::chrono::steady_clock;
+
+    /**
+     * Weight of the last latency sample in the rolling node latency
+     */
+    static const double latency_weight = 0.2;
+
+    struct PoolNode {
+
+        PoolNode(const Url &url): url(url) {}
+
+        Url url;
+        std::vector<std::shared_ptr<RpcSession>> idle;
+        size_t leased = 0;
+
+        double latency = 0;
+        bool healthy = true;
+        bool probing = false;
+        unsigned int failures_in_row = 0;
+        clock::time_point retry_at;
+
+        uint64_t requests = 0;
+        uint64_t failures = 0;
+    };
+
+    class PoolState {
+
+    public:
+
+        PoolState(size_t sessions_per_node,
+                  bool verify_ssl,
+                  const http::ResponseHandler &response_fail_handler,
+                  const ErrorHandler &error_handler):
+                sessions_per_node(std::max<size_t>(sessions_per_node, 1)),
+                verify_ssl(verify_ssl),
+                response_fail_handler(response_fail_handler),
+                error_handler(error_handler){}
+
+        std::shared_ptr<RpcSession> open_session(const Url &url, const ErrorHandler &error) const {
+            auto session = std::make_shared<RpcSession>(
+                    url.get_host(),
+                    url.get_port(),
+                    url.get_path(),
+                    url.get_protocol(),
+                    verify_ssl,
+                    Client::timeout);
+            if (!session->connect(error))
+                return nullptr;
+            return session;
+        }
+
+        /**
+         * Latency of a node that has no samples yet: median of the measured nodes, so its load is
+         * weighed like the others' instead of making it win every lease, must be called under lock
+         */
+        double unmeasured_latency() const {
+            std::vector<double> measured;
+            for (auto &node: nodes) {
+                if (node.latency > 0)
+                    measured.push_back(node.latency);
+            }
+            if (measured.empty())
+                return 1.0;
+            auto middle = measured.begin() + measured.size() / 2;
+            std::nth_element(measured.begin(), middle, measured.end());
+            return *middle;
+        }
+
+        /**
+         * Choose the fastest healthy node which has not been tried yet, must be called under lock.
+         * Excluded node whose retry time has come takes one probe call (half-open): idempotent call,
+         * or any call if no healthy node is left. Failed probe moves the retry time forward.
+         */
+        std::optional<size_t> choose(const std::vector<bool> &tried, bool idempotent, bool &probe) {
+            std::optional<size_t> best;
+            std::optional<size_t> due;
+            double best_score = std::numeric_limits<double>::max();
+            auto now = clock::now();
+            auto seed = unmeasured_latency();
+
+            for (size_t i = 0; i < nodes.size(); ++i) {
+                auto &node = nodes[i];
+                if (tried[i])
+                    continue;
+                if (!node.healthy) {
+                    if (!due && !node.probing && node.retry_at <= now)
+                        due = i;
+                    continue;
+                }
+                auto latency = node.latency > 0 ? node.latency : seed;
+                auto score = latency * (1.0 + double(node.leased) / sessions_per_node);
+                if (score < best_score) {
+                    best_score = score;
+                    best = i;
+                }
+            }
+
+            probe = due && (idempotent || !best);
+
+            if (probe) {
+                nodes[*due].probing = true;
+                return due;
+            }
+
+            return best;
+        }
+
+        /**
+         * Take an idle session of node, must be called under lock
+         */
+        std::shared_ptr<RpcSession> lease(PoolNode &node) {
+            ++node.leased;
+            if (node.idle.empty())
+                return nullptr;
+            auto session = node.idle.back();
+            node.idle.pop_back();
+            return session;
+        }
+
+        /**
+         * Return session of the call has not reached the node, nothing is accounted, must be called under lock
+         */
+        void restore(PoolNode &node, const std::shared_ptr<RpcSession> &session, bool probe) {
+            --node.leased;
+            if (probe)
+                node.probing = false;
+            if (session)
+                node.idle.push_back(session);
+        }
+
+        /**
+         * Return session and account the call result, must be called under lock
+         */
+        void release(PoolNode &node,
+                     const std::shared_ptr<RpcSession> &session,
+                     std::optional<time_t> elapsed,
+                     bool probe = false) {
+            --node.leased;
+
+            if (probe)
+                node.probing = false;
+
+            if (elapsed) {
+                ++node.requests;
+                node.failures_in_row = 0;
+                node.healthy = true;
+                node.latency = node.latency == 0 ?
+                               *elapsed : (1 - latency_weight) * node.latency + latency_weight * *elapsed;
+                if (session)
+                    node.idle.push_back(session);
+                return;
+            }
+
+            //
+            // failed probe excludes node again at once, it is not probed until the next retry time
+            //
+            ++node.failures;
+            if (++node.failures_in_row >= ClientPool::max_failures || probe) {
+                node.healthy = false;
+                node.retry_at = clock::now() + std::chrono::seconds(ClientPool::retry_interval);
+            }
+        }
+
+        std::mutex mutex;
+        std::vector<PoolNode> nodes;
+
+        std::shared_ptr<BlockCache> block_cache;
+        std::shared_ptr<TtlCache> info_cache;
+        std::optional<BlockStore> block_store;
+        std::optional<BlockIdTracker> block_id_tracker;
+
+        const size_t sessions_per_node;
+        const bool verify_ssl;
+        const http::ResponseHandler response_fail_handler;
+        const ErrorHandler error_handler;
+    };
+
+    static inline bool is_transport_error(milecsa::result code) {
+        return code == milecsa::result::TIMEOUT || code == milecsa::result::FAIL;
+    }
+
+    static inline time_t elapsed_since(clock::time_point start) {
+        return std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - start).count();
+    }
+}
+
+namespace milecsa::rpc {
+
+    unsigned int ClientPool::max_failures = 3;
+    time_t ClientPool::retry_interval = 5;
+
+    using detail::clock;
+
+    ClientPool::ClientPool(const std::shared_ptr<detail::PoolState> &state): state(state) {}
+
+    ClientPool::ClientPool(const ClientPool &pool): state(pool.state) {}
+
+    ClientPool& ClientPool::operator = (const ClientPool& pool) {
+        state = pool.state;
+        return *this;
+    }
+
+    ClientPool::~ClientPool(){
+        state.reset();
+    }
+
+    std::optional<ClientPool> ClientPool::Connect(
+            const std::vector<std::string> &urls,
+            size_t sessions_per_node,
+            bool verify_ssl,
+            const http::ResponseHandler &response_fail_handler,
+            const milecsa::ErrorHandler &error_handler) {
+
+        if (urls.empty()) {
+            error_handler(result::NOT_FOUND, ErrorFormat("Client pool: node list is empty"));
+            return std::nullopt;
+        }
+
+        auto state = std::make_shared<detail::PoolState>(
+                sessions_per_node, verify_ssl, response_fail_handler, error_handler);
+
+        for (auto &urlString: urls) {
+            auto url = Url::Parse(urlString, error_handler);
+            if (!url)
+                return std::nullopt;
+            state->nodes.emplace_back(*url);
+        }
+
+        bool connected = false;
+
+        for (auto &node: state->nodes) {
+            for (size_t i = 0; i < state->sessions_per_node; ++i) {
+                auto session = state->open_session(node.url, default_error_handler);
+                if (!session)
+                    break;
+                node.idle.push_back(session);
+            }
+            if (node.idle.empty()) {
+                node.healthy = false;
+                node.failures_in_row = max_failures;
+                node.retry_at = clock::now() + std::chrono::seconds(retry_interval);
+            }
+            connected |= !node.idle.empty();
+        }
+
+        if (!connected) {
+            error_handler(result::NOT_FOUND, ErrorFormat("Client pool: no one node is available"));
+            return std::nullopt;
+        }
+
+        auto pool = ClientPool(state);
+        pool.ping();
+
+        return std::move(pool);
+    }
+
+    bool ClientPool::route(const std::function<bool(const Client &)> &operation, bool idempotent) const {
+
+        std::vector<bool> tried(state->nodes.size(), false);
+
+        std::optional<milecsa::result> last_code;
+        std::string last_error;
+
+        for (size_t attempt = 0; attempt < state->nodes.size(); ++attempt) {
+
+            std::shared_ptr<detail::RpcSession> session;
+            size_t index;
+            bool probe;
+
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                auto chosen = state->choose(tried, idempotent, probe);
+                if (!chosen)
+                    break;
+                index = *chosen;
+                tried[index] = true;
+                session = state->lease(state->nodes[index]);
+            }
+
+            auto &node = state->nodes[index];
+
+            bool transport_failed = false;
+            ErrorHandler lease_error_handler = [&](milecsa::result code, const std::string &error){
+                if (detail::is_transport_error(code)) {
+                    transport_failed = true;
+                    last_code = code;
+                    last_error = error;
+                }
+                else
+                    state->error_handler(code, error);
+            };
+
+            bool sent = false;
+            bool succeeded = false;
+            bool local = false;
+            std::optional<time_t> elapsed;
+
+            if (!session)
+                session = state->open_session(node.url, lease_error_handler);
+
+            if (session) {
+                sent = true;
+                auto start = clock::now();
+                auto operations = session->get_operations();
+                Client client(node.url, session, state->verify_ssl, state->response_fail_handler, lease_error_handler);
+
+                //
+                // probe must reach the node, it bypasses the caches
+                //
+                if (!probe) {
+                    client.set_block_cache(state->block_cache);
+                    client.set_info_cache(state->info_cache);
+                    client.set_block_store(state->block_store);
+                    client.set_block_id_tracker(state->block_id_tracker);
+                }
+
+                succeeded = operation(client);
+
+                //
+                // call served from the caches is neither a latency sample nor a health result
+                //
+                local = !transport_failed && session->get_operations() == operations;
+
+                if (!transport_failed)
+                    elapsed = detail::elapsed_since(start);
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                if (local)
+                    state->restore(node, session, probe);
+                else
+                    state->release(node, session, elapsed, probe);
+            }
+
+            if (!transport_failed && session)
+                return succeeded;
+
+            if (sent && !idempotent)
+                break;
+        }
+
+        if (last_code)
+            state->error_handler(*last_code, last_error);
+        else
+            state->error_handler(result::NOT_FOUND, ErrorFormat("Client pool: no healthy nodes"));
+
+        return false;
+    }
+
+    std::optional<time_t> ClientPool::ping() const {
+
+        std::optional<time_t> best;
+
+        for (auto &node: state->nodes) {
+
+            std::shared_ptr<detail::RpcSession> session;
+
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                session = state->lease(node);
+            }
+
+            if (!session)
+                session = state->open_session(node.url, default_error_handler);
+
+            std::optional<time_t> elapsed;
+
+            if (session) {
+                Client client(node.url, session, state->verify_ssl, http::default_response_handler, default_error_handler);
+                if (auto t = client.ping(); t && *t >= 0)
+                    elapsed = *t;
+            }
+
+            size_t missing = 0;
+
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->release(node, session, elapsed);
+                if (elapsed && node.idle.size() + node.leased < state->sessions_per_node)
+                    missing = state->sessions_per_node - node.idle.size() - node.leased;
+            }
+
+            //
+            // Keep the node warm up to the requested sessions count
+            //
+            for (size_t i = 0; i < missing; ++i) {
+                auto extra = state->open_session(node.url, default_error_handler);
+                if (!extra)
+                    break;
+                std::lock_guard<std::mutex> lock(state->mutex);
+                node.idle.push_back(extra);
+            }
+
+            if (elapsed && (!best || *elapsed < *best))
+                best = elapsed;
+        }
+
+        return best;
+    }
+
+    void ClientPool::set_block_cache(const std::shared_ptr<BlockCache> &cache) {
+        state->block_cache = cache;
+    }
+
+    void ClientPool::set_block_store(const std::optional<BlockStore> &store) {
+        state->block_store = store;
+    }
+
+    void ClientPool::set_block_id_tracker(const std::optional<BlockIdTracker> &tracker) {
+        state->block_id_tracker = tracker;
+    }
+
+    void ClientPool::set_info_cache(const std::shared_ptr<TtlCache> &cache) {
+        state->info_cache = cache;
+    }
+
+    std::vector<ClientPool::NodeStat> ClientPool::get_stat() const {
+        std::lock_guard<std::mutex> lock(state->mutex);
+
+        std::vector<NodeStat> stat;
+        for (auto &node: state->nodes) {
+            stat.push_back({
+                                   node.url.get_absolute_string(),
+                                   static_cast<time_t>(node.latency),
+                                   node.healthy,
+                                   node.requests,
+                                   node.failures,
+                                   node.idle.size() + node.leased
+                           });
+        }
+        return stat;
+    }
+
+    std::optional<uint256_t> ClientPool::get_current_block_id() const {
+        std::optional<uint256_t> result;
+        route([&](const Client &client){ return (result = client.get_current_block_id()).has_value(); });
+        return result;
+    }
+
+    rpc::response ClientPool::get_network_state() const {
+        rpc::response result;
+        route([&](const Client &client){ return (result = client.get_network_state()).has_value(); });
+        return result;
+    }
+
+    rpc::response ClientPool::get_nodes() const {
+        rpc::response result;
+        route([&](const Client &client){ return (result = client.get_nodes()).has_value(); });
+        return result;
+    }
+
+    rpc::response ClientPool::get_blockchain_info() const {
+        rpc::response result;
+        route([&](const Client &client){ return (result = client.get_blockchain_info()).has_value(); });
+        return result;
+    }
+
+    rpc::response ClientPool::get_blockchain_state() const {
+        rpc::response result;
+        route([&](const Client &client){ return (result = client.get_blockchain_state()).has_value(); });
+        return result;
+    }
+
+    rpc::response ClientPool::get_block(uint256_t id) const {
+        rpc::response result;
+        route([&](const Client &client){ return (result = client.get_block(id)).has_value(); });
+        return result;
+    }
+
+    static inline bool any_received(const std::vector<rpc::response> &results) {
+        return std::any_of(results.begin(), results.end(), [](const rpc::response &r){ return r.has_value(); });
+    }
+
+    std::vector<rpc::response> ClientPool::get_blocks(const std::vector<uint256_t> &ids) const {
+        std::vector<rpc::response> result(ids.size());
+        route([&](const Client &client){ return any_received(result = client.get_blocks(ids)); });
+        return result;
+    }
+
+    std::vector<rpc::response> ClientPool::get_wallet_states(const std::vector<std::string> &publicKeys) const {
+        std::vector<rpc::response> result(publicKeys.size());
+        route([&](const Client &client){ return any_received(result = client.get_wallet_states(publicKeys)); });
+        return result;
+    }
+
+    rpc::response ClientPool::get_wallet_state(const std::string &publicKey) const {
+        rpc::response result;
+        route([&](const Client &client){ return (result = client.get_wallet_state(publicKey)).has_value(); });
+        return result;
+    }
+
+    rpc::response ClientPool::get_wallet_transactions(const std::string &publicKey,
+                                                      const unsigned int limit) const {
+        rpc::response result;
+        route([&](const Client &client){
+            return (result = client.get_wallet_transactions(publicKey, limit)).has_value();
+        });
+        return result;
+    }
+
+    rpc::response ClientPool::get_wallet_state(const milecsa::keys::Pair &pair) const {
+        return get_wallet_state(pair.get_public_key().encode());
+    }
+
+    rpc::response ClientPool::get_wallet_transactions(const milecsa::keys::Pair &pair,
+                                                      const unsigned int limit) const {
+        return get_wallet_transactions(pair.get_public_key().encode(), limit);
+    }
+
+    rpc::response ClientPool::send_transaction(const milecsa::keys::Pair &pair,
+                                               milecsa::rpc::json transactionData) const {
+        rpc::response result;
+        route([&](const Client &client){
+            return (result = client.send_transaction(pair, transactionData)).has_value();
+        }, false);
+        return result;
+    }
+
+    CallResult ClientPool::call(const std::string &method,
+                                const milecsa::rpc::request &params) const {
+        CallResult result;
+        route([&](const Client &client){
+            return has_result(result = client.call(method, params));
+        }, detail::RpcSession::is_idempotent(method));
+        return result;
+    }
+}
@@ -0,0 +1,196 @@
+//
+// Created by lotus mile on 2026-10-17.
+//
+
+#include "milecsa_concurrent_client.hpp"
+#include "milecsa_rpc_session.hpp"
+
+#include <atomic>
+#include <thread>
+#include <algorithm>
+
+namespace milecsa::rpc::detail {
+
+    class ConcurrentState {
+
+    public:
+
+        ConcurrentState():
+                ioc(std::make_shared<boost::asio::io_context>()),
+                work(boost::asio::make_work_guard(*ioc)),
+                next(0){}
+
+        ~ConcurrentState() {
+            work.reset();
+            ioc->stop();
+
+            //
+            // the last copy of the client can be released by a handler, its io thread can't join itself:
+            // it is detached and keeps the io context until run returns
+            //
+            for (auto &thread: threads) {
+                if (!thread.joinable())
+                    continue;
+                if (thread.get_id() == std::this_thread::get_id())
+                    thread.detach();
+                else
+                    thread.join();
+            }
+        }
+
+        const Client &next_client() {
+            return clients[next.fetch_add(1, std::memory_order_relaxed) % clients.size()];
+        }
+
+        std::shared_ptr<boost::asio::io_context> ioc;
+        boost::asio::executor_work_guard<boost::asio::io_context::executor_type> work;
+        std::vector<std::thread> threads;
+        std::vector<Client> clients;
+        std::atomic<size_t> next;
+    };
+}
+
+namespace milecsa::rpc {
+
+    ConcurrentClient::ConcurrentClient(const std::shared_ptr<detail::ConcurrentState> &state): state(state) {}
+
+    ConcurrentClient::ConcurrentClient(const ConcurrentClient &client): state(client.state) {}
+
+    ConcurrentClient& ConcurrentClient::operator = (const ConcurrentClient& client) {
+        state = client.state;
+        return *this;
+    }
+
+    ConcurrentClient::~ConcurrentClient(){
+        state.reset();
+    }
+
+    std::optional<ConcurrentClient> ConcurrentClient::Connect(
+            const std::string &urlString,
+            size_t connections,
+            size_t pipeline_depth,
+            size_t io_threads,
+            bool verify_ssl,
+            const http::ResponseHandler &response_fail_handler,
+            const milecsa::ErrorHandler &error_handler) {
+
+        auto state = std::make_shared<detail::ConcurrentState>();
+
+        for (size_t i = 0; i < std::max<size_t>(connections, 1); ++i) {
+            auto client = Client::Connect(*state->ioc, urlString, verify_ssl, response_fail_handler, error_handler);
+            if (!client)
+                return std::nullopt;
+
+            //
+            // connections are checked like the sync client does, io threads are not running yet
+            //
+            if (!client->session->connect(error_handler))
+                return std::nullopt;
+
+            client->set_pipeline_depth(pipeline_depth);
+            state->clients.push_back(*client);
+        }
+
+        for (size_t i = 0; i < std::max<size_t>(io_threads, 1); ++i) {
+            auto ioc = state->ioc;
+            state->threads.emplace_back([ioc]{ ioc->run(); });
+        }
+
+        return ConcurrentClient(state);
+    }
+
+    const Url &ConcurrentClient::get_url() const {
+        return state->clients.front().get_url();
+    }
+
+    void ConcurrentClient::set_block_cache(const std::shared_ptr<BlockCache> &cache) {
+        for (auto &client: state->clients)
+            client.set_block_cache(cache);
+    }
+
+    void ConcurrentClient::set_block_store(const std::optional<BlockStore> &store) {
+        for (auto &client: state->clients)
+            client.set_block_store(store);
+    }
+
+    void ConcurrentClient::set_block_id_tracker(const std::optional<BlockIdTracker> &tracker) {
+        for (auto &client: state->clients)
+            client.set_block_id_tracker(tracker);
+    }
+
+    void ConcurrentClient::set_info_cache(const std::shared_ptr<TtlCache> &cache) {
+        for (auto &client: state->clients)
+            client.set_info_cache(cache);
+    }
+
+    void ConcurrentClient::set_timeout(std::chrono::milliseconds timeout) {
+        for (auto &client: state->clients)
+            client.set_timeout(timeout);
+    }
+
+    void ConcurrentClient::set_adaptive_timeout(std::chrono::milliseconds min, std::chrono::milliseconds max) {
+        auto adaptive = std::make_shared<AdaptiveTimeout>(min, max);
+        for (auto &client: state->clients)
+            client.set_adaptive_timeout(adaptive);
+    }
+
+    void ConcurrentClient::set_compression(const http::Compression &settings) {
+        for (auto &client: state->clients)
+            client.set_compression(settings);
+    }
+
+    const Client &ConcurrentClient::next() const {
+        return state->next_client();
+    }
+
+    std::optional<time_t> ConcurrentClient::ping() const {
+        return next().async_ping().get();
+    }
+
+    std::optional<uint256_t> ConcurrentClient::get_current_block_id() const {
+        return next().async_get_current_block_id().get();
+    }
+
+    rpc::response ConcurrentClient::get_network_state() const {
+        return next().async_get_network_state().get();
+    }
+
+    rpc::response ConcurrentClient::get_nodes() const {
+        return next().async_get_nodes().get();
+    }
+
+    rpc::response ConcurrentClient::get_blockchain_info() const {
+        return next().async_get_blockchain_info().get();
+    }
+
+    rpc::response ConcurrentClient::get_blockchain_state() const {
+        return next().async_get_blockchain_state().get();
+    }
+
+    rpc::response ConcurrentClient::get_block(uint256_t id) const {
+        return next().async_get_block(id).get();
+    }
+
+    rpc::response ConcurrentClient::get_wallet_state(const std::string &publicKey) const {
+        return next().async_get_wallet_state(publicKey).get();
+    }
+
+    rpc::response ConcurrentClient::get_wallet_transactions(const std::string &publicKey,
+                                                            const unsigned int limit) const {
+        return next().async_get_wallet_transactions(publicKey, limit).get();
+    }
+
+    rpc::response ConcurrentClient::get_wallet_state(const milecsa::keys::Pair &pair) const {
+        return get_wallet_state(pair.get_public_key().encode());
+    }
+
+    rpc::response ConcurrentClient::get_wallet_transactions(const milecsa::keys::Pair &pair,
+                                                            const unsigned int limit) const {
+        return get_wallet_transactions(pair.get_public_key().encode(), limit);
+    }
+
+    rpc::response ConcurrentClient::send_transaction(const milecsa::keys::Pair &pair,
+                                                     milecsa::rpc::json transactionData) const {
+        return next().async_send_transaction(pair, transactionData).get();
+    }
+}
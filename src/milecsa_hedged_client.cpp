@@ -0,0 +1,409 @@
+//
+// Created by lotus mile on 2026-10-17.
+//
+
+#include "milecsa_hedged_client.hpp"
+
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <algorithm>
+#include <numeric>
+
+namespace milecsa::rpc::detail {
+
+    typedef std::chrono::steady_clock clock;
+
+    /**
+     * Hedge delay of node is recomputed after this number of samples
+     */
+    static const size_t delay_update_interval = 16;
+
+    /**
+     * Call is sent to two nodes at most
+     */
+    static const size_t max_attempts = 2;
+
+    struct HedgeNode {
+
+        HedgeNode(const ConcurrentClient &client, time_t delay): client(client), delay(delay) {}
+
+        ConcurrentClient client;
+
+        std::vector<time_t> samples;
+        size_t next_sample = 0;
+        size_t since_update = 0;
+        time_t delay;
+
+        uint64_t requests = 0;
+        uint64_t hedges = 0;
+        uint64_t wins = 0;
+        uint64_t failures = 0;
+    };
+
+    class HedgeState;
+
+    /**
+     * Race keeps the state alive until its last attempt completes, so a handler can release
+     * the last client copy; the timer is destroyed before the state and its io context
+     */
+    template <typename T>
+    struct Race {
+
+        typedef std::function<void(const T &)> Handler;
+        typedef std::function<void(const Client &, const Handler &)> Call;
+
+        Race(const std::shared_ptr<HedgeState> &owner,
+             boost::asio::io_context &ioc,
+             const Call &call,
+             const Handler &handler):
+                owner(owner), call(call), handler(handler), timer(ioc) {}
+
+        const std::shared_ptr<HedgeState> owner;
+        const Call call;
+        const Handler handler;
+
+        std::vector<size_t> order;
+        std::vector<clock::time_point> starts;
+        std::vector<CancelToken> cancels;
+        std::vector<bool> finished;
+
+        size_t outstanding = 0;
+        bool done = false;
+
+        boost::asio::steady_timer timer;
+        std::mutex mutex;
+    };
+
+    class HedgeState: public std::enable_shared_from_this<HedgeState> {
+
+    public:
+
+        HedgeState(const std::vector<ConcurrentClient> &clients,
+                   const HedgePolicy &policy,
+                   const ErrorHandler &error_handler):
+                policy(policy),
+                ioc(std::make_shared<boost::asio::io_context>()),
+                work(boost::asio::make_work_guard(*ioc)),
+                calls(0),
+                hedged(0),
+                error_handler(error_handler) {
+            for (auto &client: clients)
+                nodes.emplace_back(client, policy.max_delay);
+            auto context = ioc;
+            thread = std::thread([context]{ context->run(); });
+        }
+
+        /**
+         * Races hold the state, so no call is in progress here. The last reference can be dropped
+         * by the io thread itself: it is detached and keeps the io context until run returns
+         */
+        ~HedgeState() {
+            work.reset();
+            ioc->stop();
+            if (!thread.joinable())
+                return;
+            if (thread.get_id() == std::this_thread::get_id())
+                thread.detach();
+            else
+                thread.join();
+        }
+
+        template <typename T>
+        void run(const typename Race<T>::Call &call, const typename Race<T>::Handler &handler) {
+
+            auto race = std::make_shared<Race<T>>(shared_from_this(), *ioc, call, handler);
+            time_t delay;
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                ++calls;
+                race->order.resize(nodes.size());
+                std::iota(race->order.begin(), race->order.end(), 0);
+                std::stable_sort(race->order.begin(), race->order.end(), [this](size_t a, size_t b){
+                    return nodes[a].delay < nodes[b].delay;
+                });
+                race->order.resize(std::min(race->order.size(), max_attempts));
+                delay = nodes[race->order.front()].delay;
+            }
+
+            std::optional<CancelToken> cancel;
+
+            {
+                std::lock_guard<std::mutex> lock(race->mutex);
+
+                cancel = prepare(*race, false);
+
+                if (race->order.size() > 1) {
+                    ++race->outstanding;
+                    race->timer.expires_after(std::chrono::microseconds(delay));
+                    race->timer.async_wait([race](const boost::system::error_code &ec){
+                        race->owner->expired(race, ec);
+                    });
+                }
+            }
+
+            launch(race, 0, *cancel);
+        }
+
+        std::vector<HedgeNode> nodes;
+        const HedgePolicy policy;
+
+        mutable std::mutex mutex;
+
+    private:
+
+        /**
+         * Account the next attempt, must be called under race lock
+         */
+        template <typename T>
+        CancelToken prepare(Race<T> &race, bool hedge) {
+            auto index = race.starts.size();
+            CancelToken cancel;
+
+            race.starts.push_back(clock::now());
+            race.cancels.push_back(cancel);
+            race.finished.push_back(false);
+            ++race.outstanding;
+
+            std::lock_guard<std::mutex> lock(mutex);
+            auto &node = nodes[race.order[index]];
+            if (index == 0)
+                ++node.requests;
+            else
+                ++node.hedges;
+            if (hedge)
+                ++hedged;
+
+            return cancel;
+        }
+
+        template <typename T>
+        void launch(const std::shared_ptr<Race<T>> &race, size_t index, const CancelToken &cancel) {
+            auto client = nodes[race->order[index]].client.next().with(CallContext{std::nullopt, cancel});
+            race->call(client, [race, index](const T &result){
+                race->owner->completed(race, index, result);
+            });
+        }
+
+        template <typename T>
+        void completed(const std::shared_ptr<Race<T>> &race, size_t index, const T &result) {
+
+            std::optional<CancelToken> next;
+            size_t next_index = 0;
+            bool deliver = false;
+
+            {
+                std::lock_guard<std::mutex> lock(race->mutex);
+
+                --race->outstanding;
+                race->finished[index] = true;
+
+                if (!race->cancels[index].is_cancelled())
+                    account(race->order[index], result ? std::optional<time_t>(elapsed_since(race->starts[index])) : std::nullopt);
+
+                if (!race->done) {
+                    if (result) {
+                        race->done = deliver = true;
+                        cancel_timer(race);
+
+                        //
+                        // the slower node is known to take longer than the winner
+                        //
+                        for (size_t i = 0; i < race->starts.size(); ++i) {
+                            if (i == index || race->finished[i])
+                                continue;
+                            race->cancels[i].cancel();
+                            account(race->order[i], elapsed_since(race->starts[i]));
+                        }
+
+                        if (index > 0) {
+                            std::lock_guard<std::mutex> state_lock(mutex);
+                            ++nodes[race->order[index]].wins;
+                        }
+                    }
+                    else if (race->starts.size() < race->order.size()) {
+                        cancel_timer(race);
+                        next_index = race->starts.size();
+                        next = prepare(*race, false);
+                    }
+                    else if (std::all_of(race->finished.begin(), race->finished.end(), [](bool f){ return f; })) {
+                        race->done = deliver = true;
+                    }
+                }
+
+            }
+
+            if (next)
+                launch(race, next_index, *next);
+
+            if (deliver)
+                race->handler(result);
+        }
+
+        template <typename T>
+        void expired(const std::shared_ptr<Race<T>> &race, const boost::system::error_code &ec) {
+
+            std::optional<CancelToken> next;
+            size_t next_index = 0;
+
+            {
+                std::lock_guard<std::mutex> lock(race->mutex);
+
+                --race->outstanding;
+
+                if (!ec && !race->done && race->starts.size() < race->order.size() && allow_hedge()) {
+                    next_index = race->starts.size();
+                    next = prepare(*race, true);
+                }
+            }
+
+            if (next)
+                launch(race, next_index, *next);
+        }
+
+        /**
+         * Timer is touched by its io thread only
+         */
+        template <typename T>
+        void cancel_timer(const std::shared_ptr<Race<T>> &race) {
+            boost::asio::post(*ioc, [race]{ race->timer.cancel(); });
+        }
+
+        bool allow_hedge() {
+            std::lock_guard<std::mutex> lock(mutex);
+            return hedged < policy.max_extra_load * calls;
+        }
+
+        /**
+         * Add latency sample or failure of node
+         */
+        void account(size_t index, const std::optional<time_t> &elapsed) {
+
+            std::lock_guard<std::mutex> lock(mutex);
+
+            auto &node = nodes[index];
+
+            if (!elapsed) {
+                ++node.failures;
+                return;
+            }
+
+            auto window = std::max<size_t>(policy.window, 1);
+
+            if (node.samples.size() < window)
+                node.samples.push_back(*elapsed);
+            else
+                node.samples[node.next_sample] = *elapsed;
+            node.next_sample = (node.next_sample + 1) % window;
+
+            if (++node.since_update < delay_update_interval)
+                return;
+
+            node.since_update = 0;
+
+            auto sorted = node.samples;
+            auto rank = static_cast<size_t>(std::clamp(policy.percentile, 0.0, 1.0) * (sorted.size() - 1));
+            std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+            node.delay = std::clamp(sorted[rank], policy.min_delay, std::max(policy.min_delay, policy.max_delay));
+        }
+
+        static time_t elapsed_since(clock::time_point start) {
+            return std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - start).count();
+        }
+
+        std::shared_ptr<boost::asio::io_context> ioc;
+        boost::asio::executor_work_guard<boost::asio::io_context::executor_type> work;
+        std::thread thread;
+
+        uint64_t calls;
+        uint64_t hedged;
+
+        const ErrorHandler error_handler;
+    };
+}
+
+namespace milecsa::rpc {
+
+    HedgedClient::HedgedClient(const std::shared_ptr<detail::HedgeState> &state): state(state) {}
+
+    HedgedClient::HedgedClient(const HedgedClient &client): state(client.state) {}
+
+    HedgedClient& HedgedClient::operator = (const HedgedClient& client) {
+        state = client.state;
+        return *this;
+    }
+
+    HedgedClient::~HedgedClient(){
+        state.reset();
+    }
+
+    std::optional<HedgedClient> HedgedClient::Start(
+            const std::vector<ConcurrentClient> &clients,
+            const HedgePolicy &policy,
+            const milecsa::ErrorHandler &error_handler) {
+
+        if (clients.empty()) {
+            error_handler(result::NOT_FOUND, ErrorFormat("Hedged client: node list is empty"));
+            return std::nullopt;
+        }
+
+        return HedgedClient(std::make_shared<detail::HedgeState>(clients, policy, error_handler));
+    }
+
+    template <typename T>
+    static inline T wait_result(const std::function<void(const std::function<void(const T &)> &)> &call) {
+        auto promise = std::make_shared<std::promise<T>>();
+        call([promise](const T &result){
+            promise->set_value(result);
+        });
+        return promise->get_future().get();
+    }
+
+    void HedgedClient::async_get_current_block_id(const std::function<void(const std::optional<uint256_t> &)> &handler) const {
+        state->run<std::optional<uint256_t>>([](const Client &client, const auto &done){
+            client.async_get_current_block_id(done);
+        }, handler);
+    }
+
+    std::optional<uint256_t> HedgedClient::get_current_block_id() const {
+        return wait_result<std::optional<uint256_t>>([this](auto handler){ async_get_current_block_id(handler); });
+    }
+
+    void HedgedClient::async_get_block(uint256_t id, const ResultHandler &handler) const {
+        state->run<response>([id](const Client &client, const auto &done){
+            client.async_get_block(id, done);
+        }, handler);
+    }
+
+    rpc::response HedgedClient::get_block(uint256_t id) const {
+        return wait_result<response>([this, id](auto handler){ async_get_block(id, handler); });
+    }
+
+    void HedgedClient::async_get_wallet_state(const std::string &publicKey, const ResultHandler &handler) const {
+        state->run<response>([publicKey](const Client &client, const auto &done){
+            client.async_get_wallet_state(publicKey, done);
+        }, handler);
+    }
+
+    rpc::response HedgedClient::get_wallet_state(const std::string &publicKey) const {
+        return wait_result<response>([this, &publicKey](auto handler){ async_get_wallet_state(publicKey, handler); });
+    }
+
+    std::vector<HedgedClient::NodeStat> HedgedClient::get_stat() const {
+        std::lock_guard<std::mutex> lock(state->mutex);
+
+        std::vector<NodeStat> stat;
+        for (auto &node: state->nodes) {
+            stat.push_back({
+                                   node.client.get_url().get_absolute_string(),
+                                   node.delay,
+                                   node.requests,
+                                   node.hedges,
+                                   node.wins,
+                                   node.failures
+                           });
+        }
+        return stat;
+    }
+}
@@ -0,0 +1,232 @@
+//
+// Created by lotus mile on 2026-10-17.
+//
+
+#include "milecsa_inflate_body.hpp"
+
+#include <algorithm>
+#include <boost/beast/core/string.hpp>
+#include <boost/beast/http/error.hpp>
+#include <zlib.h>
+
+namespace milecsa::http::detail {
+
+    /**
+     * Output grows by this step at least
+     */
+    static const size_t inflate_step = 16 * 1024;
+
+    /**
+     * Streamed body keeps this many first bytes of content for diagnostics
+     */
+    static const size_t streamed_prefix = 4 * 1024;
+
+    /**
+     * Window bits of the stream by its first two bytes: gzip magic, zlib CMF/FLG pair or raw deflate,
+     * some servers send raw deflate stream as "deflate"
+     */
+    static int window_bits(unsigned char cmf, unsigned char flg) {
+        if (cmf == 0x1f && flg == 0x8b)
+            return 15 + 16;
+        if ((cmf & 0x0f) == 8 && (cmf >> 4) <= 7 && ((cmf << 8) | flg) % 31 == 0)
+            return 15;
+        return -15;
+    }
+
+    class Inflater {
+
+    public:
+
+        Inflater(): initialized(false), ended(false) {
+            stream = {};
+        }
+
+        ~Inflater() {
+            if (initialized)
+                inflateEnd(&stream);
+        }
+
+        void write(const char *data, size_t size, std::string &out, size_t limit, boost::system::error_code &ec) {
+
+            if (!initialized) {
+
+                //
+                // the stream format is known by the first two bytes
+                //
+                auto taken = std::min(size, 2 - head.size());
+                head.append(data, taken);
+                data += taken;
+                size -= taken;
+
+                if (head.size() < 2)
+                    return;
+
+                auto bits = window_bits(static_cast<unsigned char>(head[0]), static_cast<unsigned char>(head[1]));
+
+                if (inflateInit2(&stream, bits) != Z_OK) {
+                    ec = boost::system::errc::make_error_code(boost::system::errc::not_enough_memory);
+                    return;
+                }
+                initialized = true;
+
+                inflate_some(head.data(), head.size(), out, limit, ec);
+                if (ec)
+                    return;
+            }
+
+            inflate_some(data, size, out, limit, ec);
+        }
+
+        void finish(boost::system::error_code &ec) {
+            //
+            // empty body has nothing to decode
+            //
+            if (!ended && !(head.empty() && !initialized))
+                ec = boost::beast::http::error::partial_message;
+        }
+
+    private:
+
+        void inflate_some(const char *data, size_t size, std::string &out, size_t limit, boost::system::error_code &ec) {
+
+            stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+            stream.avail_in = static_cast<uInt>(size);
+
+            while (stream.avail_in > 0 && !ended) {
+
+                auto offset = out.size();
+                auto room = limit > offset ? limit - offset : 0;
+                auto chunk = std::max<size_t>(inflate_step, stream.avail_in * 4);
+
+                //
+                // one byte over the limit tells the body is too large
+                //
+                if (chunk > room)
+                    chunk = room + 1;
+
+                out.resize(offset + chunk);
+                stream.next_out = reinterpret_cast<Bytef *>(&out[offset]);
+                stream.avail_out = static_cast<uInt>(chunk);
+
+                auto rc = inflate(&stream, Z_NO_FLUSH);
+
+                out.resize(offset + chunk - stream.avail_out);
+
+                if (out.size() > limit) {
+                    out.resize(limit);
+                    ec = boost::beast::http::error::body_limit;
+                    return;
+                }
+
+                if (rc == Z_STREAM_END) {
+                    ended = true;
+                    break;
+                }
+
+                if (rc != Z_OK && rc != Z_BUF_ERROR) {
+                    ec = boost::system::errc::make_error_code(boost::system::errc::illegal_byte_sequence);
+                    return;
+                }
+            }
+        }
+
+        z_stream stream;
+        std::string head;
+        bool initialized;
+        bool ended;
+    };
+}
+
+namespace milecsa::http {
+
+    inflate_body::reader::reader(std::function<std::string()> encoding,
+                                 std::function<bool()> succeeded,
+                                 value_type &body):
+            encoding(std::move(encoding)),
+            succeeded(std::move(succeeded)),
+            body(body) {}
+
+    inflate_body::reader::~reader() = default;
+
+    void inflate_body::reader::init(const boost::optional<std::uint64_t> &length, boost::system::error_code &ec) {
+        ec = {};
+
+        auto coding = encoding();
+
+        if (boost::beast::iequals(coding, "gzip") ||
+            boost::beast::iequals(coding, "x-gzip") ||
+            boost::beast::iequals(coding, "deflate")) {
+            inflater = std::make_unique<detail::Inflater>();
+        }
+
+        body.streamed = false;
+        body.streamed_size = 0;
+
+        if (body.sink && succeeded()) {
+            sink = body.sink;
+            body.streamed = true;
+            body.clear();
+            sink->start();
+        }
+
+        if (!length)
+            return;
+        if (*length > body.max_size()) {
+            ec = boost::beast::http::error::buffer_overflow;
+            return;
+        }
+        if (!inflater && *length > body.limit) {
+            ec = boost::beast::http::error::body_limit;
+            return;
+        }
+        //
+        // compressed length is a lower bound of the decoded one
+        //
+        if (!sink)
+            body.reserve(static_cast<size_t>(*length));
+    }
+
+    void inflate_body::reader::write(const char *data, std::size_t size, boost::system::error_code &ec) {
+        ec = {};
+
+        if (sink) {
+
+            auto room = body.limit - std::min(body.limit, body.streamed_size);
+
+            if (inflater) {
+                decoded.clear();
+                inflater->write(data, size, decoded, room, ec);
+                if (ec)
+                    return;
+                data = decoded.data();
+                size = decoded.size();
+            }
+            else if (size > room) {
+                ec = boost::beast::http::error::body_limit;
+                return;
+            }
+
+            body.streamed_size += size;
+            if (body.size() < detail::streamed_prefix)
+                body.append(data, std::min(size, detail::streamed_prefix - body.size()));
+
+            sink->write(data, size);
+            return;
+        }
+
+        if (inflater)
+            inflater->write(data, size, body, body.limit, ec);
+        else if (size > body.limit - std::min(body.limit, body.size()))
+            ec = boost::beast::http::error::body_limit;
+        else
+            body.append(data, size);
+    }
+
+    void inflate_body::reader::finish(boost::system::error_code &ec) {
+        ec = {};
+        if (inflater)
+            inflater->finish(ec);
+        if (sink && !ec)
+            sink->finish();
+    }
+}
@@ -3,9 +3,12 @@
 #include "milecsa_rpc_id.hpp"
 #include "milecsa_rpc_session.hpp"
 
+#include <algorithm>
+
 namespace milecsa::rpc {
 
     time_t Client::timeout = 3;
+    size_t Client::batch_limit = 100;
 
     using namespace boost::asio::ip;
     namespace ssl = boost::asio::ssl;
@@ -14,6 +17,11 @@ namespace milecsa::rpc {
         url_ = client.url_;
         verify_ssl_=client.verify_ssl_;
         session=std::move(client.session);
+        block_cache=client.block_cache;
+        info_cache=client.info_cache;
+        block_store=client.block_store;
+        block_id_tracker=client.block_id_tracker;
+        context=client.context;
         response_fail_handler=client.response_fail_handler;
         error_handler=client.error_handler;
         return *this;
@@ -23,6 +31,11 @@ namespace milecsa::rpc {
             url_(client.url_),
             verify_ssl_(client.verify_ssl_),
             session(std::move(client.session)),
+            block_cache(client.block_cache),
+            info_cache(client.info_cache),
+            block_store(client.block_store),
+            block_id_tracker(client.block_id_tracker),
+            context(client.context),
             response_fail_handler(client.response_fail_handler),
             error_handler(client.error_handler){}
 
@@ -44,6 +57,28 @@ namespace milecsa::rpc {
         return std::nullopt;
     }
 
+    std::optional<Client> Client::Connect(
+            boost::asio::io_context &ioc,
+            const std::string &urlString,
+            bool verify_ssl,
+            const http::ResponseHandler &response_fail_handler,
+            const milecsa::ErrorHandler &error_handler) {
+        if(auto url = Url::Parse(urlString, error_handler)){
+
+            auto session = std::make_shared<detail::RpcSession>(
+                    ioc,
+                    url->get_host(),
+                    url->get_port(),
+                    url->get_path(),
+                    url->get_protocol(),
+                    verify_ssl,
+                    Client::timeout);
+
+            return Client(*url, session, verify_ssl, response_fail_handler, error_handler);
+        }
+        return std::nullopt;
+    }
+
     Client::Client(
             const milecsa::rpc::Url &url,
             bool verify_ssl,
@@ -65,14 +100,44 @@ namespace milecsa::rpc {
                         Client::timeout));
     }
 
+    Client::Client(
+            const milecsa::rpc::Url &url,
+            const std::shared_ptr<detail::RpcSession> &session,
+            bool verify_ssl,
+            const http::ResponseHandler &response_handler,
+            const ErrorHandler &error_handler) :
+            url_(url),
+            verify_ssl_(verify_ssl),
+            session(session),
+            response_fail_handler(response_handler),
+            error_handler(error_handler){}
+
     Client::~Client(){
         session.reset();
     };
 
+    Client Client::with(const CallContext &context) const {
+        Client client(*this);
+        client.context = context;
+        return client;
+    }
+
+    void Client::set_timeout(std::chrono::milliseconds timeout) {
+        session->set_timeout(timeout);
+    }
+
+    void Client::set_adaptive_timeout(const std::shared_ptr<AdaptiveTimeout> &adaptive) {
+        session->set_adaptive_timeout(adaptive);
+    }
+
+    void Client::set_compression(const http::Compression &settings) {
+        session->set_compression(settings);
+    }
+
 
     std::optional<time_t> Client::ping() const {
         auto start = std::chrono::high_resolution_clock::now();
-        if(auto res = session->request(session->next_command("ping"),response_fail_handler,error_handler)) {
+        if(auto res = session->request(session->next_command("ping"),response_fail_handler,error_handler,context)) {
             if (*res == true || *res == "true") {
                 auto elapsed = std::chrono::high_resolution_clock::now() - start;
                 return std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
@@ -83,52 +148,79 @@ namespace milecsa::rpc {
     }
 
     std::optional<uint256_t> Client::get_current_block_id() const {
-        if(auto json = session->request(session->next_command("get-current-block-id"),response_fail_handler,error_handler)){
-            auto result = *json;
-
-            if (result.empty()) {
-                return std::nullopt;
-            }
-
-            uint256_t block_id;
-            StringToUInt256(result["current-block-id"], block_id, false);
-
-            return block_id;
-        }
+        if (auto current = get<CurrentBlockId>())
+            return current->id;
         return std::nullopt;
     }
 
     rpc::response Client::get_network_state() const {
-        return session->request(session->next_command("get-network-state"),response_fail_handler,error_handler);
+        return session->request(session->next_command("get-network-state"),response_fail_handler,error_handler,context);
     }
 
     rpc::response Client::get_nodes() const {
-        return session->request(session->next_command("get-nodes"),response_fail_handler,error_handler);
+        return session->request(session->next_command("get-nodes"),response_fail_handler,error_handler,context);
     }
 
     rpc::response Client::get_blockchain_info() const {
-        return session->request(session->next_command("get-blockchain-info"),response_fail_handler,error_handler);
+        if (info_cache) {
+            if (auto info = info_cache->get("get-blockchain-info"))
+                return info;
+        }
+        auto info = session->request(session->next_command("get-blockchain-info"),response_fail_handler,error_handler,context);
+        if (info && info_cache)
+            info_cache->put("get-blockchain-info", *info);
+        return info;
     }
 
     rpc::response Client::get_blockchain_state() const {
-        return session->request(session->next_command("get-blockchain-state"),response_fail_handler,error_handler);
+        return session->request(session->next_command("get-blockchain-state"),response_fail_handler,error_handler,context);
     }
 
     rpc::response Client::get_block(uint256_t id) const {
+        if (auto block = find_block(id))
+            return block;
         json command = session->next_command("get-block-by-id", {{"id", id}});
-        return session->request(command,response_fail_handler,error_handler);
+        auto block = session->request(command,response_fail_handler,error_handler,context);
+        if (block)
+            keep_block(id, *block);
+        return block;
+    }
+
+    rpc::response Client::find_block(const uint256_t &id) const {
+
+        if (block_cache) {
+            if (auto block = block_cache->get(id))
+                return block;
+        }
+
+        if (block_store) {
+            if (auto block = block_store->get(id)) {
+                if (block_cache)
+                    block_cache->put(id, *block);
+                return block;
+            }
+        }
+
+        return std::nullopt;
+    }
+
+    void Client::keep_block(const uint256_t &id, const json &block) const {
+        if (block_cache)
+            block_cache->put(id, block);
+        if (block_store)
+            block_store->put(id, block);
     }
 
     rpc::response Client::get_wallet_state(const std::string &publicKey) const {
         json command = session->next_command("get-wallet-state",{{"public-key", publicKey}});
-        return session->request(command,response_fail_handler,error_handler);
+        return session->request(command,response_fail_handler,error_handler,context);
     }
 
     rpc::response Client::get_wallet_transactions(const std::string &publicKey,
                                                   const unsigned int limit) const {
 
         json command = session->next_command("get-wallet-transactions",{{"public-key", publicKey}, {"limit", limit}});
-        return session->request(command,response_fail_handler,error_handler);
+        return session->request(command,response_fail_handler,error_handler,context);
     }
 
 
@@ -144,6 +236,77 @@ namespace milecsa::rpc {
                                            milecsa::rpc::json transactionData) const {
         json command = session->next_command("send-transaction");
         command["params"] = transactionData;
-        return session->request(command,response_fail_handler,error_handler);
+        return session->request(command,response_fail_handler,error_handler,context);
+    }
+
+    bool Client::stream(const std::string &method, const request &params, ResultSax &sax) const {
+        return session->request(session->next_command(method, params), sax, response_fail_handler, error_handler, context);
+    }
+
+    std::vector<rpc::response> Client::batch(const std::vector<std::pair<std::string, request>> &commands) const {
+
+        std::vector<rpc::response> results;
+        results.reserve(commands.size());
+
+        auto limit = std::max<size_t>(batch_limit, 1);
+
+        for (size_t offset = 0; offset < commands.size(); offset += limit) {
+
+            std::vector<rpc::request> chunk;
+            for (size_t i = offset; i < std::min(offset + limit, commands.size()); ++i)
+                chunk.push_back(session->next_command(commands[i].first, commands[i].second));
+
+            for (auto &result: session->batch(chunk, response_fail_handler, error_handler, context))
+                results.push_back(std::move(result));
+        }
+
+        return results;
+    }
+
+    std::vector<rpc::response> Client::pipeline(const std::vector<std::pair<std::string, request>> &commands) const {
+
+        std::vector<rpc::request> requests;
+        requests.reserve(commands.size());
+
+        for (auto &command: commands)
+            requests.push_back(session->next_command(command.first, command.second));
+
+        return session->pipeline(requests, response_fail_handler, error_handler, context);
+    }
+
+    void Client::set_pipeline_depth(size_t depth) {
+        session->set_pipeline_depth(depth);
+    }
+
+    std::vector<rpc::response> Client::get_blocks(const std::vector<uint256_t> &ids) const {
+
+        std::vector<rpc::response> blocks(ids.size());
+        std::vector<size_t> missed;
+        std::vector<std::pair<std::string, request>> commands;
+
+        for (size_t i = 0; i < ids.size(); ++i) {
+            if ((blocks[i] = find_block(ids[i])))
+                continue;
+            missed.push_back(i);
+            commands.emplace_back("get-block-by-id", request({{"id", ids[i]}}));
+        }
+
+        auto received = batch(commands);
+
+        for (size_t i = 0; i < missed.size(); ++i) {
+            blocks[missed[i]] = std::move(received[i]);
+            if (blocks[missed[i]])
+                keep_block(ids[missed[i]], *blocks[missed[i]]);
+        }
+
+        return blocks;
+    }
+
+    std::vector<rpc::response> Client::get_wallet_states(const std::vector<std::string> &publicKeys) const {
+        std::vector<std::pair<std::string, request>> commands;
+        commands.reserve(publicKeys.size());
+        for (auto &publicKey: publicKeys)
+            commands.emplace_back("get-wallet-state", request({{"public-key", publicKey}}));
+        return batch(commands);
     }
 }
\ No newline at end of file
@@ -0,0 +1,197 @@
+//
+// Created by lotus mile on 2026-10-17.
+//
+
+#include "milecsa_jsonrpc.hpp"
+#include "milecsa_rpc_session.hpp"
+
+namespace milecsa::rpc {
+
+    template <typename T>
+    static inline std::future<T> promised(const std::function<void(const std::function<void(const T &)> &)> &call) {
+        auto promise = std::make_shared<std::promise<T>>();
+        call([promise](const T &result){
+            promise->set_value(result);
+        });
+        return promise->get_future();
+    }
+
+    void Client::delivered(const rpc::response &result, const ResultHandler &handler) const {
+        boost::asio::post(session->get_io_context(), [result, handler]{
+            handler(result);
+        });
+    }
+
+    void Client::async_ping(const std::function<void(const std::optional<time_t> &)> &handler) const {
+        auto start = std::chrono::high_resolution_clock::now();
+        session->async_request(session->next_command("ping"), [start, handler](const rpc::response &res){
+            if (!res) {
+                handler(std::nullopt);
+                return;
+            }
+            if (*res == true || *res == "true") {
+                auto elapsed = std::chrono::high_resolution_clock::now() - start;
+                handler(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+                return;
+            }
+            handler(-1);
+        }, response_fail_handler, error_handler, context);
+    }
+
+    std::future<std::optional<time_t>> Client::async_ping() const {
+        return promised<std::optional<time_t>>([this](auto handler){ async_ping(handler); });
+    }
+
+    void Client::async_get_current_block_id(const std::function<void(const std::optional<uint256_t> &)> &handler) const {
+        session->async_request(session->next_command("get-current-block-id"), [handler](const rpc::response &json){
+
+            //
+            // decoded the same way as the sync get_current_block_id,
+            // handler runs inside io context: malformed result must not throw out of run()
+            //
+            if (!json) {
+                handler(std::nullopt);
+                return;
+            }
+
+            auto current = decode_current_block_id(*json);
+            handler(current ? current->id : std::nullopt);
+
+        }, response_fail_handler, error_handler, context);
+    }
+
+    std::future<std::optional<uint256_t>> Client::async_get_current_block_id() const {
+        return promised<std::optional<uint256_t>>([this](auto handler){ async_get_current_block_id(handler); });
+    }
+
+    void Client::async_get_network_state(const ResultHandler &handler) const {
+        session->async_request(session->next_command("get-network-state"), handler, response_fail_handler, error_handler, context);
+    }
+
+    std::future<rpc::response> Client::async_get_network_state() const {
+        return promised<rpc::response>([this](auto handler){ async_get_network_state(handler); });
+    }
+
+    void Client::async_get_nodes(const ResultHandler &handler) const {
+        session->async_request(session->next_command("get-nodes"), handler, response_fail_handler, error_handler, context);
+    }
+
+    std::future<rpc::response> Client::async_get_nodes() const {
+        return promised<rpc::response>([this](auto handler){ async_get_nodes(handler); });
+    }
+
+    void Client::async_get_blockchain_info(const ResultHandler &handler) const {
+
+        if (info_cache) {
+            if (auto info = info_cache->get("get-blockchain-info"))
+                return delivered(info, handler);
+        }
+
+        auto cache = info_cache;
+        session->async_request(session->next_command("get-blockchain-info"), [cache, handler](const rpc::response &info){
+            if (info && cache)
+                cache->put("get-blockchain-info", *info);
+            handler(info);
+        }, response_fail_handler, error_handler, context);
+    }
+
+    std::future<rpc::response> Client::async_get_blockchain_info() const {
+        return promised<rpc::response>([this](auto handler){ async_get_blockchain_info(handler); });
+    }
+
+    void Client::async_get_blockchain_state(const ResultHandler &handler) const {
+        session->async_request(session->next_command("get-blockchain-state"), handler, response_fail_handler, error_handler, context);
+    }
+
+    std::future<rpc::response> Client::async_get_blockchain_state() const {
+        return promised<rpc::response>([this](auto handler){ async_get_blockchain_state(handler); });
+    }
+
+    void Client::async_get_block(uint256_t id, const ResultHandler &handler) const {
+
+        if (auto block = find_block(id))
+            return delivered(block, handler);
+
+        //
+        // Handler can outlive the client, so it keeps its own copy of storages
+        //
+        auto keeper = Client(*this);
+        json command = session->next_command("get-block-by-id", {{"id", id}});
+        session->async_request(command, [keeper, id, handler](const rpc::response &block){
+            if (block)
+                keeper.keep_block(id, *block);
+            handler(block);
+        }, response_fail_handler, error_handler, context);
+    }
+
+    std::future<rpc::response> Client::async_get_block(uint256_t id) const {
+        return promised<rpc::response>([this, id](auto handler){ async_get_block(id, handler); });
+    }
+
+    void Client::async_get_wallet_state(const std::string &publicKey, const ResultHandler &handler) const {
+        json command = session->next_command("get-wallet-state",{{"public-key", publicKey}});
+        session->async_request(command, handler, response_fail_handler, error_handler, context);
+    }
+
+    std::future<rpc::response> Client::async_get_wallet_state(const std::string &publicKey) const {
+        return promised<rpc::response>([this, &publicKey](auto handler){ async_get_wallet_state(publicKey, handler); });
+    }
+
+    void Client::async_get_wallet_state(const milecsa::keys::Pair &pair, const ResultHandler &handler) const {
+        async_get_wallet_state(pair.get_public_key().encode(), handler);
+    }
+
+    std::future<rpc::response> Client::async_get_wallet_state(const milecsa::keys::Pair &pair) const {
+        return async_get_wallet_state(pair.get_public_key().encode());
+    }
+
+    void Client::async_get_wallet_transactions(const std::string &publicKey,
+                                               const unsigned int limit,
+                                               const ResultHandler &handler) const {
+        json command = session->next_command("get-wallet-transactions",{{"public-key", publicKey}, {"limit", limit}});
+        session->async_request(command, handler, response_fail_handler, error_handler, context);
+    }
+
+    std::future<rpc::response> Client::async_get_wallet_transactions(const std::string &publicKey,
+                                                                     const unsigned int limit) const {
+        return promised<rpc::response>([this, &publicKey, limit](auto handler){
+            async_get_wallet_transactions(publicKey, limit, handler);
+        });
+    }
+
+    void Client::async_get_wallet_transactions(const milecsa::keys::Pair &pair,
+                                               const unsigned int limit,
+                                               const ResultHandler &handler) const {
+        async_get_wallet_transactions(pair.get_public_key().encode(), limit, handler);
+    }
+
+    std::future<rpc::response> Client::async_get_wallet_transactions(const milecsa::keys::Pair &pair,
+                                                                     const unsigned int limit) const {
+        return async_get_wallet_transactions(pair.get_public_key().encode(), limit);
+    }
+
+    void Client::async_send_transaction(const milecsa::keys::Pair &pair,
+                                        milecsa::rpc::json transactionData,
+                                        const ResultHandler &handler) const {
+        async_send_transaction(std::move(transactionData), handler);
+    }
+
+    void Client::async_send_transaction(milecsa::rpc::json transactionData, const ResultHandler &handler) const {
+        json command = session->next_command("send-transaction");
+        command["params"] = std::move(transactionData);
+        session->async_request(command, handler, response_fail_handler, error_handler, context);
+    }
+
+    void Client::async_send_transaction(milecsa::rpc::json transactionData, const DeliveryHandler &handler) const {
+        json command = session->next_command("send-transaction");
+        command["params"] = std::move(transactionData);
+        session->async_deliver(command, handler, response_fail_handler, error_handler, context);
+    }
+
+    std::future<rpc::response> Client::async_send_transaction(const milecsa::keys::Pair &pair,
+                                                              milecsa::rpc::json transactionData) const {
+        return promised<rpc::response>([this, &pair, &transactionData](auto handler){
+            async_send_transaction(pair, transactionData, handler);
+        });
+    }
+}
@@ -4,8 +4,14 @@
 
 #include "milecsa_jsonrpc.hpp"
 #include "milecsa_rpc_id.hpp"
+#include "milecsa_trx_id.hpp"
 #include "mile_crypto.h"
 
+#include <array>
+#include <string_view>
+#include <shared_mutex>
+#include <unordered_map>
+
 #ifdef __MILE_SUPPORTS_EMISSION__
 using emission = milecsa::transaction::JsonEmission;
 #endif
@@ -15,128 +21,270 @@ using vote = milecsa::transaction::JsonVote;
 
 namespace milecsa::rpc {
 
-    static std::any transfer(const Client *client,
-                             const std::string &method,
-                             const milecsa::rpc::request &params,
-                             const ErrorHandler &error_handler);
+    static CallResult transfer(const Client &client,
+                               const std::string &method,
+                               const milecsa::rpc::request &params,
+                               const ErrorHandler &error_handler);
 
 #ifdef __MILE_SUPPORTS_EMISSION__
 
-    static std::any emission(const Client *client,
-                             const std::string &method,
-                             const milecsa::rpc::request &params,
-                             const ErrorHandler &error_handler);
+    static CallResult emission(const Client &client,
+                               const std::string &method,
+                               const milecsa::rpc::request &params,
+                               const ErrorHandler &error_handler);
 #endif
 
-    static std::any register_node(const Client *client,
-                                  const std::string &method,
-                                  const milecsa::rpc::request &params,
-                                  const ErrorHandler &error_handler);
+    static CallResult register_node(const Client &client,
+                                    const std::string &method,
+                                    const milecsa::rpc::request &params,
+                                    const ErrorHandler &error_handler);
 
-    static std::any unregister_node(const Client *client,
-                                  const std::string &method,
-                                  const milecsa::rpc::request &params,
-                                  const ErrorHandler &error_handler);
+    static CallResult unregister_node(const Client &client,
+                                      const std::string &method,
+                                      const milecsa::rpc::request &params,
+                                      const ErrorHandler &error_handler);
 
-    static std::any vote_for_rate(const Client *client,
+    static CallResult vote_for_rate(const Client &client,
                                     const std::string &method,
                                     const milecsa::rpc::request &params,
                                     const ErrorHandler &error_handler);
 
-    std::any Client::call(
-            const std::string &method,
-            const milecsa::rpc::request &params) const {
+    static CallResult ping(const Client &client,
+                           const std::string &,
+                           const milecsa::rpc::request &,
+                           const ErrorHandler &) {
+        if (auto t = client.ping())
+            return *t;
+        return {};
+    }
 
-        try {
+    static CallResult get_current_block_id(const Client &client,
+                                           const std::string &,
+                                           const milecsa::rpc::request &,
+                                           const ErrorHandler &) {
+        if (auto t = client.get_current_block_id())
+            return *t;
+        return {};
+    }
 
-            static time_t _trx_counter = 0;
-            srand(time(NULL) + _trx_counter++);
-
-            uint64_t trx_id = rand();
-
-            if (method == "ping") {
-                if (auto t = ping()) {
-                    return std::any_cast<time_t>(*t);
-                }
-            } else if (method == "get-current-block-id") {
-                if (auto t = get_current_block_id()) {
-                    return std::any_cast<uint256_t>(*t);
-                }
-            } else if (method == "get-network-state") {
-                if (auto t = get_network_state()) {
-                    return std::any_cast<rpc::response>(t);
-                }
-            } else if (method == "get-nodes") {
-                if (auto t = get_nodes()) {
-                    return std::any_cast<rpc::response>(t);
-                }
-            } else if (method == "get-blockchain-info") {
-                if (auto t = get_blockchain_info()) {
-                    return std::any_cast<rpc::response>(t);
-                }
-            } else if (method == "get-blockchain-state") {
-                if (auto t = get_blockchain_state()) {
-                    return std::any_cast<rpc::response>(t);
-                }
-            } else if (method == "get-block") {
-                uint256_t id;
-                std::string sid = params["id"];
-                if (StringToUInt256(sid, id, false)) {
-                    if (auto t = get_block(id)) {
-                        return std::any_cast<rpc::response>(t);
-                    }
-                } else {
-                    error_handler(result::FAIL, ErrorFormat(" %s could not convert to uint256_t", method.c_str()));
-                }
-            } else if (method == "get-wallet-state") {
-                if (params.count("public-key") == 0) {
-                    error_handler(result::NOT_FOUND, ErrorFormat("public key %s not defined", method.c_str()));
-                    return std::nullopt;
-                }
-                if (auto t = get_wallet_state(params["public-key"])) {
-                    return std::any_cast<rpc::response>(t);
-                }
-            } else if (method == "get-wallet-transactions") {
-                if (params.count("public-key") == 0) {
-                    error_handler(result::NOT_FOUND, ErrorFormat("public key %s not defined", method.c_str()));
-                    return std::nullopt;
-                }
-                int limit = 1;
-                if (params.count("limit") > 0) {
-                    limit = params["limit"];
-                }
-                if (auto t = get_wallet_transactions(params["public-key"], limit)) {
-                    return std::any_cast<rpc::response>(t);
-                }
-            } else if (method == "send-transfer") {
-
-                return transfer(this, method, params, error_handler);
+    static CallResult get_network_state(const Client &client,
+                                        const std::string &,
+                                        const milecsa::rpc::request &,
+                                        const ErrorHandler &) {
+        if (auto t = client.get_network_state())
+            return *t;
+        return {};
+    }
 
-            }
-#ifdef __MILE_SUPPORTS_EMISSION__
+    static CallResult get_nodes(const Client &client,
+                                const std::string &,
+                                const milecsa::rpc::request &,
+                                const ErrorHandler &) {
+        if (auto t = client.get_nodes())
+            return *t;
+        return {};
+    }
 
-            else if (method == "send-emission") {
+    static CallResult get_blockchain_info(const Client &client,
+                                          const std::string &,
+                                          const milecsa::rpc::request &,
+                                          const ErrorHandler &) {
+        if (auto t = client.get_blockchain_info())
+            return *t;
+        return {};
+    }
 
-                return emission(this, method, params, error_handler);
+    static CallResult get_blockchain_state(const Client &client,
+                                           const std::string &,
+                                           const milecsa::rpc::request &,
+                                           const ErrorHandler &) {
+        if (auto t = client.get_blockchain_state())
+            return *t;
+        return {};
+    }
 
-            }
+    static CallResult get_block(const Client &client,
+                                const std::string &method,
+                                const milecsa::rpc::request &params,
+                                const ErrorHandler &error_handler) {
+        uint256_t id;
+        std::string sid = params["id"];
+        if (!StringToUInt256(sid, id, false)) {
+            error_handler(result::FAIL, ErrorFormat(" %s could not convert to uint256_t", method.c_str()));
+            return {};
+        }
+        if (auto t = client.get_block(id))
+            return *t;
+        return {};
+    }
+
+    static CallResult get_wallet_state(const Client &client,
+                                       const std::string &method,
+                                       const milecsa::rpc::request &params,
+                                       const ErrorHandler &error_handler) {
+        if (params.count("public-key") == 0) {
+            error_handler(result::NOT_FOUND, ErrorFormat("public key %s not defined", method.c_str()));
+            return {};
+        }
+        if (auto t = client.get_wallet_state(params["public-key"].get<std::string>()))
+            return *t;
+        return {};
+    }
+
+    static CallResult get_wallet_transactions(const Client &client,
+                                              const std::string &method,
+                                              const milecsa::rpc::request &params,
+                                              const ErrorHandler &error_handler) {
+        if (params.count("public-key") == 0) {
+            error_handler(result::NOT_FOUND, ErrorFormat("public key %s not defined", method.c_str()));
+            return {};
+        }
+        int limit = 1;
+        if (params.count("limit") > 0) {
+            limit = params["limit"];
+        }
+        if (auto t = client.get_wallet_transactions(params["public-key"].get<std::string>(), limit))
+            return *t;
+        return {};
+    }
+
+    //
+    // Built-in methods dispatch
+    //
+
+    typedef CallResult (*MethodFunction)(const Client &client,
+                                         const std::string &method,
+                                         const milecsa::rpc::request &params,
+                                         const ErrorHandler &error_handler);
+
+    struct MethodDescriptor {
+        std::string_view name;
+        MethodFunction call;
+    };
+
+    static constexpr MethodDescriptor builtin_methods[] = {
+            {"ping",                    ping},
+            {"get-current-block-id",    get_current_block_id},
+            {"get-network-state",       get_network_state},
+            {"get-nodes",               get_nodes},
+            {"get-blockchain-info",     get_blockchain_info},
+            {"get-blockchain-state",    get_blockchain_state},
+            {"get-block",               get_block},
+            {"get-wallet-state",        get_wallet_state},
+            {"get-wallet-transactions", get_wallet_transactions},
+            {"send-transfer",           transfer},
+#ifdef __MILE_SUPPORTS_EMISSION__
+            {"send-emission",           emission},
 #endif
-            else if (method == "register-node") {
+            {"register-node",           register_node},
+            {"unregister-node",         unregister_node},
+            {"vote-for-rate",           vote_for_rate},
+    };
+
+    static constexpr uint64_t method_hash(std::string_view name) {
+        uint64_t hash = 14695981039346656037ull;
+        for (auto c: name) {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
 
-                return register_node(this, method, params, error_handler);
+    /**
+     * The smallest power of two table size where every method gets its own slot
+     */
+    template <size_t N>
+    static constexpr size_t perfect_table_size(const MethodDescriptor (&methods)[N]) {
+        for (size_t size = 1; size <= 4096; size <<= 1) {
+            if (size < N)
+                continue;
+            bool collided = false;
+            for (size_t i = 0; i < N && !collided; ++i)
+                for (size_t j = i + 1; j < N && !collided; ++j)
+                    collided = (method_hash(methods[i].name) & (size - 1)) == (method_hash(methods[j].name) & (size - 1));
+            if (!collided)
+                return size;
+        }
+        return 0;
+    }
 
-            }
-            else if (method == "unregister-node") {
+    template <size_t Size, size_t N>
+    static constexpr std::array<uint8_t, Size> perfect_table(const MethodDescriptor (&methods)[N]) {
+        std::array<uint8_t, Size> slots{};
+        for (size_t i = 0; i < N; ++i)
+            slots[method_hash(methods[i].name) & (Size - 1)] = static_cast<uint8_t>(i + 1);
+        return slots;
+    }
 
-                return unregister_node(this, method, params, error_handler);
+    static constexpr size_t builtin_table_size = perfect_table_size(builtin_methods);
 
-            } else if (method == "vote-for-rate") {
+    static_assert(builtin_table_size > 0, "built-in method names have no perfect hash table");
 
-                return vote_for_rate(this, method, params, error_handler);
+    static constexpr auto builtin_slots = perfect_table<builtin_table_size>(builtin_methods);
 
-            } else {
-                error_handler(result::NOT_FOUND, ErrorFormat("Method %s not found", method.c_str()));
-            }
+    static inline const MethodDescriptor *find_builtin(std::string_view name) {
+        auto slot = builtin_slots[method_hash(name) & (builtin_table_size - 1)];
+        if (slot == 0)
+            return nullptr;
+        auto &method = builtin_methods[slot - 1];
+        return method.name == name ? &method : nullptr;
+    }
+
+    //
+    // User methods
+    //
+
+    struct UserMethods {
+        std::shared_mutex mutex;
+        std::unordered_map<std::string, MethodHandler> handlers;
+    };
+
+    static UserMethods &user_methods() {
+        static UserMethods methods;
+        return methods;
+    }
+
+    static inline std::optional<MethodHandler> find_user(const std::string &name) {
+        auto &methods = user_methods();
+        std::shared_lock<std::shared_mutex> lock(methods.mutex);
+        auto handler = methods.handlers.find(name);
+        if (handler == methods.handlers.end())
+            return std::nullopt;
+        return handler->second;
+    }
+
+    bool Methods::Register(const std::string &name, const MethodHandler &handler) {
+        if (find_builtin(name))
+            return false;
+        auto &methods = user_methods();
+        std::unique_lock<std::shared_mutex> lock(methods.mutex);
+        methods.handlers[name] = handler;
+        return true;
+    }
+
+    void Methods::Unregister(const std::string &name) {
+        auto &methods = user_methods();
+        std::unique_lock<std::shared_mutex> lock(methods.mutex);
+        methods.handlers.erase(name);
+    }
+
+    bool Methods::Contains(const std::string &name) {
+        return find_builtin(name) != nullptr || find_user(name).has_value();
+    }
+
+    CallResult Client::call(
+            const std::string &method,
+            const milecsa::rpc::request &params) const {
+
+        try {
+
+            if (auto builtin = find_builtin(method))
+                return builtin->call(*this, method, params, error_handler);
+
+            if (auto handler = find_user(method))
+                return (*handler)(*this, method, params, error_handler);
+
+            error_handler(result::NOT_FOUND, ErrorFormat("Method %s not found", method.c_str()));
         }
         catch (nlohmann::json::parse_error &e) {
             error_handler(result::EXCEPTION, ErrorFormat("Parser error: %s, %s", method.c_str(), e.what()));
@@ -154,13 +302,22 @@ namespace milecsa::rpc {
             error_handler(result::EXCEPTION, ErrorFormat("Unknown parser error: %s", method.c_str()));
         }
 
-        return std::any();
+        return {};
     }
 
-    static inline uint64_t generate_trx_id() {
-        static time_t _trx_counter = 0;
-        srand(time(NULL) + _trx_counter++);
-        return rand();
+    static inline uint64_t generate_trx_id(const milecsa::keys::Pair &pair) {
+        return TrxIdAllocator::Instance().get_next(pair);
+    }
+
+    /**
+     * Block id of the new transaction, tracked one is taken if it is fresh
+     */
+    static inline std::optional<uint256_t> transaction_block_id(const Client &client) {
+        if (auto &tracker = client.get_block_id_tracker()) {
+            if (auto id = tracker->get())
+                return id;
+        }
+        return client.get_current_block_id();
     }
 
     static inline std::optional<milecsa::keys::Pair> get_private(
@@ -170,7 +327,7 @@ namespace milecsa::rpc {
 
         if (params.count("private-key") == 0) {
             error_handler(result::NOT_FOUND, ErrorFormat("source private key %s not defined", method.c_str()));
-            return std::nullopt;
+            return {};
         }
         return milecsa::keys::Pair::FromPrivateKey(params["private-key"], error_handler);
     }
@@ -183,34 +340,34 @@ namespace milecsa::rpc {
 
         if (params.count("asset-code") == 0) {
             error_handler(result::NOT_FOUND, ErrorFormat("asset-code %s not defined", method.c_str()));
-            return std::nullopt;
+            return {};
         }
         unsigned short asset_code = params["asset-code"];
         return milecsa::assets::TokenFromCode(asset_code);
     }
 
-    std::any transfer(const Client *client,
-                      const std::string &method,
-                      const milecsa::rpc::request &params,
-                      const ErrorHandler &error_handler) {
+    CallResult transfer(const Client &client,
+                        const std::string &method,
+                        const milecsa::rpc::request &params,
+                        const ErrorHandler &error_handler) {
 
         if (params.count("to") == 0) {
             error_handler(result::NOT_FOUND,
                           ErrorFormat("destination public key %s not defined", method.c_str()));
-            return std::nullopt;
+            return {};
         }
 
         auto ppk = get_private(method,params,error_handler);
-        if (!ppk)  return std::nullopt;
+        if (!ppk)  return {};
 
         if (params.count("amount") == 0) {
             error_handler(result::NOT_FOUND, ErrorFormat("amount %s not defined", method.c_str()));
-            return std::nullopt;
+            return {};
         }
         float amount = params["amount"];
 
         auto asset = get_asset(method,params,error_handler);
-        if (!asset)  return std::nullopt;
+        if (!asset)  return {};
 
         std::string description;
 
@@ -218,14 +375,15 @@ namespace milecsa::rpc {
             description = params["description"];
         }
 
-        auto block_id = *client->get_current_block_id();
+        auto block_id = transaction_block_id(client);
+        if (!block_id)  return {};
 
         auto request = transfer::CreateRequest(
                 *ppk,
                 params["to"],
-                block_id,            // block id
-                generate_trx_id(),   // trx id
-                *asset,              // asset
+                *block_id,               // block id
+                generate_trx_id(*ppk),   // trx id
+                *asset,                  // asset
                 amount,
                 0.0,
                 description,
@@ -235,35 +393,36 @@ namespace milecsa::rpc {
 
             auto json_body = request->dump();
 
-            if (auto t = client->send_transaction(*ppk, *request)) {
-                return std::any_cast<rpc::response>(t);
+            if (auto t = client.send_transaction(*ppk, *request)) {
+                return *t;
             }
         }
 
-        return std::any();
+        return {};
     }
 
 #ifdef __MILE_SUPPORTS_EMISSION__
 
-    std::any emission(
-            const Client *client,
+    CallResult emission(
+            const Client &client,
             const std::string &method,
             const milecsa::rpc::request &params,
             const ErrorHandler &error_handler) {
 
         auto ppk = get_private(method,params,error_handler);
-        if (!ppk)  return std::nullopt;
+        if (!ppk)  return {};
 
         auto asset = get_asset(method,params,error_handler);
-        if (!asset)  return std::nullopt;
+        if (!asset)  return {};
 
-        auto block_id = *client->get_current_block_id();
+        auto block_id = transaction_block_id(client);
+        if (!block_id)  return {};
 
         auto request = emission::CreateRequest(
                 *ppk,
-                block_id,          // block id
-                generate_trx_id(), // trx id
-                *asset,            // asset code
+                *block_id,             // block id
+                generate_trx_id(*ppk), // trx id
+                *asset,                // asset code
                 0.0,
                 error_handler)->get_body();
 
@@ -271,42 +430,43 @@ namespace milecsa::rpc {
 
             auto json_body = request->dump();
 
-            if (auto t = client->send_transaction(*ppk, *request)) {
-                return std::any_cast<rpc::response>(t);
+            if (auto t = client.send_transaction(*ppk, *request)) {
+                return *t;
             }
         }
 
-        return std::any();
+        return {};
     }
 #endif
-    std::any register_node(
-            const Client *client,
+    CallResult register_node(
+            const Client &client,
             const std::string &method,
             const milecsa::rpc::request &params,
             const ErrorHandler &error_handler) {
 
         auto ppk = get_private(method,params,error_handler);
-        if (!ppk)  return std::nullopt;
+        if (!ppk)  return {};
 
         if ( params.count("amount") == 0) {
             error_handler(result::NOT_FOUND, ErrorFormat("amount %s not defined", method.c_str()));
-            return std::nullopt;
+            return {};
         }
         float amount = params["amount"];
 
         if (params.count("address") == 0) {
             error_handler(result::NOT_FOUND, ErrorFormat("address %s not defined", method.c_str()));
-            return std::nullopt;
+            return {};
         }
         auto address = params["address"];
 
-        auto block_id = *client->get_current_block_id();
+        auto block_id = transaction_block_id(client);
+        if (!block_id)  return {};
 
         auto request = node::CreateRegisterRequest(
                 *ppk,
                 address,
-                block_id,
-                generate_trx_id(),
+                *block_id,
+                generate_trx_id(*ppk),
                 amount,
                 0.0,
                 error_handler)->get_body();
@@ -315,29 +475,30 @@ namespace milecsa::rpc {
 
             auto json_body = request->dump();
 
-            if (auto t = client->send_transaction(*ppk, *request)) {
-                return std::any_cast<rpc::response>(t);
+            if (auto t = client.send_transaction(*ppk, *request)) {
+                return *t;
             }
         }
 
-        return std::any();
+        return {};
     }
 
-    std::any unregister_node(
-            const Client *client,
+    CallResult unregister_node(
+            const Client &client,
             const std::string &method,
             const milecsa::rpc::request &params,
             const ErrorHandler &error_handler) {
 
         auto ppk = get_private(method,params,error_handler);
-        if (!ppk)  return std::nullopt;
+        if (!ppk)  return {};
 
-        auto block_id = *client->get_current_block_id();
+        auto block_id = transaction_block_id(client);
+        if (!block_id)  return {};
 
         auto request = node::CreateUnregisterRequest(
                 *ppk,
-                block_id,
-                generate_trx_id(),
+                *block_id,
+                generate_trx_id(*ppk),
                 0,
                 error_handler)->get_body();
 
@@ -345,36 +506,37 @@ namespace milecsa::rpc {
 
             auto json_body = request->dump();
 
-            if (auto t = client->send_transaction(*ppk, *request)) {
-                return std::any_cast<rpc::response>(t);
+            if (auto t = client.send_transaction(*ppk, *request)) {
+                return *t;
             }
         }
 
-        return std::any();
+        return {};
     }
 
-    static std::any vote_for_rate(const Client *client,
-                                  const std::string &method,
-                                  const milecsa::rpc::request &params,
-                                  const ErrorHandler &error_handler){
+    static CallResult vote_for_rate(const Client &client,
+                                    const std::string &method,
+                                    const milecsa::rpc::request &params,
+                                    const ErrorHandler &error_handler){
         auto ppk = get_private(method,params,error_handler);
-        if (!ppk)  return std::nullopt;
+        if (!ppk)  return {};
 
 //        auto asset = get_asset(method,params,error_handler);
-//        if (!asset)  return std::nullopt;
+//        if (!asset)  return {};
 
         if (params.count("amount") == 0) {
             error_handler(result::NOT_FOUND, ErrorFormat("amount %s not defined", method.c_str()));
-            return std::nullopt;
+            return {};
         }
         float amount = params["amount"];
 
-        auto block_id = *client->get_current_block_id();
+        auto block_id = transaction_block_id(client);
+        if (!block_id)  return {};
 
         auto request = vote::CreateRequest(
                 *ppk,
-                block_id,
-                generate_trx_id(),
+                *block_id,
+                generate_trx_id(*ppk),
                 //*asset,
                 amount,
                 0,
@@ -384,11 +546,11 @@ namespace milecsa::rpc {
 
             auto json_body = request->dump();
 
-            if (auto t = client->send_transaction(*ppk, *request)) {
-                return std::any_cast<rpc::response>(t);
+            if (auto t = client.send_transaction(*ppk, *request)) {
+                return *t;
             }
         }
 
-        return std::any();
+        return {};
     }
 }
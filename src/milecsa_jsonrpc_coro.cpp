@@ -0,0 +1,127 @@
+//
+// Created by lotus mile on 2026-10-17.
+//
+
+#include "milecsa_jsonrpc_coro.hpp"
+
+#if defined(BOOST_ASIO_HAS_CO_AWAIT)
+
+namespace milecsa::rpc {
+
+    /**
+     * Suspend the caller coroutine until the callback call is completed
+     * @param call - starts Client::async_* call with completion handler
+     * @return call result
+     */
+    template <typename T>
+    static awaitable<T> suspend(std::function<void(const std::function<void(const T &)> &)> call) {
+        co_return co_await boost::asio::async_initiate<decltype(boost::asio::use_awaitable), void(T)>(
+                [call](auto handler) {
+                    //
+                    // coroutine handler is move only, client handlers are copyable
+                    //
+                    auto shared = std::make_shared<decltype(handler)>(std::move(handler));
+                    call([shared](const T &result) {
+                        auto executor = boost::asio::get_associated_executor(*shared);
+                        boost::asio::dispatch(executor, [shared, result]() mutable {
+                            (*shared)(std::move(result));
+                        });
+                    });
+                },
+                boost::asio::use_awaitable);
+    }
+
+    std::optional<CoClient> CoClient::Connect(
+            boost::asio::io_context &ioc,
+            const std::string &urlString,
+            bool verify_ssl,
+            const http::ResponseHandler &response_fail_handler,
+            const milecsa::ErrorHandler &error_handler) {
+        if (auto client = Client::Connect(ioc, urlString, verify_ssl, response_fail_handler, error_handler))
+            return CoClient(*client);
+        return std::nullopt;
+    }
+
+    awaitable<std::optional<time_t>> CoClient::ping() const {
+        auto client = client_;
+        co_return co_await suspend<std::optional<time_t>>([client](auto handler){
+            client.async_ping(handler);
+        });
+    }
+
+    awaitable<std::optional<uint256_t>> CoClient::get_current_block_id() const {
+        auto client = client_;
+        co_return co_await suspend<std::optional<uint256_t>>([client](auto handler){
+            client.async_get_current_block_id(handler);
+        });
+    }
+
+    awaitable<rpc::response> CoClient::get_network_state() const {
+        auto client = client_;
+        co_return co_await suspend<rpc::response>([client](auto handler){
+            client.async_get_network_state(handler);
+        });
+    }
+
+    awaitable<rpc::response> CoClient::get_nodes() const {
+        auto client = client_;
+        co_return co_await suspend<rpc::response>([client](auto handler){
+            client.async_get_nodes(handler);
+        });
+    }
+
+    awaitable<rpc::response> CoClient::get_blockchain_info() const {
+        auto client = client_;
+        co_return co_await suspend<rpc::response>([client](auto handler){
+            client.async_get_blockchain_info(handler);
+        });
+    }
+
+    awaitable<rpc::response> CoClient::get_blockchain_state() const {
+        auto client = client_;
+        co_return co_await suspend<rpc::response>([client](auto handler){
+            client.async_get_blockchain_state(handler);
+        });
+    }
+
+    awaitable<rpc::response> CoClient::get_block(uint256_t id) const {
+        auto client = client_;
+        co_return co_await suspend<rpc::response>([client, id](auto handler){
+            client.async_get_block(id, handler);
+        });
+    }
+
+    awaitable<rpc::response> CoClient::get_wallet_state(std::string publicKey) const {
+        auto client = client_;
+        co_return co_await suspend<rpc::response>([client, publicKey](auto handler){
+            client.async_get_wallet_state(publicKey, handler);
+        });
+    }
+
+    awaitable<rpc::response> CoClient::get_wallet_state(const milecsa::keys::Pair &pair) const {
+        return get_wallet_state(pair.get_public_key().encode());
+    }
+
+    awaitable<rpc::response> CoClient::get_wallet_transactions(std::string publicKey,
+                                                               const unsigned int limit) const {
+        auto client = client_;
+        co_return co_await suspend<rpc::response>([client, publicKey, limit](auto handler){
+            client.async_get_wallet_transactions(publicKey, limit, handler);
+        });
+    }
+
+    awaitable<rpc::response> CoClient::get_wallet_transactions(const milecsa::keys::Pair &pair,
+                                                               const unsigned int limit) const {
+        return get_wallet_transactions(pair.get_public_key().encode(), limit);
+    }
+
+    awaitable<rpc::response> CoClient::send_transaction(milecsa::keys::Pair pair,
+                                                        json transactionData) const {
+        auto client = client_;
+        co_return co_await suspend<rpc::response>([client, pair, transactionData](auto handler){
+            client.async_send_transaction(pair, transactionData, handler);
+        });
+    }
+}
+
+#endif
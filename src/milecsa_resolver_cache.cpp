@@ -0,0 +1,215 @@
+//
+// Created by lotus mile on 2026-10-17.
+//
+
+#include "milecsa_resolver_cache.hpp"
+
+#include <mutex>
+#include <thread>
+#include <future>
+#include <unordered_map>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/executor_work_guard.hpp>
+
+namespace milecsa::rpc::detail {
+
+    typedef std::chrono::steady_clock clock;
+
+    using tcp = boost::asio::ip::tcp;
+
+    struct ResolverEntry {
+        ResolverCache::Endpoints endpoints;
+        clock::time_point expires;
+        bool resolving = false;
+        bool expired = false;
+        std::vector<ResolverCache::Handler> waiters;
+    };
+
+    class ResolverState {
+
+    public:
+
+        ResolverState():
+                work(boost::asio::make_work_guard(ioc)),
+                ttl(60){
+            thread = std::thread([this]{ ioc.run(); });
+        }
+
+        ~ResolverState() {
+            work.reset();
+            ioc.stop();
+            if (thread.joinable())
+                thread.join();
+        }
+
+        /**
+         * Start query of the entry, must be called under lock
+         */
+        void lookup(const std::string &key, const std::string &host, const std::string &port, ResolverEntry &entry) {
+
+            if (entry.resolving)
+                return;
+
+            entry.resolving = true;
+
+            auto resolver = std::make_shared<tcp::resolver>(ioc);
+            resolver->async_resolve(host, port, [this, key, resolver](
+                    const boost::system::error_code &ec,
+                    tcp::resolver::results_type results){
+                resolved(key, ec, results);
+            });
+        }
+
+        std::mutex mutex;
+        std::unordered_map<std::string, ResolverEntry> entries;
+
+        boost::asio::io_context ioc;
+        boost::asio::executor_work_guard<boost::asio::io_context::executor_type> work;
+        std::thread thread;
+
+        std::chrono::seconds ttl;
+
+    private:
+
+        void resolved(const std::string &key, boost::system::error_code ec, const tcp::resolver::results_type &results) {
+
+            std::vector<ResolverCache::Handler> waiters;
+            ResolverCache::Endpoints endpoints;
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+
+                auto &entry = entries[key];
+                entry.resolving = false;
+
+                if (!ec && results.empty())
+                    ec = boost::asio::error::host_not_found;
+
+                //
+                // failed query keeps stale endpoints, they are taken at once until the next lookup
+                // queries again
+                //
+                if (!ec) {
+                    entry.endpoints = interleave(results);
+                    entry.expires = clock::now() + ttl;
+                }
+                entry.expired = false;
+
+                endpoints = entry.endpoints;
+                waiters = std::move(entry.waiters);
+                entry.waiters.clear();
+
+                if (entry.endpoints.empty())
+                    entries.erase(key);
+            }
+
+            if (!endpoints.empty())
+                ec = {};
+
+            for (auto &waiter: waiters)
+                waiter(ec, endpoints);
+        }
+
+        /**
+         * Alternate address families starting from the first resolved one
+         */
+        static ResolverCache::Endpoints interleave(const tcp::resolver::results_type &results) {
+
+            ResolverCache::Endpoints first, second;
+
+            auto v6 = results.begin()->endpoint().address().is_v6();
+
+            for (auto &result: results) {
+                if (result.endpoint().address().is_v6() == v6)
+                    first.push_back(result.endpoint());
+                else
+                    second.push_back(result.endpoint());
+            }
+
+            ResolverCache::Endpoints endpoints;
+            endpoints.reserve(first.size() + second.size());
+
+            for (size_t i = 0; i < std::max(first.size(), second.size()); ++i) {
+                if (i < first.size())
+                    endpoints.push_back(first[i]);
+                if (i < second.size())
+                    endpoints.push_back(second[i]);
+            }
+
+            return endpoints;
+        }
+    };
+
+    static inline std::string entry_key(const std::string &host, const std::string &port) {
+        return host + ":" + port;
+    }
+}
+
+namespace milecsa::rpc {
+
+    ResolverCache& ResolverCache::Instance() {
+        static ResolverCache myInstance;
+        return myInstance;
+    }
+
+    ResolverCache::ResolverCache(): state(std::make_unique<detail::ResolverState>()) {}
+
+    ResolverCache::~ResolverCache() {}
+
+    void ResolverCache::set_ttl(std::chrono::seconds ttl) {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->ttl = ttl;
+    }
+
+    void ResolverCache::async_resolve(const std::string &host, const std::string &port, const Handler &handler) {
+
+        Endpoints endpoints;
+
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+
+            auto key = detail::entry_key(host, port);
+            auto &entry = state->entries[key];
+
+            //
+            // endpoints expired by a connection failure are taken only if the fresh query fails
+            //
+            if (entry.endpoints.empty() || entry.expired) {
+                entry.waiters.push_back(handler);
+                state->lookup(key, host, port, entry);
+                return;
+            }
+
+            if (entry.expires <= detail::clock::now())
+                state->lookup(key, host, port, entry);
+
+            endpoints = entry.endpoints;
+        }
+
+        handler({}, endpoints);
+    }
+
+    ResolverCache::Endpoints ResolverCache::resolve(const std::string &host,
+                                                    const std::string &port,
+                                                    boost::system::error_code &ec) {
+
+        std::promise<std::pair<boost::system::error_code, Endpoints>> promise;
+
+        async_resolve(host, port, [&promise](const boost::system::error_code &error, const Endpoints &endpoints){
+            promise.set_value({error, endpoints});
+        });
+
+        auto result = promise.get_future().get();
+        ec = result.first;
+        return result.second;
+    }
+
+    void ResolverCache::expire(const std::string &host, const std::string &port) {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        auto entry = state->entries.find(detail::entry_key(host, port));
+        if (entry != state->entries.end()) {
+            entry->second.expires = detail::clock::now();
+            entry->second.expired = true;
+        }
+    }
+}
@@ -0,0 +1,126 @@
+//
+// Created by lotus mile on 2026-10-17.
+//
+
+#include "milecsa_rpc_deadline.hpp"
+
+#include <atomic>
+#include <map>
+#include <algorithm>
+#include <cmath>
+
+namespace milecsa::rpc::detail {
+
+    class CancelState {
+
+    public:
+
+        std::atomic<bool> cancelled{false};
+        std::mutex mutex;
+        std::map<size_t, CancelToken::Callback> callbacks;
+        size_t next_id = 1;
+    };
+
+    /**
+     * Weights of the last sample in the smoothed latency and deviation
+     */
+    static const double latency_weight = 0.125;
+    static const double deviation_weight = 0.25;
+}
+
+namespace milecsa::rpc {
+
+    //
+    // CancelToken
+    //
+
+    CancelToken::CancelToken(): state(std::make_shared<detail::CancelState>()) {}
+
+    void CancelToken::cancel() const {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (state->cancelled.exchange(true))
+            return;
+        for (auto &callback: state->callbacks)
+            callback.second();
+    }
+
+    bool CancelToken::is_cancelled() const {
+        return state->cancelled.load(std::memory_order_acquire);
+    }
+
+    size_t CancelToken::subscribe(const Callback &callback) const {
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (!state->cancelled) {
+                auto id = state->next_id++;
+                state->callbacks.emplace(id, callback);
+                return id;
+            }
+        }
+        callback();
+        return 0;
+    }
+
+    void CancelToken::unsubscribe(size_t id) const {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->callbacks.erase(id);
+    }
+
+    //
+    // CallContext
+    //
+
+    CallContext CallContext::Timeout(std::chrono::milliseconds timeout, const std::optional<CancelToken> &token) {
+        return {clock::now() + timeout, token};
+    }
+
+    bool CallContext::is_cancelled() const {
+        return token && token->is_cancelled();
+    }
+
+    bool CallContext::is_expired() const {
+        return deadline && *deadline <= clock::now();
+    }
+
+    std::chrono::milliseconds CallContext::bound(std::chrono::milliseconds timeout) const {
+        if (!deadline)
+            return timeout;
+        auto rest = std::chrono::ceil<std::chrono::milliseconds>(*deadline - clock::now());
+        return std::clamp(rest, std::chrono::milliseconds(0), timeout);
+    }
+
+    //
+    // AdaptiveTimeout
+    //
+
+    AdaptiveTimeout::AdaptiveTimeout(std::chrono::milliseconds min,
+                                     std::chrono::milliseconds max,
+                                     double multiplier):
+            min(min),
+            max(std::max(min, max)),
+            multiplier(multiplier),
+            latency(0),
+            deviation(0),
+            observed(false) {}
+
+    void AdaptiveTimeout::observe(std::chrono::microseconds sample) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto value = static_cast<double>(sample.count());
+        if (!observed) {
+            latency = value;
+            deviation = value / 2;
+            observed = true;
+            return;
+        }
+        deviation = (1 - detail::deviation_weight) * deviation + detail::deviation_weight * std::fabs(latency - value);
+        latency = (1 - detail::latency_weight) * latency + detail::latency_weight * value;
+    }
+
+    std::chrono::milliseconds AdaptiveTimeout::get() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!observed)
+            return max;
+        auto timeout = std::chrono::milliseconds(static_cast<int64_t>(std::ceil((latency + multiplier * deviation) / 1000)));
+        return std::clamp(timeout, min, max);
+    }
+}
@@ -0,0 +1,750 @@
+//
+// Created by lotus mile on 2026-10-17.
+//
+
+#include "milecsa_rpc_sax.hpp"
+
+#include <charconv>
+#include <cmath>
+#include <locale>
+#include <sstream>
+
+namespace milecsa::rpc::detail {
+
+    //
+    // DomSax
+    //
+
+    nlohmann::json *DomSax::add(nlohmann::json &&val) {
+
+        if (stack.empty()) {
+            value = std::move(val);
+            return &value;
+        }
+
+        auto &top = *stack.back();
+
+        if (top.is_array()) {
+            top.push_back(std::move(val));
+            return &top.back();
+        }
+
+        auto &slot = top[pending_key];
+        slot = std::move(val);
+        return &slot;
+    }
+
+    bool DomSax::null() {
+        add(nullptr);
+        return true;
+    }
+
+    bool DomSax::boolean(bool val) {
+        add(val);
+        return true;
+    }
+
+    bool DomSax::number_integer(number_integer_t val) {
+        add(val);
+        return true;
+    }
+
+    bool DomSax::number_unsigned(number_unsigned_t val) {
+        add(val);
+        return true;
+    }
+
+    bool DomSax::number_float(number_float_t val, const string_t &) {
+        add(val);
+        return true;
+    }
+
+    bool DomSax::string(string_t &val) {
+        add(std::move(val));
+        return true;
+    }
+
+#ifdef MILECSA_JSON_SAX_BINARY
+    bool DomSax::binary(binary_t &val) {
+        add(nlohmann::json::binary(std::move(val)));
+        return true;
+    }
+#endif
+
+    bool DomSax::start_object(std::size_t) {
+        stack.push_back(add(nlohmann::json::object()));
+        return true;
+    }
+
+    bool DomSax::key(string_t &val) {
+        pending_key = std::move(val);
+        return true;
+    }
+
+    bool DomSax::end_object() {
+        stack.pop_back();
+        return true;
+    }
+
+    bool DomSax::start_array(std::size_t) {
+        stack.push_back(add(nlohmann::json::array()));
+        return true;
+    }
+
+    bool DomSax::end_array() {
+        stack.pop_back();
+        return true;
+    }
+
+    bool DomSax::parse_error(std::size_t, const std::string &, const nlohmann::detail::exception &) {
+        return false;
+    }
+
+    //
+    // EnvelopeSax
+    //
+
+    void EnvelopeSax::reset() {
+        id.reset();
+        has_result = false;
+        stopped = false;
+        error.reset();
+        depth = 0;
+        result_depth = 0;
+        in_result = false;
+        current_key.clear();
+    }
+
+    template <typename Call>
+    bool EnvelopeSax::forward(Call call) {
+        if (!stopped && !call())
+            stopped = true;
+        return true;
+    }
+
+    template <typename Call>
+    bool EnvelopeSax::result_scalar(bool is_null, Call call) {
+        if (result_depth == 0) {
+            in_result = false;
+            has_result = !is_null;
+        }
+        return forward(call);
+    }
+
+    bool EnvelopeSax::envelope_scalar(const nlohmann::json &val) {
+        //
+        // null id of an error reply is not compared with the request id
+        //
+        if (depth == 1 && current_key == "id" && !val.is_null())
+            id = val.is_string() ? val.get<std::string>() : val.dump();
+        return true;
+    }
+
+    bool EnvelopeSax::null() {
+        if (in_result)
+            return result_scalar(true, [&]{ return sink.null(); });
+        return envelope_scalar(nullptr);
+    }
+
+    bool EnvelopeSax::boolean(bool val) {
+        if (in_result)
+            return result_scalar(false, [&]{ return sink.boolean(val); });
+        return envelope_scalar(val);
+    }
+
+    bool EnvelopeSax::number_integer(number_integer_t val) {
+        if (in_result)
+            return result_scalar(false, [&]{ return sink.number_integer(val); });
+        return envelope_scalar(val);
+    }
+
+    bool EnvelopeSax::number_unsigned(number_unsigned_t val) {
+        if (in_result)
+            return result_scalar(false, [&]{ return sink.number_unsigned(val); });
+        return envelope_scalar(val);
+    }
+
+    bool EnvelopeSax::number_float(number_float_t val, const string_t &s) {
+        if (in_result)
+            return result_scalar(false, [&]{ return sink.number_float(val, s); });
+        return envelope_scalar(val);
+    }
+
+    bool EnvelopeSax::string(string_t &val) {
+        if (in_result)
+            return result_scalar(false, [&]{ return sink.string(val); });
+        return envelope_scalar(val);
+    }
+
+#ifdef MILECSA_JSON_SAX_BINARY
+    bool EnvelopeSax::binary(binary_t &val) {
+        if (in_result)
+            return result_scalar(false, [&]{ return sink.binary(val); });
+        return true;
+    }
+#endif
+
+    bool EnvelopeSax::start_object(std::size_t elements) {
+        if (!in_result) {
+            ++depth;
+            return true;
+        }
+        if (result_depth++ == 0)
+            has_result = true;
+        return forward([&]{ return sink.start_object(elements); });
+    }
+
+    bool EnvelopeSax::key(string_t &val) {
+        if (in_result)
+            return forward([&]{ return sink.key(val); });
+        if (depth == 1) {
+            current_key = val;
+            in_result = current_key == "result";
+            result_depth = 0;
+        }
+        return true;
+    }
+
+    bool EnvelopeSax::end_object() {
+        if (!in_result) {
+            --depth;
+            return true;
+        }
+        if (--result_depth == 0)
+            in_result = false;
+        return forward([&]{ return sink.end_object(); });
+    }
+
+    bool EnvelopeSax::start_array(std::size_t elements) {
+        if (!in_result) {
+            ++depth;
+            return true;
+        }
+        if (result_depth++ == 0)
+            has_result = true;
+        return forward([&]{ return sink.start_array(elements); });
+    }
+
+    bool EnvelopeSax::end_array() {
+        if (!in_result) {
+            --depth;
+            return true;
+        }
+        if (--result_depth == 0)
+            in_result = false;
+        return forward([&]{ return sink.end_array(); });
+    }
+
+    bool EnvelopeSax::parse_error(std::size_t position,
+                                  const std::string &last_token,
+                                  const nlohmann::detail::exception &ex) {
+        error = ex.what();
+        return false;
+    }
+
+    //
+    // JsonPushParser
+    //
+
+    static bool is_space(char c) {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    static bool is_digit(char c) {
+        return c >= '0' && c <= '9';
+    }
+
+    static int hex_value(char c) {
+        if (c >= '0' && c <= '9')
+            return c - '0';
+        if (c >= 'a' && c <= 'f')
+            return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F')
+            return c - 'A' + 10;
+        return -1;
+    }
+
+    static void append_utf8(std::string &out, uint32_t code) {
+        if (code < 0x80)
+            out.push_back(static_cast<char>(code));
+        else if (code < 0x800) {
+            out.push_back(static_cast<char>(0xc0 | (code >> 6)));
+            out.push_back(static_cast<char>(0x80 | (code & 0x3f)));
+        }
+        else if (code < 0x10000) {
+            out.push_back(static_cast<char>(0xe0 | (code >> 12)));
+            out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3f)));
+            out.push_back(static_cast<char>(0x80 | (code & 0x3f)));
+        }
+        else {
+            out.push_back(static_cast<char>(0xf0 | (code >> 18)));
+            out.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3f)));
+            out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3f)));
+            out.push_back(static_cast<char>(0x80 | (code & 0x3f)));
+        }
+    }
+
+    /**
+     * Number grammar of RFC 8259
+     */
+    static bool valid_number(const std::string &s, bool &is_integer) {
+        size_t i = 0, n = s.size();
+        auto digits = [&]{
+            auto from = i;
+            while (i < n && is_digit(s[i]))
+                ++i;
+            return i > from;
+        };
+
+        if (i < n && s[i] == '-')
+            ++i;
+        if (i < n && s[i] == '0')
+            ++i;
+        else if (!digits())
+            return false;
+
+        is_integer = true;
+
+        if (i < n && s[i] == '.') {
+            ++i;
+            is_integer = false;
+            if (!digits())
+                return false;
+        }
+
+        if (i < n && (s[i] == 'e' || s[i] == 'E')) {
+            ++i;
+            is_integer = false;
+            if (i < n && (s[i] == '+' || s[i] == '-'))
+                ++i;
+            if (!digits())
+                return false;
+        }
+
+        return i == n;
+    }
+
+    void JsonPushParser::reset() {
+        error.reset();
+        stopped = false;
+        containers.clear();
+        state = expect::value;
+        lexeme = token::none;
+        text.clear();
+        is_key = false;
+        escape = false;
+        hex_digits = 0;
+        code_point = 0;
+        high_surrogate = 0;
+        utf8_pending = 0;
+        utf8_low = 0x80;
+        utf8_high = 0xbf;
+        position = 0;
+    }
+
+    bool JsonPushParser::write(const char *data, size_t size) {
+        for (size_t i = 0; i < size && !error && !stopped; ++i, ++position)
+            consume(data[i]);
+        return !error && !stopped;
+    }
+
+    bool JsonPushParser::finish() {
+        if (error || stopped)
+            return !error;
+
+        if (lexeme == token::number)
+            emit_number();
+        else if (lexeme == token::literal)
+            emit_literal();
+        else if (lexeme == token::string)
+            return fail("unterminated string");
+
+        if (!error && !stopped && state != expect::done)
+            return fail("unexpected end of input");
+
+        return !error;
+    }
+
+    bool JsonPushParser::fail(const std::string &what) {
+        error = what + " at " + std::to_string(position);
+        return false;
+    }
+
+    bool JsonPushParser::stop() {
+        stopped = true;
+        return false;
+    }
+
+    bool JsonPushParser::consume(char c) {
+
+        switch (lexeme) {
+
+            case token::string:
+                return string_char(c);
+
+            case token::number:
+                if (is_digit(c) || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E') {
+                    text.push_back(c);
+                    return true;
+                }
+                if (!emit_number())
+                    return false;
+                break;
+
+            case token::literal:
+                if (c >= 'a' && c <= 'z') {
+                    text.push_back(c);
+                    return true;
+                }
+                if (!emit_literal())
+                    return false;
+                break;
+
+            case token::none:
+                break;
+        }
+
+        return structural(c);
+    }
+
+    bool JsonPushParser::structural(char c) {
+
+        if (is_space(c))
+            return true;
+
+        switch (state) {
+
+            case expect::done:
+                return fail("unexpected character after value");
+
+            case expect::colon:
+                if (c != ':')
+                    return fail("expected ':'");
+                state = expect::value;
+                return true;
+
+            case expect::key_or_end_object:
+                if (c == '}')
+                    return close('{');
+                [[fallthrough]];
+
+            case expect::key:
+                if (c != '"')
+                    return fail("expected object key");
+                lexeme = token::string;
+                is_key = true;
+                text.clear();
+                return true;
+
+            case expect::comma_or_end:
+                if (c == ',') {
+                    state = containers.back() == '{' ? expect::key : expect::value;
+                    return true;
+                }
+                if (c == '}')
+                    return close('{');
+                if (c == ']')
+                    return close('[');
+                return fail("expected ',' or end of container");
+
+            case expect::value_or_end_array:
+                if (c == ']')
+                    return close('[');
+                [[fallthrough]];
+
+            case expect::value:
+                return value_start(c);
+        }
+
+        return fail("unexpected character");
+    }
+
+    bool JsonPushParser::value_start(char c) {
+
+        if (c == '{') {
+            containers.push_back('{');
+            state = expect::key_or_end_object;
+            return sax.start_object(std::size_t(-1)) || stop();
+        }
+
+        if (c == '[') {
+            containers.push_back('[');
+            state = expect::value_or_end_array;
+            return sax.start_array(std::size_t(-1)) || stop();
+        }
+
+        if (c == '"') {
+            lexeme = token::string;
+            is_key = false;
+            text.clear();
+            return true;
+        }
+
+        if (c == '-' || is_digit(c)) {
+            lexeme = token::number;
+            text.assign(1, c);
+            return true;
+        }
+
+        if (c == 't' || c == 'f' || c == 'n') {
+            lexeme = token::literal;
+            text.assign(1, c);
+            return true;
+        }
+
+        return fail("unexpected character");
+    }
+
+    bool JsonPushParser::close(char open) {
+        if (containers.empty() || containers.back() != open)
+            return fail("unbalanced container");
+        containers.pop_back();
+        if (!(open == '{' ? sax.end_object() : sax.end_array()))
+            return stop();
+        return complete_value();
+    }
+
+    bool JsonPushParser::complete_value() {
+        state = containers.empty() ? expect::done : expect::comma_or_end;
+        return true;
+    }
+
+    bool JsonPushParser::string_char(char c) {
+
+        if (hex_digits > 0) {
+            auto value = hex_value(c);
+            if (value < 0)
+                return fail("invalid \\u escape");
+            code_point = code_point * 16 + static_cast<uint32_t>(value);
+            if (--hex_digits == 0)
+                return unicode_char();
+            return true;
+        }
+
+        if (escape) {
+            escape = false;
+
+            if (high_surrogate && c != 'u')
+                return fail("invalid surrogate pair");
+
+            switch (c) {
+                case '"': text.push_back('"'); break;
+                case '\\': text.push_back('\\'); break;
+                case '/': text.push_back('/'); break;
+                case 'b': text.push_back('\b'); break;
+                case 'f': text.push_back('\f'); break;
+                case 'n': text.push_back('\n'); break;
+                case 'r': text.push_back('\r'); break;
+                case 't': text.push_back('\t'); break;
+                case 'u':
+                    hex_digits = 4;
+                    code_point = 0;
+                    break;
+                default:
+                    return fail("invalid escape");
+            }
+            return true;
+        }
+
+        //
+        // high surrogate is followed by the escaped low one
+        //
+        if (high_surrogate && c != '\\')
+            return fail("invalid surrogate pair");
+
+        if (c == '\\' && utf8_pending == 0) {
+            escape = true;
+            return true;
+        }
+
+        if (c == '"') {
+            if (utf8_pending > 0)
+                return fail("invalid UTF-8 in string");
+            lexeme = token::none;
+            return emit_string();
+        }
+
+        if (!utf8_char(static_cast<unsigned char>(c)))
+            return false;
+
+        text.push_back(c);
+        return true;
+    }
+
+    bool JsonPushParser::utf8_char(unsigned char c) {
+
+        if (utf8_pending > 0) {
+            if (c < utf8_low || c > utf8_high)
+                return fail("invalid UTF-8 in string");
+            --utf8_pending;
+            utf8_low = 0x80;
+            utf8_high = 0xbf;
+            return true;
+        }
+
+        if (c < 0x20)
+            return fail("control character in string");
+
+        if (c < 0x80)
+            return true;
+
+        //
+        // well-formed sequences of RFC 3629: no overlong forms, surrogates or code points past U+10FFFF
+        //
+        utf8_low = 0x80;
+        utf8_high = 0xbf;
+
+        if (c >= 0xc2 && c <= 0xdf)
+            utf8_pending = 1;
+        else if (c >= 0xe0 && c <= 0xef) {
+            utf8_pending = 2;
+            if (c == 0xe0)
+                utf8_low = 0xa0;
+            else if (c == 0xed)
+                utf8_high = 0x9f;
+        }
+        else if (c >= 0xf0 && c <= 0xf4) {
+            utf8_pending = 3;
+            if (c == 0xf0)
+                utf8_low = 0x90;
+            else if (c == 0xf4)
+                utf8_high = 0x8f;
+        }
+        else
+            return fail("invalid UTF-8 in string");
+
+        return true;
+    }
+
+    bool JsonPushParser::unicode_char() {
+
+        auto code = code_point;
+
+        if (high_surrogate) {
+            if (code < 0xdc00 || code > 0xdfff)
+                return fail("invalid surrogate pair");
+            code = 0x10000 + ((high_surrogate - 0xd800) << 10) + (code - 0xdc00);
+            high_surrogate = 0;
+        }
+        else if (code >= 0xd800 && code <= 0xdbff) {
+            high_surrogate = code;
+            return true;
+        }
+        else if (code >= 0xdc00 && code <= 0xdfff)
+            return fail("invalid surrogate pair");
+
+        append_utf8(text, code);
+        return true;
+    }
+
+    bool JsonPushParser::emit_string() {
+        if (is_key) {
+            state = expect::colon;
+            return sax.key(text) || stop();
+        }
+        if (!sax.string(text))
+            return stop();
+        return complete_value();
+    }
+
+    bool JsonPushParser::emit_number() {
+
+        lexeme = token::none;
+
+        bool is_integer = false;
+        if (!valid_number(text, is_integer))
+            return fail("invalid number " + text);
+
+        auto first = text.data();
+        auto last = text.data() + text.size();
+
+        if (is_integer) {
+            //
+            // integer out of 64 bits range is taken as float
+            //
+            bool taken;
+            if (text[0] == '-') {
+                nlohmann::json::number_integer_t val;
+                taken = std::from_chars(first, last, val).ec == std::errc();
+                if (taken && !sax.number_integer(val))
+                    return stop();
+            }
+            else {
+                nlohmann::json::number_unsigned_t val;
+                taken = std::from_chars(first, last, val).ec == std::errc();
+                if (taken && !sax.number_unsigned(val))
+                    return stop();
+            }
+            if (taken)
+                return complete_value();
+        }
+
+        std::istringstream stream(text);
+        stream.imbue(std::locale::classic());
+        nlohmann::json::number_float_t val;
+        stream >> val;
+
+        //
+        // out of range value is read as the largest finite one with failbit set
+        //
+        if (stream.fail() || !std::isfinite(val))
+            return fail("number overflow " + text);
+
+        if (!sax.number_float(val, text))
+            return stop();
+        return complete_value();
+    }
+
+    bool JsonPushParser::emit_literal() {
+
+        lexeme = token::none;
+
+        bool handled;
+        if (text == "true")
+            handled = sax.boolean(true);
+        else if (text == "false")
+            handled = sax.boolean(false);
+        else if (text == "null")
+            handled = sax.null();
+        else
+            return fail("invalid literal " + text);
+
+        if (!handled)
+            return stop();
+        return complete_value();
+    }
+
+    //
+    // ResponseParser
+    //
+
+    void ResponseParser::start() {
+        envelope.reset();
+        parser.reset();
+    }
+
+    void ResponseParser::write(const char *data, std::size_t size) {
+        parser.write(data, size);
+    }
+
+    void ResponseParser::finish() {
+        parser.finish();
+    }
+
+    //
+    // DomResponse
+    //
+
+    void DomResponse::start() {
+        dom = DomSax();
+        parser.start();
+    }
+
+    void DomResponse::write(const char *data, std::size_t size) {
+        parser.write(data, size);
+    }
+
+    void DomResponse::finish() {
+        parser.finish();
+    }
+}
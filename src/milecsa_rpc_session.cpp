@@ -3,14 +3,165 @@
 //
 
 #include "milecsa_rpc_session.hpp"
+#include "milecsa_resolver_cache.hpp"
+#include "milecsa_tls_context.hpp"
 
 #include <optional>
-#include <boost/lambda/lambda.hpp>
-#include <boost/lambda/bind.hpp>
+#include <algorithm>
+#include <condition_variable>
+
+namespace milecsa::http::detail {
+
+    /**
+     * Parallel connection to resolved endpoints: attempts are started one by one with the stagger delay
+     * or at once when the previous one fails, the first connected socket is taken and the others are closed.
+     * Handlers run on the executor.
+     */
+    class ParallelConnect: public std::enable_shared_from_this<ParallelConnect> {
+
+    public:
+
+        typedef std::function<void(const boost::system::error_code &ec, tcp::socket &socket)> Handler;
+
+        ParallelConnect(boost::asio::io_context &ioc,
+                        const boost::asio::any_io_executor &executor,
+                        const rpc::ResolverCache::Endpoints &endpoints,
+                        std::chrono::milliseconds stagger,
+                        const Handler &handler):
+                ioc(ioc),
+                executor(executor),
+                endpoints(endpoints),
+                stagger(stagger),
+                handler(handler),
+                timer(ioc),
+                next_endpoint(0),
+                pending(0),
+                done(false),
+                cancelled(false),
+                last_error(boost::asio::error::host_not_found) {}
+
+        void start() {
+            next();
+        }
+
+        /**
+         * Close all attempts, handler gets operation_aborted
+         */
+        void cancel() {
+            if (done)
+                return;
+            cancelled = true;
+            timer.cancel();
+            close_attempts(attempts.size());
+            if (pending == 0)
+                finish(boost::asio::error::operation_aborted, nullptr);
+        }
+
+    private:
+
+        void next() {
+
+            if (done || cancelled)
+                return;
+
+            if (next_endpoint == endpoints.size()) {
+                if (pending == 0)
+                    finish(last_error, nullptr);
+                return;
+            }
+
+            auto self = shared_from_this();
+            auto index = attempts.size();
+
+            attempts.push_back(std::make_unique<tcp::socket>(ioc));
+            ++pending;
+
+            attempts[index]->async_connect(endpoints[next_endpoint++], boost::asio::bind_executor(
+                    executor, [self, index](const boost::system::error_code &ec){
+                        self->connected(index, ec);
+                    }));
+
+            if (next_endpoint < endpoints.size()) {
+                timer.expires_after(stagger);
+                timer.async_wait(boost::asio::bind_executor(executor, [self](const boost::system::error_code &ec){
+                    if (!ec)
+                        self->next();
+                }));
+            }
+        }
+
+        void connected(size_t index, const boost::system::error_code &ec) {
+
+            --pending;
+
+            if (done)
+                return;
+
+            if (!ec && !cancelled) {
+                timer.cancel();
+                close_attempts(index);
+                return finish(ec, attempts[index].get());
+            }
+
+            last_error = cancelled ? boost::asio::error::operation_aborted : ec;
+
+            if (cancelled) {
+                if (pending == 0)
+                    finish(last_error, nullptr);
+                return;
+            }
+
+            //
+            // failed address does not hold the next one back
+            //
+            timer.cancel();
+            next();
+        }
+
+        void close_attempts(size_t except) {
+            boost::system::error_code ignored_ec;
+            for (size_t i = 0; i < attempts.size(); ++i) {
+                if (i != except && attempts[i])
+                    attempts[i]->close(ignored_ec);
+            }
+        }
+
+        void finish(const boost::system::error_code &ec, tcp::socket *socket) {
+            done = true;
+            auto complete = std::move(handler);
+            tcp::socket none(ioc);
+            complete(ec, socket ? *socket : none);
+        }
+
+        boost::asio::io_context &ioc;
+        boost::asio::any_io_executor executor;
+        const rpc::ResolverCache::Endpoints endpoints;
+        const std::chrono::milliseconds stagger;
+        Handler handler;
+
+        boost::asio::steady_timer timer;
+        std::vector<std::unique_ptr<tcp::socket>> attempts;
+        size_t next_endpoint;
+        size_t pending;
+        bool done;
+        bool cancelled;
+        boost::system::error_code last_error;
+    };
+
+    /**
+     * None of resolved addresses accepts connection, node may have moved
+     */
+    static inline bool is_address_failure(const boost::system::error_code &ec) {
+        return ec == boost::asio::error::connection_refused ||
+               ec == boost::asio::error::host_unreachable ||
+               ec == boost::asio::error::network_unreachable;
+    }
+}
 
 namespace milecsa::http {
     using loop_result = std::optional<boost::system::error_code>;
-    using deadline_timer = boost::asio::deadline_timer;
+
+    std::chrono::milliseconds Session::connection_attempt_delay(250);
 
     Session::Session(const std::string &host,
                            uint64_t port,
@@ -21,58 +172,265 @@ namespace milecsa::http {
 
             use_ssl(protocol == Url::protocol::https),
             verify_ssl(verify),
-            timeout(timeout),
 
             host(host),
             port(boost::to_string(port)),
             target(target),
+            timeout(std::chrono::seconds(timeout)),
 
+            own_ioc(new boost::asio::io_context()),
+            ioc(*own_ioc),
             socket(0),
             stream(0),
-            deadline(ioc){
+            deadline(ioc),
+            operation(0),
+            strand(ioc.get_executor()),
+            exchange_deadline(ioc),
+            pipeline_depth(1),
+            opening(false),
+            writing(false),
+            reading(false),
+            connected(false){
+        prepare();
+    }
+
+    Session::Session(boost::asio::io_context &ioc,
+                     const std::string &host,
+                     uint64_t port,
+                     const std::string &target,
+                     Url::protocol protocol,
+                     bool verify,
+                     time_t timeout):
+
+            use_ssl(protocol == Url::protocol::https),
+            verify_ssl(verify),
+
+            host(host),
+            port(boost::to_string(port)),
+            target(target),
+            timeout(std::chrono::seconds(timeout)),
+
+            ioc(ioc),
+            socket(0),
+            stream(0),
+            deadline(ioc),
+            operation(0),
+            strand(ioc.get_executor()),
+            exchange_deadline(ioc),
+            pipeline_depth(1),
+            opening(false),
+            writing(false),
+            reading(false),
+            connected(false){
         prepare();
     }
 
     bool Session::prepare() {
 
+        reset();
+
+        return  socket != nullptr || stream != nullptr;
+    }
+
+    void Session::reset() {
+
+        boost::system::error_code ignored_ec;
+
+        if (socket) {
+            socket->close(ignored_ec);
+            delete socket;
+            socket = 0;
+        }
+
+        if (stream) {
+            stream->next_layer().close(ignored_ec);
+            delete stream;
+            stream = 0;
+        }
+
+        connected = false;
+
+        read_buffer.consume(read_buffer.size());
+
         if (use_ssl){
 
-            ssl::context ctx{ssl::context::tls_client};
-            ctx.set_options(ssl::context::sslv23_client|ssl::context::tlsv12_client);
+            //
+            // context with the trust store and cached sessions is shared by all sessions
+            //
+            stream = new ssl::stream<tcp::socket>{ioc, TlsContext::Instance().get()};
 
             if (verify_ssl) {
-                ctx.set_verify_mode(ssl::verify_client_once);
+                stream->set_verify_mode(ssl::verify_client_once);
             }
             else {
-                ctx.set_verify_mode(ssl::verify_none);
+                stream->set_verify_mode(ssl::verify_none);
             }
 
-            stream = new ssl::stream<tcp::socket>{ioc, ctx};
+            stream->set_verify_callback([&](bool preverified,
+                                            boost::asio::ssl::verify_context& ctx){
+                return this->verify_ssl;
+            });
         }
         else {
             socket = new tcp::socket(ioc);
         }
+    }
 
-        wait_deadline();
+    std::chrono::milliseconds Session::get_timeout() const {
+        if (adaptive_timeout)
+            return adaptive_timeout->get();
+        return timeout;
+    }
 
-        return  socket != nullptr || stream != nullptr;
+    void Session::set_timeout(std::chrono::milliseconds timeout) {
+        this->timeout = timeout;
     }
 
-    void Session::wait_deadline(){
+    void Session::set_adaptive_timeout(const std::shared_ptr<rpc::AdaptiveTimeout> &adaptive) {
+        adaptive_timeout = adaptive;
+    }
 
-        if (deadline.expires_at() <= deadline_timer::traits_type::now())
-        {
-            boost::system::error_code ignored_ec;
+    void Session::set_compression(const Compression &settings) {
+        std::lock_guard<std::mutex> lock(compression_mutex);
+        compression = settings;
+    }
 
-            if (use_ssl && stream)
-                stream->next_layer().close(ignored_ec);
-            else if (socket) {
-                socket->close(ignored_ec);
-            }
+    Compression Session::get_compression() const {
+        std::lock_guard<std::mutex> lock(compression_mutex);
+        return compression;
+    }
+
+    void Session::prepare_encoding(boost::beast::http::fields &fields, const std::string &key) const {
 
-            deadline.expires_at(boost::posix_time::pos_infin);
+        bool accept;
+        {
+            std::lock_guard<std::mutex> lock(compression_mutex);
+            auto size = response_sizes.find(key);
+            accept = compression.enabled &&
+                     (size == response_sizes.end() || size->second >= compression.min_size);
         }
-        deadline.async_wait(boost::lambda::bind(&Session::wait_deadline, this));
+
+        if (accept)
+            fields.set(boost::beast::http::field::accept_encoding, "gzip, deflate");
+        else
+            fields.erase(boost::beast::http::field::accept_encoding);
+    }
+
+    void Session::observe_encoding(const std::string &key, const response &res) const {
+        if (res.result() != boost::beast::http::status::ok)
+            return;
+        std::lock_guard<std::mutex> lock(compression_mutex);
+        response_sizes[key] = res.body().content_size();
+    }
+
+    void Session::limit_body(response &res) const {
+        std::lock_guard<std::mutex> lock(compression_mutex);
+        res.body().limit = compression.max_size;
+    }
+
+    void Session::observe_latency(std::chrono::steady_clock::time_point started) {
+        if (adaptive_timeout)
+            adaptive_timeout->observe(std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - started));
+    }
+
+    Session::ContextScope::ContextScope(Session &session, const rpc::CallContext &context):
+            session(session), outer(session.call_context) {
+        session.call_context = context;
+    }
+
+    Session::ContextScope::~ContextScope() {
+        session.call_context = outer;
+    }
+
+    boost::system::error_code Session::run_operation(const std::function<void(const Completion &done)> &start,
+                                                     const std::function<void()> &abort) {
+
+        if (call_context.is_cancelled())
+            return boost::asio::error::operation_aborted;
+
+        auto operation_timeout = call_context.bound(get_timeout());
+
+        if (operation_timeout.count() <= 0)
+            return boost::asio::error::timed_out;
+
+        //
+        // private context is stopped when it runs out of work between operations
+        //
+        if (own_ioc && ioc.stopped())
+            ioc.restart();
+
+        auto current = ++operation;
+
+        boost::system::error_code ec = boost::asio::error::would_block;
+        bool waiting = true;
+        bool expired = false;
+
+        deadline.expires_after(operation_timeout);
+        deadline.async_wait([this, &waiting, &expired, abort](const boost::system::error_code &error){
+            waiting = false;
+            if (error)
+                return;
+            expired = true;
+            close_socket();
+            if (abort)
+                abort();
+        });
+
+        //
+        // token is cancelled from any thread, socket is closed by the thread runs the operation;
+        // late cancellation of the completed operation is ignored
+        //
+        std::optional<size_t> subscription;
+        if (call_context.token)
+            subscription = call_context.token->subscribe([this, current, abort]{
+                boost::asio::post(ioc, [this, current, abort]{
+                    if (operation != current)
+                        return;
+                    close_socket();
+                    if (abort)
+                        abort();
+                });
+            });
+
+        start([&ec](const boost::system::error_code &error){
+            ec = error;
+        });
+
+        do ioc.run_one(); while (ec == boost::asio::error::would_block);
+
+        if (subscription)
+            call_context.token->unsubscribe(*subscription);
+
+        deadline.cancel();
+        while (waiting) ioc.run_one();
+
+        if (!ec && check_socket())
+            return ec;
+
+        if (call_context.is_cancelled())
+            return boost::asio::error::operation_aborted;
+
+        if (expired)
+            return boost::asio::error::timed_out;
+
+        return ec ? ec : boost::asio::error::operation_aborted;
+    }
+
+    void Session::report_operation(const boost::system::error_code &ec,
+                                   const std::string &stage,
+                                   const milecsa::ErrorHandler &error_handler) const {
+
+        //
+        // caller has cancelled the call, it is not an error
+        //
+        if (call_context.is_cancelled())
+            return;
+
+        error_handler(result::TIMEOUT, ErrorFormat("%s %s: %s:%s",
+                                                   call_context.is_expired() ? "Deadline exceeded" : stage.c_str(),
+                                                   boost::system::system_error(ec).what(),
+                                                   host.c_str(), port.c_str()));
     }
 
     bool Session::check_socket(){
@@ -85,87 +443,162 @@ namespace milecsa::http {
         return false;
     }
 
-    bool Session::connect(const milecsa::ErrorHandler &error) {
+    void Session::close_socket(){
 
-        try {
-            auto const results = tcp::resolver(ioc).resolve(host, port);
+        boost::system::error_code ignored_ec;
 
-            if (results.empty()) {
-                error(result::NOT_FOUND,ErrorFormat("Host %s:%s not found", host.c_str(), port.c_str()));
-                return false;
-            }
+        if (use_ssl && stream)
+            stream->next_layer().close(ignored_ec);
+        else if (socket)
+            socket->close(ignored_ec);
 
-            boost::posix_time::time_duration tm = boost::posix_time::seconds(timeout);
+        connected = false;
+    }
 
-            deadline.expires_from_now(tm);
+    tcp::socket &Session::lowest_layer() {
+        return use_ssl ? stream->next_layer() : *socket;
+    }
 
-            boost::system::error_code ec = boost::asio::error::would_block;
-            std::string stage = "Connection timeout";
+    bool Session::prepare_handshake() {
+        return TlsContext::Instance().prepare(stream->native_handle(), host, port);
+    }
 
-            if (use_ssl) {
+    std::vector<tcp::endpoint> Session::resolve(boost::system::error_code &ec) const {
 
-                stream->set_verify_callback([&](bool preverified,
-                                                boost::asio::ssl::verify_context& ctx){
-                    return this->verify_ssl;
-                });
+        if (call_context.is_cancelled()) {
+            ec = boost::asio::error::operation_aborted;
+            return {};
+        }
 
-                if(! SSL_set_tlsext_host_name(stream->native_handle(), host.c_str()))
+        auto lookup_timeout = call_context.bound(get_timeout());
+
+        if (lookup_timeout.count() <= 0) {
+            ec = boost::asio::error::timed_out;
+            return {};
+        }
+
+        //
+        // lookup outlives the call if it is abandoned, late completion goes to the shared state
+        //
+        struct Lookup {
+            std::mutex mutex;
+            std::condition_variable changed;
+            bool completed = false;
+            bool cancelled = false;
+            boost::system::error_code ec;
+            rpc::ResolverCache::Endpoints endpoints;
+        };
+
+        auto lookup = std::make_shared<Lookup>();
+
+        std::optional<size_t> subscription;
+        if (call_context.token)
+            subscription = call_context.token->subscribe([lookup]{
                 {
-                    error(result::FAIL, ErrorFormat("SSL  %s:%s  handshake error", host.c_str(), port.c_str()));
-                    return false;
+                    std::lock_guard<std::mutex> lock(lookup->mutex);
+                    lookup->cancelled = true;
                 }
-                try {
+                lookup->changed.notify_all();
+            });
 
-                    boost::asio::async_connect(
-                            stream->next_layer(),
-                            results, boost::lambda::var(ec) = boost::lambda::_1);
+        rpc::ResolverCache::Instance().async_resolve(host, port, [lookup](const boost::system::error_code &error,
+                                                                          const rpc::ResolverCache::Endpoints &endpoints){
+            {
+                std::lock_guard<std::mutex> lock(lookup->mutex);
+                lookup->completed = true;
+                lookup->ec = error;
+                lookup->endpoints = endpoints;
+            }
+            lookup->changed.notify_all();
+        });
 
-                    do ioc.run_one(); while (ec == boost::asio::error::would_block);
+        std::vector<tcp::endpoint> endpoints;
 
-                    if (ec || !check_socket()) {
-                        error(result::TIMEOUT, ErrorFormat("%s %s: %s:%s",
-                                                           stage.c_str(),
-                                                           boost::system::system_error(
-                                                                   ec ? ec : boost::asio::error::operation_aborted).what(),
-                                                           host.c_str(), port.c_str()));
-                        return false;
-                    }
+        {
+            std::unique_lock<std::mutex> lock(lookup->mutex);
+
+            lookup->changed.wait_until(lock, std::chrono::steady_clock::now() + lookup_timeout, [&lookup]{
+                return lookup->completed || lookup->cancelled;
+            });
+
+            if (lookup->completed) {
+                ec = lookup->ec;
+                endpoints = std::move(lookup->endpoints);
+            }
+            else
+                ec = lookup->cancelled ? boost::asio::error::operation_aborted : boost::asio::error::timed_out;
+        }
 
-                    stage = "SSL Handshake timeout";
+        //
+        // callback takes the lookup lock, so the token is released out of it
+        //
+        if (subscription)
+            call_context.token->unsubscribe(*subscription);
 
-                    deadline.expires_from_now(tm);
-                    ec = boost::asio::error::would_block;
+        return endpoints;
+    }
 
-                    stream->async_handshake(ssl::stream_base::client, boost::lambda::var(ec) = boost::lambda::_1);
+    bool Session::connect(const milecsa::ErrorHandler &error) {
 
-                }
-                catch(std::exception const& e)
-                {
-                    error(result::FAIL,ErrorFormat("%s: %s:%s", e.what(), host.c_str(), port.c_str()));
-                    return false;
-                }
-                catch(boost::system::system_error const& e)
-                {
-                    error(result::FAIL,ErrorFormat("%s: %s:%s", e.what(), host.c_str(), port.c_str()));
-                    return false;
-                }
+        try {
+            boost::system::error_code ec;
+
+            auto const endpoints = resolve(ec);
+
+            if (ec == boost::asio::error::timed_out || ec == boost::asio::error::operation_aborted) {
+                report_operation(ec, "Host lookup timeout", error);
+                return false;
             }
-            else {
-                boost::asio::async_connect(
-                        *socket,
-                        results, boost::lambda::var(ec) = boost::lambda::_1);
+
+            if (ec || endpoints.empty()) {
+                error(result::NOT_FOUND,ErrorFormat("Host %s:%s not found", host.c_str(), port.c_str()));
+                return false;
+            }
+
+            if (use_ssl && !prepare_handshake()) {
+                error(result::FAIL, ErrorFormat("SSL  %s:%s  handshake error", host.c_str(), port.c_str()));
+                return false;
             }
 
-            do ioc.run_one(); while (ec == boost::asio::error::would_block);
+            std::shared_ptr<detail::ParallelConnect> connector;
 
-            if (ec || !check_socket()) {
-                error(result::TIMEOUT, ErrorFormat("%s %s: %s:%s",
-                                                   stage.c_str(),
-                                                   boost::system::system_error(
-                                                           ec ? ec : boost::asio::error::operation_aborted).what(),
-                                                   host.c_str(), port.c_str()));
+            ec = run_operation([this, &endpoints, &connector](const Completion &done){
+                connector = std::make_shared<detail::ParallelConnect>(
+                        ioc, ioc.get_executor(), endpoints, connection_attempt_delay,
+                        [this, done](const boost::system::error_code &error, tcp::socket &winner){
+                            if (!error)
+                                lowest_layer() = std::move(winner);
+                            done(error);
+                        });
+                connector->start();
+            }, [&connector]{
+                if (connector)
+                    connector->cancel();
+            });
+
+            if (detail::is_address_failure(ec))
+                rpc::ResolverCache::Instance().expire(host, port);
+
+            if (ec) {
+                report_operation(ec, "Connection timeout", error);
                 return false;
             }
+
+            if (use_ssl) {
+
+                ec = run_operation([this](const Completion &done){
+                    stream->async_handshake(ssl::stream_base::client, done);
+                });
+
+                TlsContext::Instance().handshaken(stream->native_handle(), host, port, ec);
+
+                if (ec) {
+                    report_operation(ec, "SSL Handshake timeout", error);
+                    return false;
+                }
+            }
+
+            connected = true;
         }
         catch (std::exception const& e) {
             error(result::FAIL,ErrorFormat("%s: %s:%s", e.what(), host.c_str(), port.c_str()));
@@ -179,6 +612,11 @@ namespace milecsa::http {
         return true;
     }
 
+    bool Session::reconnect(const milecsa::ErrorHandler &error) {
+        reset();
+        return connect(error);
+    }
+
     Session::~Session(){
 
         if(socket) {
@@ -193,7 +631,312 @@ namespace milecsa::http {
             delete stream;
             stream = 0;
         }
-        ioc.stop();
+        if (own_ioc)
+            ioc.stop();
+    }
+
+    void Session::async_exchange(const std::shared_ptr<Exchange> &exchange) {
+        auto self = shared_from_this();
+        boost::asio::post(strand, [self, exchange]{
+            self->watch_exchange(exchange);
+            self->exchanges.push_back(exchange);
+            self->next_exchange();
+        });
+    }
+
+    void Session::watch_exchange(const std::shared_ptr<Exchange> &exchange) {
+
+        auto self = shared_from_this();
+
+        if (exchange->context.deadline) {
+            exchange->timer = std::make_unique<boost::asio::steady_timer>(ioc);
+            exchange->timer->expires_at(*exchange->context.deadline);
+            exchange->timer->async_wait(boost::asio::bind_executor(strand, [self, exchange](
+                    const boost::system::error_code &ec){
+                if (ec != boost::asio::error::operation_aborted)
+                    self->finish_exchange(exchange, boost::asio::error::timed_out, "Deadline exceeded");
+            }));
+        }
+
+        if (exchange->context.token) {
+            exchange->subscription = exchange->context.token->subscribe([self, exchange]{
+                boost::asio::post(self->strand, [self, exchange]{
+                    self->finish_exchange(exchange, boost::asio::error::operation_aborted, "Request cancelled");
+                });
+            });
+        }
+    }
+
+    void Session::finish_exchange(const std::shared_ptr<Exchange> &exchange,
+                                  const boost::system::error_code &ec,
+                                  const std::string &stage) {
+
+        //
+        // abandoned exchange keeps its place in the pipeline, the response is read and discarded
+        //
+        if (exchange->finished)
+            return;
+
+        exchange->finished = true;
+
+        if (exchange->timer)
+            exchange->timer->cancel();
+
+        if (exchange->subscription)
+            exchange->context.token->unsubscribe(*exchange->subscription);
+
+        exchange->done(ec, stage);
+    }
+
+    void Session::set_pipeline_depth(size_t depth) {
+        pipeline_depth = std::max<size_t>(depth, 1);
+    }
+
+    void Session::arm_exchange_deadline() {
+        auto self = shared_from_this();
+        exchange_deadline.expires_after(get_timeout());
+        exchange_deadline.async_wait(boost::asio::bind_executor(strand, [self](const boost::system::error_code &ec){
+            if (ec == boost::asio::error::operation_aborted)
+                return;
+            if (self->exchange_deadline.expiry() > boost::asio::steady_timer::clock_type::now())
+                return;
+            if (self->connecting)
+                self->connecting->cancel();
+            self->close_socket();
+        }));
+    }
+
+    void Session::next_exchange() {
+
+        if (opening || writing)
+            return;
+
+        while (!exchanges.empty() && (exchanges.front()->finished || exchanges.front()->context.is_cancelled())) {
+            auto exchange = exchanges.front();
+            exchanges.pop_front();
+            finish_exchange(exchange, boost::asio::error::operation_aborted, "Request cancelled");
+        }
+
+        if (exchanges.empty()) {
+            if (!reading)
+                exchange_deadline.cancel();
+            return;
+        }
+
+        if (!connected || !check_socket()) {
+
+            //
+            // responses of the closed connection must be drained before reconnection
+            //
+            if (reading || !inflight.empty())
+                return;
+
+            opening = true;
+
+            auto self = shared_from_this();
+            async_open([self](const boost::system::error_code &ec, const std::string &stage){
+                self->opening = false;
+                if (ec) {
+                    auto failed = std::move(self->exchanges);
+                    self->exchanges.clear();
+                    for (auto &exchange: failed)
+                        self->finish_exchange(exchange, ec, stage);
+                }
+                self->next_exchange();
+            });
+            return;
+        }
+
+        if (inflight.size() >= pipeline_depth)
+            return;
+
+        write_exchange();
+    }
+
+    void Session::async_open(const Exchange::Handler &done) {
+
+        reset();
+        exchange_buffer.consume(exchange_buffer.size());
+
+        auto self = shared_from_this();
+
+        arm_exchange_deadline();
+
+        rpc::ResolverCache::Instance().async_resolve(host, port, [self, done](
+                const boost::system::error_code &ec,
+                const rpc::ResolverCache::Endpoints &endpoints){
+
+            boost::asio::post(self->strand, [self, done, ec, endpoints]{
+
+                if (ec)
+                    return done(ec, "Host resolving");
+
+                if (self->exchange_deadline.expiry() <= boost::asio::steady_timer::clock_type::now())
+                    return done(boost::asio::error::timed_out, "Host resolving");
+
+                self->connecting = std::make_shared<detail::ParallelConnect>(
+                        self->ioc, self->strand, endpoints, connection_attempt_delay,
+                        [self, done](const boost::system::error_code &ec, tcp::socket &winner){
+
+                            self->connecting.reset();
+
+                            if (ec) {
+                                if (detail::is_address_failure(ec))
+                                    rpc::ResolverCache::Instance().expire(self->host, self->port);
+                                return done(ec, "Connection timeout");
+                            }
+
+                            self->lowest_layer() = std::move(winner);
+
+                            if (!self->use_ssl) {
+                                self->connected = true;
+                                return done(ec, "");
+                            }
+
+                            if (!self->prepare_handshake())
+                                return done(boost::asio::error::invalid_argument, "SSL handshake error");
+
+                            self->stream->async_handshake(
+                                    ssl::stream_base::client,
+                                    boost::asio::bind_executor(self->strand, [self, done](const boost::system::error_code &ec){
+                                        TlsContext::Instance().handshaken(self->stream->native_handle(),
+                                                                          self->host, self->port, ec);
+                                        if (!ec)
+                                            self->connected = true;
+                                        done(ec, "SSL Handshake timeout");
+                                    }));
+                        });
+
+                self->connecting->start();
+            });
+        });
+    }
+
+    void Session::write_exchange() {
+
+        auto self = shared_from_this();
+        auto exchange = exchanges.front();
+
+        exchanges.pop_front();
+        inflight.push_back(exchange);
+
+        writing = true;
+        exchange->sent = std::chrono::steady_clock::now();
+        arm_exchange_deadline();
+
+        auto on_write = [self](const boost::system::error_code &ec, size_t){
+
+            self->writing = false;
+
+            if (ec)
+                return self->fail_exchanges(ec, "Sending request timeout");
+
+            if (!self->reading)
+                self->read_exchange();
+
+            self->next_exchange();
+        };
+
+        if (use_ssl)
+            boost::beast::http::async_write(*stream, exchange->req, boost::asio::bind_executor(strand, on_write));
+        else
+            boost::beast::http::async_write(*socket, exchange->req, boost::asio::bind_executor(strand, on_write));
+    }
+
+    void Session::read_exchange() {
+
+        if (inflight.empty())
+            return;
+
+        auto self = shared_from_this();
+        auto exchange = inflight.front();
+
+        reading = true;
+        arm_exchange_deadline();
+        limit_body(exchange->res);
+
+        auto on_read = [self, exchange](const boost::system::error_code &ec, size_t){
+
+            self->reading = false;
+
+            if (ec)
+                return self->fail_exchanges(ec, "Reading response timeout");
+
+            self->inflight.pop_front();
+
+            bool closed = exchange->res.need_eof();
+
+            self->observe_latency(exchange->sent);
+            self->finish_exchange(exchange, ec, "");
+
+            if (closed) {
+                self->close_socket();
+
+                //
+                // node does not keep pipelined requests after the closing response:
+                // send them again in the strict request/response mode
+                //
+                if (!self->inflight.empty()) {
+                    self->pipeline_depth = 1;
+                    self->requeue_exchanges(boost::beast::http::error::end_of_stream, "Reading response timeout");
+                }
+            }
+            else if (!self->inflight.empty())
+                self->read_exchange();
+
+            self->next_exchange();
+        };
+
+        if (use_ssl)
+            boost::beast::http::async_read(*stream, exchange_buffer, exchange->res,
+                                           boost::asio::bind_executor(strand, on_read));
+        else
+            boost::beast::http::async_read(*socket, exchange_buffer, exchange->res,
+                                           boost::asio::bind_executor(strand, on_read));
+    }
+
+    static inline bool is_connection_closed(const boost::system::error_code &ec) {
+        return ec == boost::beast::http::error::end_of_stream ||
+               ec == boost::asio::error::eof ||
+               ec == boost::asio::error::connection_reset ||
+               ec == boost::asio::error::broken_pipe;
+    }
+
+    void Session::requeue_exchanges(const boost::system::error_code &ec, const std::string &stage) {
+
+        auto requests = std::move(inflight);
+        inflight.clear();
+
+        //
+        // keep the original order: requests were sent before queued ones
+        //
+        for (auto exchange = requests.rbegin(); exchange != requests.rend(); ++exchange) {
+            if ((*exchange)->idempotent && (*exchange)->retries++ == 0)
+                exchanges.push_front(*exchange);
+            else {
+                finish_exchange(*exchange, ec, stage);
+            }
+        }
+    }
+
+    void Session::fail_exchanges(const boost::system::error_code &ec, const std::string &stage) {
+
+        close_socket();
+
+        if (is_connection_closed(ec)) {
+            //
+            // stale keep-alive connection closed by node, idempotent requests are resent once
+            //
+            requeue_exchanges(ec, stage);
+        }
+        else {
+            auto failed = std::move(inflight);
+            inflight.clear();
+            for (auto &exchange: failed)
+                finish_exchange(exchange, ec, stage);
+        }
+
+        next_exchange();
     }
 }
 
@@ -202,7 +945,6 @@ namespace milecsa::rpc::detail {
     bool detail::RpcSession::debug_on = false;
 
     using loop_result = std::optional<boost::system::error_code>;
-    using deadline_timer = boost::asio::deadline_timer;
 
     RpcSession::RpcSession(const std::string &host,
                            uint64_t port,
@@ -213,42 +955,93 @@ namespace milecsa::rpc::detail {
             {
     }
 
+    RpcSession::RpcSession(boost::asio::io_context &ioc,
+                           const std::string &host,
+                           uint64_t port,
+                           const std::string &target,
+                           Url::protocol protocol,
+                           bool verify,
+                           time_t timeout): milecsa::http::Session(ioc,host,port,target,protocol,verify,timeout)
+    {
+    }
+
     RpcSession::~RpcSession(){}
 
-    rpc::response RpcSession::request(const rpc::request &body,
-                                      const http::ResponseHandler &response_fail_handler,
-                                      const milecsa::ErrorHandler &error_handler) {
+    static inline std::string command_id(const rpc::json &id) {
+        return id.is_string() ? id.get<std::string>() : id.dump();
+    }
 
-        boost::beast::http::request<boost::beast::http::string_body> req;
+    /**
+     * Responses size is learned per method, batch is learned as a whole
+     */
+    static inline std::string encoding_key(const rpc::request &body) {
+        if (body.is_object() && body.count("method") > 0 && body["method"].is_string())
+            return body["method"].get<std::string>();
+        return "batch";
+    }
 
-        try {
+    void RpcSession::prepare_request(http::request &req, const rpc::request &body, http::BodyWriter &writer) const {
 
-            // Set up an HTTP POST request message
+        //
+        // Set up an HTTP POST request message, reused message keeps its header
+        //
+        if (req.count(boost::beast::http::field::user_agent) == 0) {
             req.version(11);
             req.method(boost::beast::http::verb::post);
             req.target(get_target());
             req.set(boost::beast::http::field::host, get_host());
             req.set(boost::beast::http::field::user_agent, user_agent);
             req.set(boost::beast::http::field::content_type, "application/json");
+        }
 
-            auto _data = body.dump(); //+ "\n";
-            req.set(boost::beast::http::field::content_length, _data.size());
-            req.body() = _data;
-            req.prepare_payload();
+        prepare_encoding(req, encoding_key(body));
 
-            if (RpcSession::debug_on) {
-                std::cerr << "\nDebug info: " << get_host() << std::endl;
-                std::cerr << req << std::endl;
-                std::cerr << "..." << std::endl;
-            }
+        writer.write(req.body(), body);
+        req.prepare_payload();
 
-            if (!write(req,error_handler))
-                return std::nullopt;
+        if (RpcSession::debug_on) {
+            std::cerr << "\nDebug info: " << get_host() << std::endl;
+            std::cerr << req << std::endl;
+            std::cerr << "..." << std::endl;
+        }
+    }
 
-            boost::beast::http::response<boost::beast::http::string_body> res;
+    const http::response *RpcSession::exchange(const rpc::request &body,
+                                               http::BodySink &sink,
+                                               const milecsa::ErrorHandler &error_handler) {
 
-            if (!read(res,error_handler))
-                return std::nullopt;
+        prepare_request(request_message, body, body_writer);
+
+        auto started = std::chrono::steady_clock::now();
+
+        if (!write(request_message, error_handler))
+            return nullptr;
+
+        //
+        // parser requires an empty message, the body storage is kept
+        //
+        auto storage = std::move(response_message.body());
+        storage.clear();
+        response_message = {};
+        response_message.body() = std::move(storage);
+        response_message.body().sink = &sink;
+
+        if (!read(response_message, error_handler))
+            return nullptr;
+
+        observe_encoding(encoding_key(body), response_message);
+
+        observe_latency(started);
+
+        return &response_message;
+    }
+
+    milecsa::result RpcSession::scan_response(const rpc::request &body,
+                                              const http::response &res,
+                                              ResponseParser &parser,
+                                              const http::ResponseHandler &response_fail_handler,
+                                              const milecsa::ErrorHandler &error_handler) const {
+        try {
 
             auto status = res.result();
 
@@ -257,37 +1050,88 @@ namespace milecsa::rpc::detail {
                 std::cerr << res << std::endl;
                 std::cerr << " ------- " << std::endl;
                 std::cerr << res.body() << std::endl;
+                //
+                // streamed content is parsed as it is read, the body keeps its first bytes only
+                //
+                if (res.body().streamed)
+                    std::cerr << "(first " << res.body().size() << " of "
+                              << res.body().content_size() << " bytes)" << std::endl;
                 std::cerr << " ------- " << std::endl;
             }
+
             if (status == boost::beast::http::status::ok) {
-                auto json = json::parse(res.body().data());
-                if (json.count("result") > 0 && json.at("result") != nullptr){
-                    return json["result"];
+
+                //
+                // content is parsed while it is read, only result value is passed to the sink,
+                // the envelope is never built
+                //
+                if (!res.body().streamed) {
+                    parser.start();
+                    parser.write(res.body().data(), res.body().size());
+                    parser.finish();
+                }
+
+                if (parser.parser.error) {
+                    error_handler(milecsa::result::EXCEPTION,
+                                  ErrorFormat("json-rpc request: parse error: %s", parser.parser.error->c_str()));
+                    return milecsa::result::EXCEPTION;
                 }
+
+                //
+                // response is routed to the caller by id, result taken by the stopped sink as well
+                //
+                auto &envelope = parser.envelope;
+
+                if (envelope.id && body.count("id") > 0 && *envelope.id != command_id(body["id"])) {
+                    error_handler(milecsa::result::EXCEPTION,
+                                  ErrorFormat("json-rpc request: response id %s does not match request id %s: %s:%s",
+                                              envelope.id->c_str(), command_id(body["id"]).c_str(),
+                                              get_host().c_str(), get_port().c_str()));
+                    return milecsa::result::EXCEPTION;
+                }
+
+                if (envelope.has_result)
+                    return milecsa::result::OK;
             }
 
             response_fail_handler(status, body["method"],res);
-            return std::nullopt;
+            return milecsa::result::NOT_FOUND;
         }
         catch(std::exception const& e)
         {
             error_handler(result::FAIL,ErrorFormat("json-rpc request: %s: %s:%s", e.what() , get_host().c_str(), get_port().c_str()));
-            return std::nullopt;
-        }
-        catch(nlohmann::json::parse_error& e) {
-            error_handler(milecsa::result::EXCEPTION, ErrorFormat("json-rpc request: parse error: %s", e.what()));
-            return std::nullopt;
+            return milecsa::result::FAIL;
         }
-        catch(nlohmann::json::invalid_iterator& e){
-            error_handler(milecsa::result::EXCEPTION, ErrorFormat("json-rpc request: invalid iterator error: %s", e.what()));
+    }
+
+    rpc::response RpcSession::parse_response(const rpc::request &body,
+                                             const http::response &res,
+                                             DomResponse &response,
+                                             const http::ResponseHandler &response_fail_handler,
+                                             const milecsa::ErrorHandler &error_handler) const {
+        if (scan_response(body, res, response.parser, response_fail_handler, error_handler) != milecsa::result::OK)
             return std::nullopt;
-        } catch(nlohmann::json::type_error & e){
-            error_handler(milecsa::result::EXCEPTION, ErrorFormat("json-rpc request: type error: %s", e.what()));            return std::nullopt;
-        } catch(nlohmann::json::out_of_range& e){
-            error_handler(milecsa::result::EXCEPTION, ErrorFormat("json-rpc request: out of range error: %s", e.what()));
+        return std::move(response.dom.value);
+    }
+
+    rpc::response RpcSession::request(const rpc::request &body,
+                                      const http::ResponseHandler &response_fail_handler,
+                                      const milecsa::ErrorHandler &error_handler,
+                                      const rpc::CallContext &context) {
+        ContextScope scope(*this, context);
+
+        try {
+
+            DomResponse response;
+
+            if (auto res = exchange(body, response, error_handler))
+                return parse_response(body, *res, response, response_fail_handler, error_handler);
+
             return std::nullopt;
-        } catch(nlohmann::json::other_error& e){
-            error_handler(milecsa::result::EXCEPTION, ErrorFormat("json-rpc request: other error: %s", e.what()));
+        }
+        catch(std::exception const& e)
+        {
+            error_handler(result::FAIL,ErrorFormat("json-rpc request: %s: %s:%s", e.what() , get_host().c_str(), get_port().c_str()));
             return std::nullopt;
         }
         catch (...) {
@@ -296,6 +1140,319 @@ namespace milecsa::rpc::detail {
         }
     }
 
+    bool RpcSession::request(const rpc::request &body,
+                             ResultSax &sax,
+                             const http::ResponseHandler &response_fail_handler,
+                             const milecsa::ErrorHandler &error_handler,
+                             const rpc::CallContext &context) {
+        ContextScope scope(*this, context);
+
+        try {
+
+            ResponseParser parser(sax);
+
+            if (auto res = exchange(body, parser, error_handler))
+                return scan_response(body, *res, parser, response_fail_handler, error_handler) == milecsa::result::OK;
+
+            return false;
+        }
+        catch(std::exception const& e)
+        {
+            error_handler(result::FAIL,ErrorFormat("json-rpc request: %s: %s:%s", e.what() , get_host().c_str(), get_port().c_str()));
+            return false;
+        }
+        catch (...) {
+            error_handler(milecsa::result::EXCEPTION, ErrorFormat("json-rpc request: unknown error"));
+            return false;
+        }
+    }
+
+    void RpcSession::async_request(const rpc::request &body,
+                                   const rpc::ResultHandler &handler,
+                                   const http::ResponseHandler &response_fail_handler,
+                                   const milecsa::ErrorHandler &error_handler,
+                                   const rpc::CallContext &context) {
+        async_deliver(body, [handler](const rpc::response &result, bool){
+            handler(result);
+        }, response_fail_handler, error_handler, context);
+    }
+
+    void RpcSession::async_deliver(const rpc::request &body,
+                                   const rpc::DeliveryHandler &handler,
+                                   const http::ResponseHandler &response_fail_handler,
+                                   const milecsa::ErrorHandler &error_handler,
+                                   const rpc::CallContext &context) {
+
+        auto exchange = std::make_shared<http::Exchange>();
+
+        try {
+            http::BodyWriter writer;
+            prepare_request(exchange->req, body, writer);
+        }
+        catch(std::exception const& e)
+        {
+            error_handler(result::FAIL,ErrorFormat("json-rpc request: %s: %s:%s", e.what() , get_host().c_str(), get_port().c_str()));
+            handler(std::nullopt, false);
+            return;
+        }
+
+        exchange->idempotent = is_idempotent(body);
+        exchange->context = context;
+
+        auto self = std::static_pointer_cast<RpcSession>(shared_from_this());
+
+        //
+        // response is parsed while it is read, parser starts over if the request is sent again
+        //
+        auto response = std::make_shared<DomResponse>();
+        exchange->res.body().sink = response.get();
+
+        //
+        // exchange owns its completion handler, so handler refers to exchange by pointer
+        //
+        auto ex = exchange.get();
+
+        exchange->done = [self, ex, response, body, handler, response_fail_handler, error_handler](
+                const boost::system::error_code &ec,
+                const std::string &stage){
+
+            bool written = ex->sent != std::chrono::steady_clock::time_point();
+
+            //
+            // caller has cancelled the request, it is not an error
+            //
+            if (ex->context.is_cancelled()) {
+                handler(std::nullopt, written);
+                return;
+            }
+
+            if (ec) {
+                error_handler(ec == boost::asio::error::host_not_found ? result::FAIL : result::TIMEOUT,
+                              ErrorFormat("%s %s: %s:%s",
+                                          stage.c_str(),
+                                          boost::system::system_error(ec).what(),
+                                          self->get_host().c_str(), self->get_port().c_str()));
+                handler(std::nullopt, written);
+                return;
+            }
+
+            self->observe_encoding(encoding_key(body), ex->res);
+
+            handler(self->parse_response(body, ex->res, *response, response_fail_handler, error_handler), written);
+        };
+
+        async_exchange(exchange);
+    }
+
+    std::future<rpc::response> RpcSession::async_request(const rpc::request &body,
+                                                         const http::ResponseHandler &response_fail_handler,
+                                                         const milecsa::ErrorHandler &error_handler) {
+        auto promise = std::make_shared<std::promise<rpc::response>>();
+        async_request(body, [promise](const rpc::response &result){
+            promise->set_value(result);
+        }, response_fail_handler, error_handler);
+        return promise->get_future();
+    }
+
+    std::vector<rpc::response> RpcSession::batch(const std::vector<rpc::request> &commands,
+                                                 const http::ResponseHandler &response_fail_handler,
+                                                 const milecsa::ErrorHandler &error_handler,
+                                                 const rpc::CallContext &context) {
+
+        ContextScope scope(*this, context);
+
+        std::vector<rpc::response> results(commands.size());
+
+        if (commands.empty())
+            return results;
+
+        http::request req;
+        http::response res;
+
+        try {
+
+            prepare_request(req, rpc::json(commands), body_writer);
+
+            if (!write(req,error_handler))
+                return results;
+
+            if (!read(res,error_handler))
+                return results;
+
+            observe_encoding("batch", res);
+
+            if (RpcSession::debug_on) {
+                std::cerr << "\nResponse info: " << res.result() << std::endl;
+                std::cerr << res << std::endl;
+            }
+
+            //
+            // node or proxy has failed, commands may have been executed: nothing is sent again
+            //
+            if (res.result() != boost::beast::http::status::ok) {
+                for (size_t i = 0; i < commands.size(); ++i)
+                    response_fail_handler(res.result(), commands[i]["method"], res);
+                return results;
+            }
+
+            auto json = json::parse(res.body().data(), nullptr, false);
+
+            if (json.is_discarded()) {
+                error_handler(milecsa::result::EXCEPTION, ErrorFormat("json-rpc batch: parse error: %s:%s",
+                                                                      get_host().c_str(), get_port().c_str()));
+                return results;
+            }
+
+            if (json.is_array()) {
+
+                std::unordered_map<std::string, size_t> index;
+                for (size_t i = 0; i < commands.size(); ++i)
+                    index[command_id(commands[i]["id"])] = i;
+
+                for (auto &item: json) {
+                    if (!item.is_object() || item.count("id") == 0)
+                        continue;
+                    auto position = index.find(command_id(item["id"]));
+                    if (position == index.end())
+                        continue;
+                    if (item.count("result") > 0 && item.at("result") != nullptr)
+                        results[position->second] = std::move(item["result"]);
+                }
+
+                for (size_t i = 0; i < commands.size(); ++i) {
+                    if (!results[i])
+                        response_fail_handler(res.result(), commands[i]["method"], res);
+                }
+
+                return results;
+            }
+        }
+        catch(std::exception const& e)
+        {
+            error_handler(result::FAIL,ErrorFormat("json-rpc batch: %s: %s:%s", e.what() , get_host().c_str(), get_port().c_str()));
+            return results;
+        }
+        catch (...) {
+            error_handler(milecsa::result::EXCEPTION, ErrorFormat("json-rpc batch: unknown error"));
+            return results;
+        }
+
+        //
+        // node does not support batches: well-formed reply is not an array,
+        // not idempotent commands are never sent twice
+        //
+        if (res.need_eof() && !reconnect(error_handler))
+            return results;
+
+        for (size_t i = 0; i < commands.size(); ++i) {
+            if (!is_idempotent(commands[i])) {
+                error_handler(result::FAIL, ErrorFormat("json-rpc batch: %s response is lost: %s:%s",
+                                                        commands[i]["method"].dump().c_str(),
+                                                        get_host().c_str(), get_port().c_str()));
+                continue;
+            }
+            results[i] = request(commands[i], response_fail_handler, error_handler, context);
+        }
+
+        return results;
+    }
+
+    bool RpcSession::is_idempotent(const rpc::request &command) {
+        if (command.count("method") == 0 || !command["method"].is_string())
+            return false;
+        return is_idempotent(command["method"].get_ref<const std::string &>());
+    }
+
+    bool RpcSession::is_idempotent(const std::string &method) {
+        return method == "ping" || method.compare(0, 4, "get-") == 0;
+    }
+
+    std::vector<rpc::response> RpcSession::pipeline(const std::vector<rpc::request> &commands,
+                                                    const http::ResponseHandler &response_fail_handler,
+                                                    const milecsa::ErrorHandler &error_handler,
+                                                    const rpc::CallContext &context) {
+
+        ContextScope scope(*this, context);
+
+        std::vector<rpc::response> results(commands.size());
+
+        size_t written = 0;
+        size_t received = 0;
+
+        //
+        // pipelined stage errors are not reported: commands are sent again in the strict mode
+        //
+        milecsa::ErrorHandler pipeline_error = [](milecsa::result, const std::string &){};
+
+        try {
+
+            boost::beast::flat_buffer buffer;
+            std::deque<http::request> requests;
+
+            bool write_failed = false;
+
+            while (received < commands.size()) {
+
+                while (!write_failed && written < commands.size() && written - received < get_pipeline_depth()) {
+                    requests.emplace_back();
+                    prepare_request(requests.back(), commands[written], body_writer);
+                    if (!write(requests.back(), pipeline_error)) {
+                        requests.pop_back();
+                        write_failed = true;
+                        break;
+                    }
+                    ++written;
+                }
+
+                if (written == received)
+                    break;
+
+                DomResponse response;
+                http::response res;
+                res.body().sink = &response;
+
+                if (!read(res, buffer, pipeline_error))
+                    break;
+
+                observe_encoding(encoding_key(commands[received]), res);
+
+                results[received] = parse_response(commands[received], res, response,
+                                                   response_fail_handler, error_handler);
+                requests.pop_front();
+                ++received;
+
+                if (res.need_eof()) {
+                    if (received < written)
+                        set_pipeline_depth(1);
+                    break;
+                }
+            }
+        }
+        catch(std::exception const& e)
+        {
+            error_handler(result::FAIL,ErrorFormat("json-rpc pipeline: %s: %s:%s", e.what() , get_host().c_str(), get_port().c_str()));
+            return results;
+        }
+
+        if (received == commands.size())
+            return results;
+
+        if (!reconnect(error_handler))
+            return results;
+
+        for (size_t i = received; i < commands.size(); ++i) {
+            if (i < written && !is_idempotent(commands[i])) {
+                error_handler(result::FAIL, ErrorFormat("json-rpc pipeline: %s response is lost: %s:%s",
+                                                        commands[i]["method"].dump().c_str(),
+                                                        get_host().c_str(), get_port().c_str()));
+                continue;
+            }
+            results[i] = request(commands[i], response_fail_handler, error_handler, context);
+        }
+
+        return results;
+    }
+
     rpc::request RpcSession::next_command(const std::string &method, const rpc::request &params) const {
         json command = {
                 {"jsonrpc", "2.0"},
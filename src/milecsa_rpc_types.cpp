@@ -0,0 +1,421 @@
+//
+// Created by lotus mile on 2026-10-17.
+//
+
+#include "milecsa_rpc_types.hpp"
+
+#include <cstdlib>
+#include <limits>
+
+namespace milecsa::rpc::detail {
+
+    //
+    // FieldPath
+    //
+
+    bool FieldPath::starts_with(std::initializer_list<const char *> prefix) const {
+        if (prefix.size() > size)
+            return false;
+        auto key = keys;
+        for (auto p: prefix) {
+            if (*key++ != p)
+                return false;
+        }
+        return true;
+    }
+
+    bool FieldPath::is(std::initializer_list<const char *> path) const {
+        return path.size() == size && starts_with(path);
+    }
+
+    //
+    // FieldSax
+    //
+
+    bool FieldSax::null() {
+        text.clear();
+        field(current(), text);
+        return true;
+    }
+
+    bool FieldSax::boolean(bool val) {
+        text = val ? "true" : "false";
+        field(current(), text);
+        return true;
+    }
+
+    bool FieldSax::number_integer(number_integer_t val) {
+        text = std::to_string(val);
+        field(current(), text);
+        return true;
+    }
+
+    bool FieldSax::number_unsigned(number_unsigned_t val) {
+        text = std::to_string(val);
+        field(current(), text);
+        return true;
+    }
+
+    bool FieldSax::number_float(number_float_t, const string_t &s) {
+        text = s;
+        field(current(), text);
+        return true;
+    }
+
+    bool FieldSax::string(string_t &val) {
+        field(current(), val);
+        return true;
+    }
+
+#ifdef MILECSA_JSON_SAX_BINARY
+    bool FieldSax::binary(binary_t &) {
+        return true;
+    }
+#endif
+
+    bool FieldSax::start_object(std::size_t) {
+        object(current());
+        path.emplace_back();
+        return true;
+    }
+
+    bool FieldSax::key(string_t &val) {
+        path.back() = val;
+        return true;
+    }
+
+    bool FieldSax::end_object() {
+        path.pop_back();
+        return true;
+    }
+
+    bool FieldSax::start_array(std::size_t) {
+        path.emplace_back("[]");
+        return true;
+    }
+
+    bool FieldSax::end_array() {
+        path.pop_back();
+        return true;
+    }
+
+    bool FieldSax::parse_error(std::size_t, const std::string &, const nlohmann::detail::exception &) {
+        return false;
+    }
+
+    //
+    // Scalars
+    //
+
+    static inline uint64_t to_u64(const std::string &text) {
+        return std::strtoull(text.c_str(), nullptr, 10);
+    }
+
+    static inline std::optional<uint256_t> to_u256(const std::string &text) {
+        uint256_t value = 0;
+        if (text.empty() || !StringToUInt256(text, value, false))
+            return std::nullopt;
+        return value;
+    }
+
+    static inline bool to_bool(const std::string &text) {
+        return text == "true" || (!text.empty() && text != "false" && to_u64(text) != 0);
+    }
+
+    //
+    // Transaction is described flat in blocks or under "description" in wallet history,
+    // assets are given by flat asset-code and amount or by the asset array
+    //
+
+    static inline FieldPath transaction_path(const FieldPath &path) {
+        return path.starts_with({"description"}) ? path.tail(1) : path;
+    }
+
+    static inline Balance &flat_asset(Transaction &tx) {
+        if (tx.assets.empty())
+            tx.assets.emplace_back();
+        return tx.assets.front();
+    }
+
+    static void decode_transaction_object(Transaction &tx, const FieldPath &path) {
+        if (transaction_path(path).is({"asset", "[]"}))
+            tx.assets.emplace_back();
+    }
+
+    static void decode_transaction(Transaction &tx, const FieldPath &path, std::string &text) {
+
+        if (path.is({"type"})) {
+            tx.status = std::move(text);
+            return;
+        }
+
+        auto p = transaction_path(path);
+
+        if (p.is({"type"}) || p.is({"transaction-type"}))
+            tx.type = std::move(text);
+        else if (p.is({"id"}) || p.is({"transaction-id"}))
+            tx.id = to_u256(text).value_or(0);
+        else if (p.is({"from"}))
+            tx.from = std::move(text);
+        else if (p.is({"to"}))
+            tx.to = std::move(text);
+        else if (p.is({"asset-code"}))
+            flat_asset(tx).asset_code = static_cast<unsigned short>(to_u64(text));
+        else if (p.is({"amount"}))
+            flat_asset(tx).amount = std::move(text);
+        else if (p.is({"asset", "[]", "code"}) && !tx.assets.empty())
+            tx.assets.back().asset_code = static_cast<unsigned short>(to_u64(text));
+        else if (p.is({"asset", "[]", "amount"}) && !tx.assets.empty())
+            tx.assets.back().amount = std::move(text);
+        else if (p.is({"fee"}))
+            tx.fee = std::move(text);
+        else if (p.is({"digest"}))
+            tx.digest = std::move(text);
+    }
+
+    //
+    // CurrentBlockId
+    //
+
+    void decode_object(CurrentBlockId &, const FieldPath &) {}
+
+    void decode_field(CurrentBlockId &value, const FieldPath &path, std::string &text) {
+        if (path.is({"current-block-id"}))
+            value.id = to_u256(text);
+    }
+
+    //
+    // WalletState
+    //
+
+    void decode_object(WalletState &value, const FieldPath &path) {
+        if (path.is({"balance", "[]"}))
+            value.balance.emplace_back();
+    }
+
+    void decode_field(WalletState &value, const FieldPath &path, std::string &text) {
+        if (path.is({"balance", "[]", "asset-code"}) && !value.balance.empty())
+            value.balance.back().asset_code = static_cast<unsigned short>(to_u64(text));
+        else if (path.is({"balance", "[]", "amount"}) && !value.balance.empty())
+            value.balance.back().amount = std::move(text);
+        else if (path.is({"tags"}))
+            value.tags = std::move(text);
+        else if (path.is({"node-address"}))
+            value.node_address = std::move(text);
+        else if (path.is({"last-transaction-id"}))
+            value.last_transaction_id = to_u256(text).value_or(0);
+        else if (path.is({"exist"}))
+            value.exist = to_bool(text);
+    }
+
+    //
+    // WalletTransactions
+    //
+
+    void decode_object(WalletTransactions &value, const FieldPath &path) {
+        if (path.is({"transactions", "[]"}))
+            value.transactions.emplace_back();
+        else if (path.starts_with({"transactions", "[]"}) && !value.transactions.empty())
+            decode_transaction_object(value.transactions.back(), path.tail(2));
+    }
+
+    void decode_field(WalletTransactions &value, const FieldPath &path, std::string &text) {
+        if (path.starts_with({"transactions", "[]"}) && !value.transactions.empty())
+            decode_transaction(value.transactions.back(), path.tail(2), text);
+    }
+
+    //
+    // Block
+    //
+
+    void decode_object(Block &value, const FieldPath &path) {
+        if (path.is({"transactions", "[]"}))
+            value.transactions.emplace_back();
+        else if (path.starts_with({"transactions", "[]"}) && !value.transactions.empty())
+            decode_transaction_object(value.transactions.back(), path.tail(2));
+    }
+
+    void decode_field(Block &value, const FieldPath &path, std::string &text) {
+        if (path.starts_with({"transactions", "[]"})) {
+            if (!value.transactions.empty())
+                decode_transaction(value.transactions.back(), path.tail(2), text);
+        }
+        else if (path.is({"id"}) || path.is({"block-id"}))
+            value.id = to_u256(text).value_or(0);
+        else if (path.is({"version"}))
+            value.version = std::move(text);
+        else if (path.is({"previous-block-digest"}))
+            value.previous_block_digest = std::move(text);
+        else if (path.is({"merkle-root"}))
+            value.merkle_root = std::move(text);
+        else if (path.is({"timestamp"}))
+            value.timestamp = std::move(text);
+        else if (path.is({"number-of-transactions"}) || path.is({"transaction-count"}))
+            value.transaction_count = to_u64(text);
+    }
+
+    //
+    // BlockchainState
+    //
+
+    void decode_object(BlockchainState &value, const FieldPath &path) {
+        if (path.is({"supported-assets", "[]"}))
+            value.supported_assets.emplace_back();
+    }
+
+    void decode_field(BlockchainState &value, const FieldPath &path, std::string &text) {
+        if (path.is({"supported-assets", "[]", "code"}) && !value.supported_assets.empty())
+            value.supported_assets.back().code = static_cast<unsigned short>(to_u64(text));
+        else if (path.is({"supported-assets", "[]", "name"}) && !value.supported_assets.empty())
+            value.supported_assets.back().name = std::move(text);
+        else if (path.is({"project"}))
+            value.project = std::move(text);
+        else if (path.is({"version"}))
+            value.version = std::move(text);
+        else if (path.is({"block-count"}))
+            value.block_count = to_u256(text).value_or(0);
+        else if (path.is({"node-count"}))
+            value.node_count = to_u64(text);
+        else if (path.is({"voting-transaction-count"}))
+            value.voting_transaction_count = to_u64(text);
+        else if (path.is({"pending-transaction-count"}))
+            value.pending_transaction_count = to_u64(text);
+        else if (path.is({"blockchain-state"}))
+            value.blockchain_state = std::move(text);
+        else if (path.is({"consensus-round"}))
+            value.consensus_round = to_u64(text);
+    }
+
+    //
+    // NodeList
+    //
+
+    void decode_object(NodeList &value, const FieldPath &path) {
+        if (path.is({"[]"}))
+            value.nodes.emplace_back();
+    }
+
+    void decode_field(NodeList &value, const FieldPath &path, std::string &text) {
+        if (value.nodes.empty())
+            return;
+        if (path.is({"[]", "public-key"}))
+            value.nodes.back().public_key = std::move(text);
+        else if (path.is({"[]", "address"}))
+            value.nodes.back().address = std::move(text);
+        else if (path.is({"[]", "node-id"}))
+            value.nodes.back().node_id = to_u256(text).value_or(0);
+    }
+
+    /**
+     * Feed json value to the SAX decoder as if it was parsed, strings are copied
+     */
+    static bool replay(const nlohmann::json &value, ResultSax &sax) {
+
+        switch (value.type()) {
+
+            case nlohmann::json::value_t::null:
+                return sax.null();
+
+            case nlohmann::json::value_t::boolean:
+                return sax.boolean(value.get<bool>());
+
+            case nlohmann::json::value_t::number_integer:
+                return sax.number_integer(value.get<nlohmann::json::number_integer_t>());
+
+            case nlohmann::json::value_t::number_unsigned:
+                return sax.number_unsigned(value.get<nlohmann::json::number_unsigned_t>());
+
+            case nlohmann::json::value_t::number_float:
+                return sax.number_float(value.get<nlohmann::json::number_float_t>(), value.dump());
+
+            case nlohmann::json::value_t::string: {
+                auto text = value.get<std::string>();
+                return sax.string(text);
+            }
+
+            case nlohmann::json::value_t::object: {
+                if (!sax.start_object(value.size()))
+                    return false;
+                for (auto &item: value.items()) {
+                    auto key = item.key();
+                    if (!sax.key(key) || !replay(item.value(), sax))
+                        return false;
+                }
+                return sax.end_object();
+            }
+
+            case nlohmann::json::value_t::array: {
+                if (!sax.start_array(value.size()))
+                    return false;
+                for (auto &item: value) {
+                    if (!replay(item, sax))
+                        return false;
+                }
+                return sax.end_array();
+            }
+
+            default:
+                return true;
+        }
+    }
+}
+
+namespace milecsa::rpc {
+
+    std::optional<int64_t> parse_amount(const std::string &amount) {
+
+        auto c = amount.begin();
+        auto negative = c != amount.end() && *c == '-';
+        if (negative)
+            ++c;
+
+        auto digit = [](char d) { return d >= '0' && d <= '9'; };
+
+        if (c == amount.end() || !digit(*c))
+            return std::nullopt;
+
+        int64_t integer = 0;
+        for (; c != amount.end() && digit(*c); ++c) {
+            if (integer > (std::numeric_limits<int64_t>::max() / amount_scale - (*c - '0')) / 10)
+                return std::nullopt;
+            integer = integer * 10 + (*c - '0');
+        }
+
+        int64_t fraction = 0;
+        if (c != amount.end()) {
+            if (*c != '.' || ++c == amount.end())
+                return std::nullopt;
+            for (int64_t scale = amount_scale; c != amount.end(); ++c) {
+                if (!digit(*c))
+                    return std::nullopt;
+                if (scale > 1) {
+                    scale /= 10;
+                    fraction += (*c - '0') * scale;
+                }
+            }
+        }
+
+        //
+        // integer part is bounded by max / amount_scale, the fraction is less than amount_scale
+        //
+        if (integer * amount_scale > std::numeric_limits<int64_t>::max() - fraction)
+            return std::nullopt;
+
+        auto units = integer * amount_scale + fraction;
+        return negative ? -units : units;
+    }
+
+    std::optional<CurrentBlockId> decode_current_block_id(const nlohmann::json &result) {
+        detail::TypedSax<CurrentBlockId> sax;
+        if (!detail::replay(result, sax))
+            return std::nullopt;
+        return std::move(sax.value);
+    }
+
+    std::optional<Block> decode_block(const nlohmann::json &block) {
+        detail::TypedSax<Block> sax;
+        if (!detail::replay(block, sax))
+            return std::nullopt;
+        return std::move(sax.value);
+    }
+}
@@ -0,0 +1,171 @@
+//
+// Created by lotus mile on 2026-10-17.
+//
+
+#include "milecsa_tls_context.hpp"
+
+#include <mutex>
+#include <unordered_map>
+
+namespace milecsa::http::detail {
+
+    /**
+     * Ssl connection keeps its cache key, session issued after handshake (TLS 1.3 tickets) is stored by it
+     */
+    static void free_key(void *, void *key, CRYPTO_EX_DATA *, int, long, void *) {
+        delete static_cast<std::string *>(key);
+    }
+
+    class TlsState {
+
+    public:
+
+        TlsState():
+                context(boost::asio::ssl::context::tls_client),
+                resumption(true),
+                handshakes(0),
+                resumed(0) {
+
+            context.set_options(boost::asio::ssl::context::sslv23_client|boost::asio::ssl::context::tlsv12_client);
+
+            boost::system::error_code ignored_ec;
+            context.set_default_verify_paths(ignored_ec);
+
+            key_index = SSL_get_ex_new_index(0, nullptr, nullptr, nullptr, free_key);
+
+            auto native = context.native_handle();
+            SSL_CTX_set_session_cache_mode(native, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+            SSL_CTX_sess_set_new_cb(native, &TlsState::new_session);
+        }
+
+        ~TlsState() {
+            for (auto &session: sessions)
+                SSL_SESSION_free(session.second);
+        }
+
+        static TlsState *instance;
+
+        static std::string key_of(const std::string &host, const std::string &port) {
+            return host + ":" + port;
+        }
+
+        void put(const std::string &key, SSL_SESSION *session) {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto &cached = sessions[key];
+            if (cached)
+                SSL_SESSION_free(cached);
+            cached = session;
+        }
+
+        void drop(const std::string &key) {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto cached = sessions.find(key);
+            if (cached == sessions.end())
+                return;
+            SSL_SESSION_free(cached->second);
+            sessions.erase(cached);
+        }
+
+        boost::asio::ssl::context context;
+        int key_index;
+
+        mutable std::mutex mutex;
+        std::unordered_map<std::string, SSL_SESSION *> sessions;
+        bool resumption;
+        uint64_t handshakes;
+        uint64_t resumed;
+
+    private:
+
+        /**
+         * Cache takes the session reference
+         */
+        static int new_session(SSL *ssl, SSL_SESSION *session) {
+            auto key = static_cast<std::string *>(SSL_get_ex_data(ssl, instance->key_index));
+            if (!key || !SSL_SESSION_is_resumable(session))
+                return 0;
+            {
+                std::lock_guard<std::mutex> lock(instance->mutex);
+                if (!instance->resumption)
+                    return 0;
+            }
+            instance->put(*key, session);
+            return 1;
+        }
+    };
+
+    TlsState *TlsState::instance = nullptr;
+}
+
+namespace milecsa::http {
+
+    TlsContext& TlsContext::Instance() {
+        static TlsContext myInstance;
+        return myInstance;
+    }
+
+    TlsContext::TlsContext(): state(std::make_unique<detail::TlsState>()) {
+        detail::TlsState::instance = state.get();
+    }
+
+    TlsContext::~TlsContext() {
+        detail::TlsState::instance = nullptr;
+    }
+
+    boost::asio::ssl::context &TlsContext::get() {
+        return state->context;
+    }
+
+    void TlsContext::set_resumption(bool enable) {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->resumption = enable;
+        if (enable)
+            return;
+        for (auto &session: state->sessions)
+            SSL_SESSION_free(session.second);
+        state->sessions.clear();
+    }
+
+    bool TlsContext::prepare(SSL *ssl, const std::string &host, const std::string &port) {
+
+        if (SSL_set_tlsext_host_name(ssl, host.c_str()) == 0)
+            return false;
+
+        auto key = detail::TlsState::key_of(host, port);
+
+        delete static_cast<std::string *>(SSL_get_ex_data(ssl, state->key_index));
+        SSL_set_ex_data(ssl, state->key_index, new std::string(key));
+
+        std::lock_guard<std::mutex> lock(state->mutex);
+
+        if (!state->resumption)
+            return true;
+
+        auto cached = state->sessions.find(key);
+        if (cached != state->sessions.end())
+            SSL_set_session(ssl, cached->second);
+
+        return true;
+    }
+
+    void TlsContext::handshaken(SSL *ssl,
+                                const std::string &host,
+                                const std::string &port,
+                                const boost::system::error_code &ec) {
+
+        if (ec) {
+            state->drop(detail::TlsState::key_of(host, port));
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(state->mutex);
+        ++state->handshakes;
+        if (SSL_session_reused(ssl))
+            ++state->resumed;
+    }
+
+    TlsContext::Stat TlsContext::get_stat() const {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        return {state->handshakes, state->resumed};
+    }
+}
@@ -0,0 +1,359 @@
+//
+// Created by lotus mile on 2026-10-17.
+//
+
+#include "milecsa_transaction_pipeline.hpp"
+#include "milecsa_trx_id.hpp"
+
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <algorithm>
+
+namespace milecsa::rpc::detail {
+
+    typedef std::chrono::steady_clock clock;
+
+    class PipelineState {
+
+    public:
+
+        /**
+         * Transfer is signed by signer thread, signed body is sent as is
+         */
+        struct Job {
+            size_t sequence;
+            std::optional<TransactionPipeline::Transfer> transfer;
+            std::optional<json> body;
+            TransactionPipeline::DeliveryHandler handler;
+        };
+
+        PipelineState(const ConcurrentClient &client,
+                      size_t window,
+                      TransactionPipeline::Order order,
+                      const ErrorHandler &error_handler):
+                client(client),
+                window(std::max<size_t>(window, 1)),
+                order(order),
+                error_handler(error_handler),
+                in_flight(0),
+                submitted(0),
+                delivered(0),
+                stopped(false),
+                next_delivery(0) {}
+
+        ~PipelineState() {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                changed.wait(lock, [this]{ return delivered == submitted; });
+                stopped = true;
+            }
+            changed.notify_all();
+            for (auto &thread: signers) {
+                if (thread.joinable())
+                    thread.join();
+            }
+        }
+
+        size_t push(std::optional<TransactionPipeline::Transfer> transfer,
+                    std::optional<json> body,
+                    const TransactionPipeline::DeliveryHandler &handler) {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [this]{ return queue.size() < window; });
+            auto sequence = submitted++;
+            queue.push_back({sequence, std::move(transfer), std::move(body), handler});
+            changed.notify_all();
+            return sequence;
+        }
+
+        void wait() {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [this]{ return delivered == submitted; });
+        }
+
+        /**
+         * Block id is fetched by one signer at a time outside of the lock,
+         * the others keep signing with the previous id or wait for the first one
+         */
+        bool update_block_id() {
+            std::unique_lock<std::mutex> lock(block_mutex);
+
+            if (block_id && clock::now() - block_updated_at <= BlockIdTracker::max_staleness)
+                return true;
+
+            if (block_refreshing) {
+                if (block_id)
+                    return true;
+                block_refreshed.wait(lock, [this]{ return !block_refreshing; });
+                return block_id.has_value();
+            }
+
+            block_refreshing = true;
+            lock.unlock();
+
+            auto id = client.get_current_block_id();
+
+            lock.lock();
+            block_refreshing = false;
+            if (id) {
+                block_id = id;
+                block_updated_at = clock::now();
+            }
+            block_refreshed.notify_all();
+
+            return id.has_value();
+        }
+
+        std::optional<uint256_t> current_block_id() {
+            if (auto &tracker = client.next().get_block_id_tracker()) {
+                if (auto id = tracker->get())
+                    return id;
+            }
+            if (!update_block_id())
+                return std::nullopt;
+            std::lock_guard<std::mutex> lock(block_mutex);
+            return block_id;
+        }
+
+        std::optional<json> sign(const TransactionPipeline::Transfer &transfer) {
+
+            auto block_id = current_block_id();
+            if (!block_id) {
+                error_handler(result::FAIL, ErrorFormat("current block id can't be got to sign transfer"));
+                return std::nullopt;
+            }
+
+            return TransactionPipeline::Sign(transfer, *block_id, error_handler);
+        }
+
+        void complete(size_t sequence,
+                      const TransactionPipeline::DeliveryHandler &handler,
+                      const response &result,
+                      bool written) {
+
+            size_t count = 0;
+
+            if (order == TransactionPipeline::Order::completion) {
+                if (handler)
+                    handler(sequence, result, written);
+                count = 1;
+            }
+            else {
+                //
+                // results are held back until all the earlier ones are delivered
+                //
+                std::lock_guard<std::mutex> lock(delivery_mutex);
+                reordered.emplace(sequence, Delivery{handler, result, written});
+                while (!reordered.empty() && reordered.begin()->first == next_delivery) {
+                    auto next = reordered.begin();
+                    if (next->second.handler)
+                        next->second.handler(next->first, next->second.result, next->second.written);
+                    reordered.erase(next);
+                    ++next_delivery;
+                    ++count;
+                }
+            }
+
+            if (count > 0) {
+                std::lock_guard<std::mutex> lock(mutex);
+                delivered += count;
+                changed.notify_all();
+            }
+        }
+
+        void start(size_t threads) {
+            for (size_t i = 0; i < std::max<size_t>(threads, 1); ++i)
+                signers.emplace_back([this]{ run(); });
+        }
+
+        void run() {
+            for (;;) {
+
+                std::optional<Job> job;
+
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    changed.wait(lock, [this]{ return stopped || !queue.empty(); });
+                    if (queue.empty())
+                        return;
+                    job = std::move(queue.front());
+                    queue.pop_front();
+                    changed.notify_all();
+                }
+
+                auto body = job->body ? std::move(job->body) : sign(*job->transfer);
+
+                if (!body) {
+                    complete(job->sequence, job->handler, std::nullopt, false);
+                    continue;
+                }
+
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    changed.wait(lock, [this]{ return in_flight < window; });
+                    ++in_flight;
+                }
+
+                auto sequence = job->sequence;
+                auto handler = std::move(job->handler);
+
+                client.next().async_send_transaction(*body, [this, sequence, handler](const response &result, bool written){
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        --in_flight;
+                        changed.notify_all();
+                    }
+                    complete(sequence, handler, result, written);
+                });
+            }
+        }
+
+        ConcurrentClient client;
+        const size_t window;
+        const TransactionPipeline::Order order;
+        const ErrorHandler error_handler;
+
+        std::mutex mutex;
+        std::condition_variable changed;
+        std::deque<Job> queue;
+        size_t in_flight;
+        size_t submitted;
+        size_t delivered;
+        bool stopped;
+
+        struct Delivery {
+            TransactionPipeline::DeliveryHandler handler;
+            response result;
+            bool written;
+        };
+
+        std::mutex delivery_mutex;
+        std::map<size_t, Delivery> reordered;
+        size_t next_delivery;
+
+        std::mutex block_mutex;
+        std::condition_variable block_refreshed;
+        std::optional<uint256_t> block_id;
+        clock::time_point block_updated_at;
+        bool block_refreshing = false;
+
+        std::vector<std::thread> signers;
+    };
+}
+
+namespace milecsa::rpc {
+
+    TransactionPipeline::TransactionPipeline(const std::shared_ptr<detail::PipelineState> &state): state(state) {}
+
+    TransactionPipeline::TransactionPipeline(const TransactionPipeline &pipeline): state(pipeline.state) {}
+
+    TransactionPipeline& TransactionPipeline::operator = (const TransactionPipeline& pipeline) {
+        state = pipeline.state;
+        return *this;
+    }
+
+    TransactionPipeline::~TransactionPipeline(){
+        state.reset();
+    }
+
+    std::optional<TransactionPipeline> TransactionPipeline::Start(
+            const ConcurrentClient &client,
+            size_t signers,
+            size_t window,
+            Order order,
+            const milecsa::ErrorHandler &error_handler) {
+
+        auto state = std::make_shared<detail::PipelineState>(client, window, order, error_handler);
+
+        if (!client.next().get_block_id_tracker() && !state->update_block_id()) {
+            error_handler(result::FAIL, ErrorFormat("current block id can't be got to start pipeline"));
+            return std::nullopt;
+        }
+
+        if (signers == 0)
+            signers = std::thread::hardware_concurrency();
+
+        state->start(signers);
+
+        return TransactionPipeline(state);
+    }
+
+    TransactionPipeline TransactionPipeline::StartBroadcast(
+            const ConcurrentClient &client,
+            size_t window,
+            Order order,
+            const milecsa::ErrorHandler &error_handler) {
+
+        auto state = std::make_shared<detail::PipelineState>(client, window, order, error_handler);
+
+        //
+        // signed bodies are only sent, one thread feeds the window
+        //
+        state->start(1);
+
+        return TransactionPipeline(state);
+    }
+
+    /**
+     * Completion handler does not care if the transaction has been written
+     */
+    static inline TransactionPipeline::DeliveryHandler completion(const TransactionPipeline::CompletionHandler &handler) {
+        if (!handler)
+            return nullptr;
+        return [handler](size_t sequence, const response &result, bool){
+            handler(sequence, result);
+        };
+    }
+
+    size_t TransactionPipeline::submit(const Transfer &transfer, const CompletionHandler &handler) {
+        return state->push(transfer, std::nullopt, completion(handler));
+    }
+
+    size_t TransactionPipeline::submit(const Transfer &transfer, const DeliveryHandler &handler) {
+        return state->push(transfer, std::nullopt, handler);
+    }
+
+    std::future<response> TransactionPipeline::submit(const Transfer &transfer) {
+        auto promise = std::make_shared<std::promise<response>>();
+        state->push(transfer, std::nullopt, [promise](size_t, const response &result, bool){
+            promise->set_value(result);
+        });
+        return promise->get_future();
+    }
+
+    size_t TransactionPipeline::broadcast(const json &body, const CompletionHandler &handler) {
+        return state->push(std::nullopt, body, completion(handler));
+    }
+
+    size_t TransactionPipeline::broadcast(const json &body, const DeliveryHandler &handler) {
+        return state->push(std::nullopt, body, handler);
+    }
+
+    std::optional<json> TransactionPipeline::Sign(const Transfer &transfer,
+                                                  const uint256_t &block_id,
+                                                  const ErrorHandler &error_handler) {
+
+        auto request = milecsa::transaction::JsonTransfer::CreateRequest(
+                transfer.pair,
+                transfer.to,
+                block_id,
+                TrxIdAllocator::Instance().get_next(transfer.pair),
+                milecsa::assets::TokenFromCode(transfer.asset_code),
+                transfer.amount,
+                transfer.fee,
+                transfer.description,
+                error_handler);
+
+        if (!request)
+            return std::nullopt;
+
+        return request->get_body();
+    }
+
+    void TransactionPipeline::wait() const {
+        state->wait();
+    }
+}
@@ -0,0 +1,215 @@
+//
+// Created by lotus mile on 2026-10-17.
+//
+
+#include "milecsa_trx_id.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <chrono>
+#include <fstream>
+#include <filesystem>
+
+namespace milecsa::rpc::detail {
+
+    struct WalletCounter {
+        std::atomic<uint64_t> next;
+        std::atomic<uint64_t> reserved;
+
+        WalletCounter(uint64_t start): next(start), reserved(start) {}
+    };
+
+    static inline void raise(std::atomic<uint64_t> &value, uint64_t floor) {
+        auto current = value.load(std::memory_order_relaxed);
+        while (current < floor && !value.compare_exchange_weak(current, floor, std::memory_order_relaxed)) {}
+    }
+
+    static inline uint64_t now_us() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count());
+    }
+
+    class TrxIdState {
+
+    public:
+
+        TrxIdState(): persistent(false) {}
+
+        /**
+         * Counters are never removed, threads cache them by raw pointers
+         */
+        WalletCounter *find(const std::string &public_key) {
+
+            thread_local std::unordered_map<std::string, WalletCounter *> cached;
+
+            auto it = cached.find(public_key);
+            if (it != cached.end())
+                return it->second;
+
+            WalletCounter *counter = nullptr;
+            {
+                std::shared_lock<std::shared_mutex> lock(registry_mutex);
+                auto found = counters.find(public_key);
+                if (found != counters.end())
+                    counter = found->second.get();
+            }
+
+            if (!counter) {
+                std::unique_lock<std::shared_mutex> lock(registry_mutex);
+                auto &created = counters[public_key];
+                if (!created) {
+                    auto start = now_us();
+                    auto mark = marks.find(public_key);
+                    if (mark != marks.end())
+                        start = std::max(start, mark->second);
+                    created = std::make_unique<WalletCounter>(start);
+                }
+                counter = created.get();
+            }
+
+            cached.emplace(public_key, counter);
+            return counter;
+        }
+
+        uint64_t next(const std::string &public_key) {
+            auto counter = find(public_key);
+            auto id = counter->next.fetch_add(1, std::memory_order_relaxed);
+            if (persistent.load(std::memory_order_acquire) && id >= counter->reserved.load(std::memory_order_acquire))
+                reserve(*counter, id);
+            return id;
+        }
+
+        /**
+         * Id is not returned until the mark above it is written,
+         * the mark is published to other threads only after the file is replaced
+         */
+        void reserve(WalletCounter &counter, uint64_t id) {
+            std::lock_guard<std::mutex> lock(file_mutex);
+            if (id < counter.reserved.load(std::memory_order_relaxed))
+                return;
+            auto mark = id + std::max<uint64_t>(TrxIdAllocator::reserve_step, 1);
+            if (write(&counter, mark))
+                counter.reserved.store(mark, std::memory_order_release);
+        }
+
+        /**
+         * Called under file_mutex, pending counter is written with its new mark
+         */
+        bool write(const WalletCounter *pending, uint64_t pending_mark) {
+            auto temp = path + ".tmp";
+            {
+                std::ofstream file(temp, std::ios::trunc);
+                std::shared_lock<std::shared_mutex> lock(registry_mutex);
+                for (auto &mark: marks) {
+                    if (counters.count(mark.first) == 0)
+                        file << mark.first << " " << mark.second << "\n";
+                }
+                for (auto &counter: counters) {
+                    auto mark = counter.second.get() == pending ?
+                                pending_mark : counter.second->reserved.load(std::memory_order_relaxed);
+                    file << counter.first << " " << mark << "\n";
+                }
+                if (!file.flush()) {
+                    error_handler(result::FAIL, ErrorFormat("trx id marks %s can't be written", temp.c_str()));
+                    return false;
+                }
+            }
+            std::error_code ec;
+            std::filesystem::rename(temp, path, ec);
+            if (ec) {
+                error_handler(result::FAIL, ErrorFormat("trx id marks %s can't be written: %s", path.c_str(), ec.message().c_str()));
+                return false;
+            }
+            return true;
+        }
+
+        bool open(const std::string &file_path, const ErrorHandler &handler) {
+
+            std::lock_guard<std::mutex> lock(file_mutex);
+
+            std::unordered_map<std::string, uint64_t> loaded;
+
+            std::error_code ec;
+            if (std::filesystem::exists(file_path, ec)) {
+                std::ifstream file(file_path);
+                if (!file) {
+                    handler(result::FAIL, ErrorFormat("trx id marks %s can't be read", file_path.c_str()));
+                    return false;
+                }
+                std::string public_key;
+                uint64_t mark;
+                while (file >> public_key >> mark)
+                    loaded[public_key] = mark;
+            }
+
+            {
+                std::unique_lock<std::shared_mutex> registry_lock(registry_mutex);
+                for (auto &mark: loaded) {
+                    auto counter = counters.find(mark.first);
+                    if (counter != counters.end())
+                        raise(counter->second->next, mark.second);
+                    else
+                        marks[mark.first] = std::max(marks[mark.first], mark.second);
+                }
+                //
+                // the next id of every counter writes its mark
+                //
+                for (auto &counter: counters)
+                    counter.second->reserved.store(counter.second->next.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            }
+
+            path = file_path;
+            error_handler = handler;
+            persistent.store(true, std::memory_order_release);
+
+            return true;
+        }
+
+        void seed(const std::string &public_key, uint64_t id) {
+            raise(find(public_key)->next, id + 1);
+        }
+
+    private:
+
+        std::shared_mutex registry_mutex;
+        std::unordered_map<std::string, std::unique_ptr<WalletCounter>> counters;
+        std::unordered_map<std::string, uint64_t> marks;
+
+        std::mutex file_mutex;
+        std::atomic<bool> persistent;
+        std::string path;
+        ErrorHandler error_handler;
+    };
+}
+
+namespace milecsa::rpc {
+
+    uint64_t TrxIdAllocator::reserve_step = 1024;
+
+    TrxIdAllocator& TrxIdAllocator::Instance() {
+        static TrxIdAllocator myInstance;
+        return myInstance;
+    }
+
+    TrxIdAllocator::TrxIdAllocator(): state(std::make_unique<detail::TrxIdState>()) {}
+
+    TrxIdAllocator::~TrxIdAllocator() {}
+
+    uint64_t TrxIdAllocator::get_next(const std::string &public_key) {
+        return state->next(public_key);
+    }
+
+    uint64_t TrxIdAllocator::get_next(const milecsa::keys::Pair &pair) {
+        return state->next(pair.get_public_key().encode());
+    }
+
+    void TrxIdAllocator::seed(const std::string &public_key, uint64_t id) {
+        state->seed(public_key, id);
+    }
+
+    bool TrxIdAllocator::persist(const std::string &path, const ErrorHandler &error_handler) {
+        return state->open(path, error_handler);
+    }
+}
@@ -0,0 +1,647 @@
+//
+// Created by lotus mile on 2026-10-17.
+//
+
+#include "milecsa_wallet_index.hpp"
+#include "milecsa_block_iterator.hpp"
+
+#include <fstream>
+#include <filesystem>
+#include <shared_mutex>
+#include <mutex>
+#include <unordered_map>
+#include <algorithm>
+#include <type_traits>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+namespace milecsa::rpc::detail {
+
+    namespace fs = std::filesystem;
+    namespace bip = boost::interprocess;
+
+    /**
+     * Segment record: 4 bytes little-endian length of the CBOR transaction following it.
+     * Keys record: 2 bytes little-endian length of the public key following it, key number is the record number.
+     * Postings are written as is, checkpoint is a text line: next block and sizes of the files.
+     */
+    struct Posting {
+        uint64_t block;
+        uint64_t record;
+        int64_t delta;
+        uint32_t key;
+        uint32_t offset;
+        uint16_t asset_code;
+        uint16_t reserved[3];
+    };
+
+    static_assert(sizeof(Posting) == 40 && std::is_trivially_copyable<Posting>::value, "posting layout");
+
+    static const size_t record_header_size = sizeof(uint32_t);
+    static const size_t key_header_size = sizeof(uint16_t);
+    static const uint64_t checkpoint_interval = 256;
+
+    /**
+     * Balance changes of the sender and the receiver of one asset in amount_scale units
+     */
+    struct Movement {
+        uint16_t asset_code = 0;
+        int64_t from = 0;
+        int64_t to = 0;
+    };
+
+    /**
+     * Only transfers and emissions move value, node registration and voting transactions
+     * charge the fee and are posted for history. Every asset of the transaction is moved
+     * on its own, the fee is charged with the first one, a transaction without fee is charged nothing.
+     * nullopt if an amount is malformed.
+     */
+    static std::optional<std::vector<Movement>> movements_of(const Transaction &tx) {
+
+        std::vector<Movement> movements;
+
+        for (auto &asset: tx.assets) {
+
+            Movement movement;
+            movement.asset_code = asset.asset_code;
+
+            if (tx.type == "TransferAssetsTransaction") {
+                auto amount = parse_amount(asset.amount);
+                if (!amount)
+                    return std::nullopt;
+                movement.from -= *amount;
+                movement.to += *amount;
+            }
+            else if (tx.type == "EmissionTransaction") {
+                //
+                // emitted amount goes to the emitting wallet if there is no receiver
+                //
+                auto amount = parse_amount(asset.amount);
+                if (!amount)
+                    return std::nullopt;
+                if (tx.to.empty())
+                    movement.from += *amount;
+                else
+                    movement.to += *amount;
+            }
+
+            movements.push_back(movement);
+        }
+
+        if (movements.empty())
+            movements.emplace_back();
+
+        if (!tx.fee.empty()) {
+            auto fee = parse_amount(tx.fee);
+            if (!fee)
+                return std::nullopt;
+            movements.front().from -= *fee;
+        }
+
+        return movements;
+    }
+
+    class WalletIndexState {
+
+    public:
+
+        WalletIndexState(const std::string &directory, const ErrorHandler &error_handler):
+                segment_path(fs::path(directory) / "wallets.segment"),
+                postings_path(fs::path(directory) / "wallets.postings"),
+                keys_path(fs::path(directory) / "wallets.keys"),
+                checkpoint_path(fs::path(directory) / "wallets.checkpoint"),
+                next_block(0),
+                segment_size(0),
+                postings_size(0),
+                keys_size(0),
+                checkpoint_block(0),
+                error_handler(error_handler){}
+
+        ~WalletIndexState() {
+            if (segment.is_open())
+                write_checkpoint();
+        }
+
+        bool open() {
+            try {
+                fs::create_directories(segment_path.parent_path());
+
+                if (std::ifstream file{checkpoint_path})
+                    file >> next_block >> segment_size >> postings_size >> keys_size;
+
+                checkpoint_block = next_block;
+
+                //
+                // Tails written after the checkpoint are dropped, their blocks are ingested again
+                //
+                for (auto &[path, size]: {std::make_pair(segment_path, segment_size),
+                                          std::make_pair(postings_path, postings_size),
+                                          std::make_pair(keys_path, keys_size)}) {
+                    if (!fs::exists(path))
+                        std::ofstream(path, std::ios::binary);
+                    if (fs::file_size(path) < size) {
+                        error_handler(result::FAIL, ErrorFormat("Wallet index %s is shorter than its checkpoint", path.c_str()));
+                        return false;
+                    }
+                    fs::resize_file(path, size);
+                }
+
+                if (!load_keys() || !load_postings())
+                    return false;
+
+                map_segment();
+
+                return open_streams();
+            }
+            catch (std::exception const &e) {
+                error_handler(result::EXCEPTION, ErrorFormat("Wallet index %s: %s", segment_path.parent_path().c_str(), e.what()));
+                return false;
+            }
+        }
+
+        bool open_streams() {
+            segment.open(segment_path, std::ios::binary | std::ios::app);
+            postings_file.open(postings_path, std::ios::binary | std::ios::app);
+            keys_file.open(keys_path, std::ios::binary | std::ios::app);
+            if (!segment || !postings_file || !keys_file) {
+                error_handler(result::FAIL, ErrorFormat("Wallet index %s can't be opened", segment_path.parent_path().c_str()));
+                return false;
+            }
+            return true;
+        }
+
+        bool load_keys() {
+            std::ifstream file(keys_path, std::ios::binary);
+            std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+            size_t position = 0;
+            while (position + key_header_size <= data.size()) {
+                size_t length = uint8_t(data[position]) | size_t(uint8_t(data[position + 1])) << 8;
+                position += key_header_size;
+                if (position + length > data.size())
+                    break;
+                key_index.emplace(data.substr(position, length), static_cast<uint32_t>(keys.size()));
+                keys.push_back(data.substr(position, length));
+                postings.emplace_back();
+                position += length;
+            }
+
+            if (position != data.size()) {
+                error_handler(result::FAIL, ErrorFormat("Wallet index keys are corrupted"));
+                return false;
+            }
+            return true;
+        }
+
+        bool load_postings() {
+            std::ifstream file(postings_path, std::ios::binary);
+            Posting posting;
+            while (file.read(reinterpret_cast<char *>(&posting), sizeof(posting))) {
+                if (posting.key >= postings.size()) {
+                    error_handler(result::FAIL, ErrorFormat("Wallet index posting refers unknown key %u", posting.key));
+                    return false;
+                }
+                postings[posting.key].push_back(posting);
+            }
+            return true;
+        }
+
+        /**
+         * Map the whole segment written so far, must be called under unique lock
+         */
+        void map_segment() {
+            if (segment_size == 0)
+                return;
+            mapped = bip::mapped_region(bip::file_mapping(segment_path.c_str(), bip::read_only), bip::read_only);
+        }
+
+        /**
+         * Drop the tails of the failed block, must be called under unique lock
+         */
+        void rollback() {
+            segment.close();
+            postings_file.close();
+            keys_file.close();
+            fs::resize_file(segment_path, segment_size);
+            fs::resize_file(postings_path, postings_size);
+            fs::resize_file(keys_path, keys_size);
+            open_streams();
+        }
+
+        bool write_checkpoint() {
+            auto temp = checkpoint_path;
+            temp += ".tmp";
+            {
+                segment.flush();
+                postings_file.flush();
+                keys_file.flush();
+                std::ofstream file(temp, std::ios::trunc);
+                file << next_block << " " << segment_size << " " << postings_size << " " << keys_size << "\n";
+                if (!file.flush() || !segment || !postings_file || !keys_file) {
+                    error_handler(result::FAIL, ErrorFormat("Wallet index checkpoint can't be written"));
+                    return false;
+                }
+            }
+            std::error_code ec;
+            fs::rename(temp, checkpoint_path, ec);
+            if (ec) {
+                error_handler(result::FAIL, ErrorFormat("Wallet index checkpoint: %s", ec.message().c_str()));
+                return false;
+            }
+            checkpoint_block = next_block;
+            return true;
+        }
+
+        /**
+         * Append block, must be called under unique lock
+         */
+        bool append(const Block &block) {
+
+            auto id = static_cast<uint64_t>(block.id);
+
+            std::vector<Posting> added;
+            std::vector<std::string> new_keys;
+
+            auto key_of = [&](const std::string &key) {
+                auto it = key_index.find(key);
+                if (it != key_index.end())
+                    return it->second;
+                auto pending = std::find(new_keys.begin(), new_keys.end(), key);
+                if (pending != new_keys.end())
+                    return static_cast<uint32_t>(keys.size() + (pending - new_keys.begin()));
+                new_keys.push_back(key);
+                return static_cast<uint32_t>(keys.size() + new_keys.size() - 1);
+            };
+
+            //
+            // amounts are checked before anything is written, a malformed one fails the block
+            //
+            std::vector<std::vector<Movement>> moved;
+            for (auto &tx: block.transactions) {
+                auto movements = movements_of(tx);
+                if (!movements) {
+                    error_handler(result::FAIL, ErrorFormat("Wallet index: block %llu has a malformed amount", (unsigned long long) id));
+                    return false;
+                }
+                moved.push_back(std::move(*movements));
+            }
+
+            auto segment_end = segment_size;
+
+            for (uint32_t offset = 0; offset < block.transactions.size(); ++offset) {
+
+                auto &tx = block.transactions[offset];
+
+                auto assets = nlohmann::json::array();
+                for (auto &asset: tx.assets)
+                    assets.push_back(nlohmann::json{{"asset-code", asset.asset_code}, {"amount", asset.amount}});
+
+                auto data = nlohmann::json::to_cbor(nlohmann::json{
+                        {"type", tx.type},
+                        {"id", UInt256ToDecString(tx.id)},
+                        {"from", tx.from},
+                        {"to", tx.to},
+                        {"assets", assets},
+                        {"fee", tx.fee},
+                        {"digest", tx.digest},
+                        {"status", tx.status}
+                });
+
+                uint8_t header[record_header_size];
+                auto length = static_cast<uint32_t>(data.size());
+                for (size_t i = 0; i < record_header_size; ++i)
+                    header[i] = uint8_t(length >> (8 * i));
+
+                segment.write(reinterpret_cast<const char *>(header), sizeof(header));
+                segment.write(reinterpret_cast<const char *>(data.data()), data.size());
+
+                //
+                // postings of one transaction are adjacent in the key postings, one per asset
+                //
+                for (auto &movement: moved[offset]) {
+
+                    auto post = [&](const std::string &key, int64_t delta) {
+                        if (key.empty())
+                            return;
+                        Posting posting{};
+                        posting.block = id;
+                        posting.record = segment_end;
+                        posting.delta = delta;
+                        posting.key = key_of(key);
+                        posting.offset = offset;
+                        posting.asset_code = movement.asset_code;
+                        added.push_back(posting);
+                    };
+
+                    if (tx.from == tx.to)
+                        post(tx.from, movement.from + movement.to);
+                    else {
+                        post(tx.from, movement.from);
+                        post(tx.to, movement.to);
+                    }
+                }
+
+                segment_end += sizeof(header) + data.size();
+            }
+
+            std::string keys_data;
+            for (auto &key: new_keys) {
+                keys_data.push_back(char(key.size() & 0xff));
+                keys_data.push_back(char((key.size() >> 8) & 0xff));
+                keys_data += key;
+            }
+
+            keys_file.write(keys_data.data(), keys_data.size());
+            postings_file.write(reinterpret_cast<const char *>(added.data()), added.size() * sizeof(Posting));
+
+            segment.flush();
+            postings_file.flush();
+            keys_file.flush();
+
+            if (!segment || !postings_file || !keys_file) {
+                segment.clear();
+                postings_file.clear();
+                keys_file.clear();
+                rollback();
+                error_handler(result::FAIL, ErrorFormat("Wallet index: block %llu write failed", (unsigned long long) id));
+                return false;
+            }
+
+            segment_size = segment_end;
+            postings_size += added.size() * sizeof(Posting);
+            keys_size += keys_data.size();
+
+            for (auto &key: new_keys) {
+                key_index.emplace(key, static_cast<uint32_t>(keys.size()));
+                keys.push_back(key);
+                postings.emplace_back();
+            }
+
+            for (auto &posting: added)
+                postings[posting.key].push_back(posting);
+
+            next_block = id + 1;
+
+            if (next_block - checkpoint_block >= checkpoint_interval)
+                write_checkpoint();
+
+            return true;
+        }
+
+        /**
+         * Postings of the key in the block range, must be called under lock
+         */
+        std::pair<const Posting *, const Posting *> range(const std::string &public_key,
+                                                          const uint256_t &first,
+                                                          const uint256_t &last) const {
+            auto it = key_index.find(public_key);
+            if (it == key_index.end() || first > last)
+                return {nullptr, nullptr};
+
+            auto &list = postings[it->second];
+            auto from = static_cast<uint64_t>(std::min<uint256_t>(first, std::numeric_limits<uint64_t>::max()));
+            auto to = static_cast<uint64_t>(std::min<uint256_t>(last, std::numeric_limits<uint64_t>::max()));
+
+            auto begin = std::lower_bound(list.begin(), list.end(), from,
+                                          [](const Posting &p, uint64_t block) { return p.block < block; });
+            auto end = std::upper_bound(begin, list.end(), to,
+                                        [](uint64_t block, const Posting &p) { return block < p.block; });
+
+            return {list.data() + (begin - list.begin()), list.data() + (end - list.begin())};
+        }
+
+        /**
+         * Get mapped transaction, must be called under lock
+         */
+        std::optional<Transaction> record_at(uint64_t offset) const {
+            auto region = static_cast<const uint8_t *>(mapped.get_address());
+            auto size = mapped.get_size();
+
+            if (!region || offset + record_header_size > size)
+                return std::nullopt;
+
+            uint32_t length = 0;
+            for (size_t i = 0; i < record_header_size; ++i)
+                length |= uint32_t(region[offset + i]) << (8 * i);
+
+            if (offset + record_header_size + length > size)
+                return std::nullopt;
+
+            try {
+                auto record = nlohmann::json::from_cbor(region + offset + record_header_size,
+                                                        region + offset + record_header_size + length);
+                Transaction tx;
+                tx.type = record["type"].get<std::string>();
+                StringToUInt256(record["id"].get<std::string>(), tx.id, false);
+                tx.from = record["from"].get<std::string>();
+                tx.to = record["to"].get<std::string>();
+                for (auto &asset: record["assets"])
+                    tx.assets.push_back({asset["asset-code"].get<unsigned short>(), asset["amount"].get<std::string>()});
+                tx.fee = record["fee"].get<std::string>();
+                tx.digest = record["digest"].get<std::string>();
+                tx.status = record["status"].get<std::string>();
+                return tx;
+            }
+            catch (std::exception const &e) {
+                error_handler(result::EXCEPTION, ErrorFormat("Wallet index record %llu: %s", (unsigned long long) offset, e.what()));
+                return std::nullopt;
+            }
+        }
+
+        const fs::path segment_path;
+        const fs::path postings_path;
+        const fs::path keys_path;
+        const fs::path checkpoint_path;
+
+        std::ofstream segment;
+        std::ofstream postings_file;
+        std::ofstream keys_file;
+
+        uint64_t next_block;
+        uint64_t segment_size;
+        uint64_t postings_size;
+        uint64_t keys_size;
+        uint64_t checkpoint_block;
+
+        bip::mapped_region mapped;
+
+        std::vector<std::string> keys;
+        std::unordered_map<std::string, uint32_t> key_index;
+        std::vector<std::vector<Posting>> postings;
+
+        mutable std::shared_mutex mutex;
+
+        const ErrorHandler error_handler;
+    };
+}
+
+namespace milecsa::rpc {
+
+    WalletIndex::WalletIndex(const std::shared_ptr<detail::WalletIndexState> &state): state(state) {}
+
+    WalletIndex::WalletIndex(const WalletIndex &index): state(index.state) {}
+
+    WalletIndex& WalletIndex::operator = (const WalletIndex& index) {
+        state = index.state;
+        return *this;
+    }
+
+    WalletIndex::~WalletIndex(){
+        state.reset();
+    }
+
+    std::optional<WalletIndex> WalletIndex::Open(const std::string &directory, const ErrorHandler &error_handler) {
+        auto state = std::make_shared<detail::WalletIndexState>(directory, error_handler);
+        if (!state->open())
+            return std::nullopt;
+        return WalletIndex(state);
+    }
+
+    bool WalletIndex::add(const Block &block) const {
+
+        std::unique_lock<std::shared_mutex> lock(state->mutex);
+
+        if (block.id < state->next_block)
+            return true;
+
+        if (block.id > state->next_block) {
+            state->error_handler(result::FAIL, ErrorFormat("Wallet index: block %s is got, block %llu is expected",
+                                                           UInt256ToDecString(block.id).c_str(),
+                                                           (unsigned long long) state->next_block));
+            return false;
+        }
+
+        try {
+            return state->append(block);
+        }
+        catch (std::exception const &e) {
+            state->error_handler(result::EXCEPTION, ErrorFormat("Wallet index: %s", e.what()));
+            return false;
+        }
+    }
+
+    bool WalletIndex::sync(const std::vector<ConcurrentClient> &clients,
+                           const std::optional<uint256_t> &last,
+                           size_t window) const {
+
+        if (clients.empty())
+            return false;
+
+        uint256_t last_block = 0;
+
+        if (last)
+            last_block = *last;
+        else if (auto current = clients.front().get_current_block_id())
+            last_block = *current;
+        else
+            return false;
+
+        auto first = get_next_block();
+        if (first > last_block)
+            return true;
+
+        auto blocks = BlockIterator::Start(clients, first, last_block, window, state->error_handler);
+        if (!blocks)
+            return false;
+
+        bool ok = true;
+
+        while (auto json = blocks->next()) {
+            auto block = decode_block(*json);
+            if (!block) {
+                state->error_handler(result::FAIL, ErrorFormat("Wallet index: block %s can't be decoded",
+                                                               UInt256ToDecString(blocks->get_position() - 1).c_str()));
+                ok = false;
+                break;
+            }
+            if (!add(*block)) {
+                ok = false;
+                break;
+            }
+        }
+
+        flush();
+
+        return ok && get_next_block() > last_block;
+    }
+
+    uint256_t WalletIndex::get_next_block() const {
+        std::shared_lock<std::shared_mutex> lock(state->mutex);
+        return state->next_block;
+    }
+
+    std::vector<WalletIndex::Entry> WalletIndex::get_history(const std::string &public_key,
+                                                             size_t limit,
+                                                             const uint256_t &first,
+                                                             const uint256_t &last) const {
+        auto collect = [&]{
+            std::vector<Entry> entries;
+            auto [begin, end] = state->range(public_key, first, last);
+            for (auto p = end; p != begin && entries.size() < limit; ) {
+                --p;
+                if (p + 1 != end && (p + 1)->record == p->record)
+                    continue;
+                auto tx = state->record_at(p->record);
+                if (!tx)
+                    return std::optional<std::vector<Entry>>();
+                entries.push_back({p->block, p->offset, std::move(*tx)});
+            }
+            return std::optional<std::vector<Entry>>(std::move(entries));
+        };
+
+        {
+            std::shared_lock<std::shared_mutex> lock(state->mutex);
+            if (state->mapped.get_size() >= state->segment_size)
+                if (auto entries = collect())
+                    return *entries;
+        }
+
+        //
+        // Records have been appended after the segment was mapped
+        //
+        std::unique_lock<std::shared_mutex> lock(state->mutex);
+
+        try {
+            state->map_segment();
+        }
+        catch (std::exception const &e) {
+            state->error_handler(result::EXCEPTION, ErrorFormat("Wallet index: %s", e.what()));
+            return {};
+        }
+
+        if (auto entries = collect())
+            return *entries;
+
+        return {};
+    }
+
+    std::map<unsigned short, int64_t> WalletIndex::get_balance_delta(const std::string &public_key,
+                                                                     const uint256_t &first,
+                                                                     const uint256_t &last) const {
+        std::shared_lock<std::shared_mutex> lock(state->mutex);
+        std::map<unsigned short, int64_t> delta;
+        auto [begin, end] = state->range(public_key, first, last);
+        for (auto p = begin; p != end; ++p)
+            delta[p->asset_code] += p->delta;
+        return delta;
+    }
+
+    size_t WalletIndex::count(const std::string &public_key) const {
+        std::shared_lock<std::shared_mutex> lock(state->mutex);
+        auto it = state->key_index.find(public_key);
+        if (it == state->key_index.end())
+            return 0;
+        auto &list = state->postings[it->second];
+        size_t transactions = 0;
+        for (size_t i = 0; i < list.size(); ++i) {
+            if (i == 0 || list[i].record != list[i - 1].record)
+                ++transactions;
+        }
+        return transactions;
+    }
+
+    void WalletIndex::flush() const {
+        std::unique_lock<std::shared_mutex> lock(state->mutex);
+        state->write_checkpoint();
+    }
+}
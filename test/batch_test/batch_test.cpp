@@ -0,0 +1,185 @@
+//
+// Created by lotus mile on 2026-10-17.
+//
+
+#define BOOST_TEST_MODULE batch
+
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include "milecsa_rpc_session.hpp"
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/test/included/unit_test.hpp>
+
+using RpcSession = milecsa::rpc::detail::RpcSession;
+using tcp = boost::asio::ip::tcp;
+namespace beast = boost::beast;
+
+/**
+ * Local node does not support batches: batch request is replied with batch_status and batch_body,
+ * a single error object by default, other requests get true result
+ */
+struct ScriptedNode {
+
+    ScriptedNode(beast::http::status batch_status,
+                 const std::string &batch_body = R"({"jsonrpc":"2.0","error":{"code":-32600,"message":"Invalid Request"},"id":null})"):
+            batch_status(batch_status),
+            batch_body(batch_body),
+            acceptor(ioc, tcp::endpoint(boost::asio::ip::make_address("127.0.0.1"), 0)),
+            thread([this]{ serve(); }) {}
+
+    ~ScriptedNode() {
+        stopped = true;
+        boost::asio::io_context wake;
+        tcp::socket socket(wake);
+        boost::system::error_code ec;
+        socket.connect(acceptor.local_endpoint(), ec);
+        thread.join();
+    }
+
+    uint64_t port() const { return acceptor.local_endpoint().port(); }
+
+    std::vector<std::string> received() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return methods;
+    }
+
+    void serve() {
+        while (!stopped) {
+            tcp::socket socket(ioc);
+            boost::system::error_code ec;
+            acceptor.accept(socket, ec);
+            if (ec || stopped)
+                return;
+            beast::flat_buffer buffer;
+            for (;;) {
+                beast::http::request<beast::http::string_body> req;
+                beast::http::read(socket, buffer, req, ec);
+                if (ec)
+                    break;
+
+                auto body = milecsa::rpc::json::parse(req.body());
+
+                beast::http::response<beast::http::string_body> res;
+                res.version(11);
+                res.keep_alive(true);
+                res.set(beast::http::field::content_type, "application/json");
+
+                if (body.is_array()) {
+                    record("batch");
+                    res.result(batch_status);
+                    res.body() = batch_body;
+                }
+                else {
+                    record(body["method"].get<std::string>());
+                    res.result(beast::http::status::ok);
+                    res.body() = milecsa::rpc::json{{"jsonrpc", "2.0"}, {"result", true}, {"id", body["id"]}}.dump();
+                }
+
+                res.prepare_payload();
+                beast::http::write(socket, res, ec);
+                if (ec)
+                    break;
+            }
+        }
+    }
+
+    void record(const std::string &method) {
+        std::lock_guard<std::mutex> lock(mutex);
+        methods.push_back(method);
+    }
+
+    beast::http::status batch_status;
+    std::string batch_body;
+    boost::asio::io_context ioc;
+    tcp::acceptor acceptor;
+    std::atomic<bool> stopped{false};
+    std::mutex mutex;
+    std::vector<std::string> methods;
+    std::thread thread;
+};
+
+struct BatchEval {
+
+    size_t errors = 0;
+    size_t fails = 0;
+
+    milecsa::ErrorHandler error_handler = [this](milecsa::result, const std::string &error){
+        BOOST_TEST_MESSAGE("Batch error: " + error);
+        ++errors;
+    };
+
+    milecsa::http::ResponseHandler response_handler = [this](const milecsa::http::status, const std::string &,
+                                                             const milecsa::http::response &){
+        ++fails;
+    };
+
+    std::vector<milecsa::rpc::response> batch(ScriptedNode &node) {
+        RpcSession session("127.0.0.1", node.port(), "/", milecsa::rpc::Url::protocol::http, false);
+        BOOST_REQUIRE(session.connect(error_handler));
+        std::vector<milecsa::rpc::request> commands = {
+                session.next_command("ping"),
+                session.next_command("send-transaction", {{"transaction-id", "1"}}),
+                session.next_command("get-current-block-id")
+        };
+        return session.batch(commands, response_handler, error_handler);
+    }
+};
+
+BOOST_FIXTURE_TEST_CASE( BatchNotArrayFallback, BatchEval )
+{
+    ScriptedNode node(beast::http::status::ok);
+
+    auto results = batch(node);
+
+    BOOST_REQUIRE_EQUAL(results.size(), 3);
+    BOOST_CHECK(results[0] && *results[0] == true);
+    BOOST_CHECK(!results[1]);
+    BOOST_CHECK(results[2] && *results[2] == true);
+    BOOST_CHECK_EQUAL(errors, 1);
+
+    //
+    // only idempotent commands are sent again
+    //
+    auto received = node.received();
+    BOOST_REQUIRE_EQUAL(received.size(), 3);
+    BOOST_CHECK_EQUAL(received[0], "batch");
+    BOOST_CHECK_EQUAL(received[1], "ping");
+    BOOST_CHECK_EQUAL(received[2], "get-current-block-id");
+}
+
+BOOST_FIXTURE_TEST_CASE( BatchFailedStatus, BatchEval )
+{
+    ScriptedNode node(beast::http::status::bad_gateway);
+
+    auto results = batch(node);
+
+    BOOST_REQUIRE_EQUAL(results.size(), 3);
+    for (auto &result: results)
+        BOOST_CHECK(!result);
+    BOOST_CHECK_EQUAL(fails, 3);
+
+    auto received = node.received();
+    BOOST_REQUIRE_EQUAL(received.size(), 1);
+    BOOST_CHECK_EQUAL(received[0], "batch");
+}
+
+BOOST_FIXTURE_TEST_CASE( BatchMalformedReply, BatchEval )
+{
+    ScriptedNode node(beast::http::status::ok, R"([{"jsonrpc":"2.0","result":true,)");
+
+    auto results = batch(node);
+
+    BOOST_REQUIRE_EQUAL(results.size(), 3);
+    for (auto &result: results)
+        BOOST_CHECK(!result);
+    BOOST_CHECK_EQUAL(errors, 1);
+
+    //
+    // malformed reply does not mean batches are not supported
+    //
+    auto received = node.received();
+    BOOST_REQUIRE_EQUAL(received.size(), 1);
+    BOOST_CHECK_EQUAL(received[0], "batch");
+}
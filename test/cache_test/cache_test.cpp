@@ -0,0 +1,178 @@
+//
+// Created by lotus mile on 2026-10-17.
+//
+
+#define BOOST_TEST_MODULE cache
+
+#include <thread>
+#include <filesystem>
+#include <csignal>
+#include <sys/resource.h>
+#include "milecsa_cache.hpp"
+#include "milecsa_block_store.hpp"
+#include <boost/test/included/unit_test.hpp>
+
+using BlockCache = milecsa::rpc::BlockCache;
+using TtlCache = milecsa::rpc::TtlCache;
+using BlockStore = milecsa::rpc::BlockStore;
+
+static nlohmann::json make_block(uint64_t id, size_t payload = 16) {
+    return {{"block-id", std::to_string(id)}, {"payload", std::string(payload, 'x')}};
+}
+
+BOOST_AUTO_TEST_CASE( BlockCacheHits )
+{
+    BlockCache cache(1024 * 1024, 4);
+
+    BOOST_CHECK(!cache.get(1));
+
+    cache.put(1, make_block(1));
+    auto block = cache.get(1);
+
+    BOOST_CHECK(block);
+    BOOST_CHECK((*block)["block-id"] == "1");
+
+    auto stat = cache.get_stat();
+    BOOST_CHECK_EQUAL(stat.hits, 1);
+    BOOST_CHECK_EQUAL(stat.misses, 1);
+    BOOST_CHECK_EQUAL(stat.entries, 1);
+}
+
+BOOST_AUTO_TEST_CASE( BlockCacheEviction )
+{
+    //
+    // One shard holds three blocks at most
+    //
+    auto size = std::string("0").size() + BlockCache::estimate_size(make_block(0, 100));
+    BlockCache cache(size * 3, 1);
+
+    for (uint64_t i = 0; i < 3; ++i)
+        cache.put(i, make_block(i, 100));
+
+    BOOST_CHECK(cache.get(0));
+
+    cache.put(3, make_block(3, 100));
+
+    BOOST_CHECK(cache.get(0));
+    BOOST_CHECK(!cache.get(1));
+    BOOST_CHECK(cache.get(2));
+    BOOST_CHECK(cache.get(3));
+
+    auto stat = cache.get_stat();
+    BOOST_CHECK_EQUAL(stat.evictions, 1);
+    BOOST_CHECK_EQUAL(stat.entries, 3);
+    BOOST_CHECK(stat.bytes <= size * 3);
+
+    cache.clear();
+    BOOST_CHECK_EQUAL(cache.get_stat().entries, 0);
+}
+
+BOOST_AUTO_TEST_CASE( TtlCacheExpiration )
+{
+    TtlCache cache(std::chrono::milliseconds(50));
+
+    cache.put("get-blockchain-info", {{"project", "MILE"}});
+    BOOST_CHECK(cache.get("get-blockchain-info"));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    BOOST_CHECK(!cache.get("get-blockchain-info"));
+    BOOST_CHECK_EQUAL(cache.get_stat().evictions, 1);
+}
+
+BOOST_AUTO_TEST_CASE( BlockStoreRestart )
+{
+    auto directory = std::filesystem::temp_directory_path() / "milecsa_block_store_test";
+    std::filesystem::remove_all(directory);
+
+    milecsa::ErrorHandler error_handler = [](milecsa::result code, const std::string &error){
+        BOOST_TEST_MESSAGE("Block store error: " + error);
+    };
+
+    {
+        auto store = BlockStore::Open(directory.string(), error_handler);
+        BOOST_REQUIRE(store);
+
+        BOOST_CHECK(!store->get(7));
+
+        for (uint64_t i = 0; i < 100; ++i)
+            BOOST_CHECK(store->put(i * 1000, make_block(i * 1000)));
+
+        BOOST_CHECK(store->contains(1000));
+        BOOST_CHECK(!store->contains(1001));
+        BOOST_CHECK((*store->get(99000))["block-id"] == "99000");
+        BOOST_CHECK_EQUAL(store->size(), 100);
+    }
+
+    auto store = BlockStore::Open(directory.string(), error_handler);
+    BOOST_REQUIRE(store);
+
+    BOOST_CHECK_EQUAL(store->size(), 100);
+    BOOST_CHECK((*store->get(42000))["block-id"] == "42000");
+
+    BOOST_CHECK(store->put(100000, make_block(100000)));
+    BOOST_CHECK((*store->get(100000))["block-id"] == "100000");
+
+    std::filesystem::remove_all(directory);
+}
+
+BOOST_AUTO_TEST_CASE( BlockStoreFailedWrite )
+{
+    auto directory = std::filesystem::temp_directory_path() / "milecsa_block_store_failed_write_test";
+    std::filesystem::remove_all(directory);
+
+    size_t errors = 0;
+    milecsa::ErrorHandler error_handler = [&](milecsa::result code, const std::string &error){
+        BOOST_TEST_MESSAGE("Block store error: " + error);
+        ++errors;
+    };
+
+    {
+        auto store = BlockStore::Open(directory.string(), error_handler);
+        BOOST_REQUIRE(store);
+
+        for (uint64_t i = 0; i < 10; ++i)
+            BOOST_CHECK(store->put(i, make_block(i)));
+
+        auto segment = directory / "blocks.segment";
+        auto segment_size = std::filesystem::file_size(segment);
+
+        //
+        // file size limit makes the large record be written partially
+        //
+        rlimit saved{};
+        getrlimit(RLIMIT_FSIZE, &saved);
+        auto handler = std::signal(SIGXFSZ, SIG_IGN);
+
+        rlimit limit = saved;
+        limit.rlim_cur = segment_size + 1024;
+        BOOST_REQUIRE(setrlimit(RLIMIT_FSIZE, &limit) == 0);
+
+        BOOST_CHECK(!store->put(10, make_block(10, 64 * 1024)));
+
+        setrlimit(RLIMIT_FSIZE, &saved);
+        std::signal(SIGXFSZ, handler);
+
+        BOOST_CHECK_EQUAL(errors, 1);
+        BOOST_CHECK(!store->contains(10));
+        BOOST_CHECK_EQUAL(std::filesystem::file_size(segment), segment_size);
+
+        //
+        // next records are found at their offsets
+        //
+        BOOST_CHECK(store->put(11, make_block(11)));
+        BOOST_CHECK(store->put(10, make_block(10, 64 * 1024)));
+        BOOST_CHECK((*store->get(11))["block-id"] == "11");
+        BOOST_CHECK((*store->get(10))["payload"].get<std::string>().size() == 64 * 1024);
+        BOOST_CHECK_EQUAL(store->size(), 12);
+    }
+
+    auto store = BlockStore::Open(directory.string(), error_handler);
+    BOOST_REQUIRE(store);
+
+    BOOST_CHECK_EQUAL(store->size(), 12);
+    BOOST_CHECK((*store->get(11))["block-id"] == "11");
+    BOOST_CHECK((*store->get(9))["block-id"] == "9");
+
+    std::filesystem::remove_all(directory);
+}
@@ -0,0 +1,69 @@
+//
+// Created by lotus mile on 2026-10-17.
+//
+
+#define BOOST_TEST_MODULE deadline
+
+#include <chrono>
+#include "milecsa_rpc_deadline.hpp"
+#include <boost/test/included/unit_test.hpp>
+
+using CancelToken = milecsa::rpc::CancelToken;
+using CallContext = milecsa::rpc::CallContext;
+using AdaptiveTimeout = milecsa::rpc::AdaptiveTimeout;
+
+BOOST_AUTO_TEST_CASE( CallContextDeadline )
+{
+    using namespace std::chrono;
+
+    CancelToken token;
+    int called = 0;
+
+    auto first = token.subscribe([&called]{ ++called; });
+    auto second = token.subscribe([&called]{ called += 10; });
+    token.unsubscribe(second);
+
+    auto context = CallContext::Timeout(milliseconds(200), token);
+
+    BOOST_CHECK(!context.is_cancelled());
+    BOOST_CHECK(!context.is_expired());
+    BOOST_CHECK(context.bound(milliseconds(50)) == milliseconds(50));
+    BOOST_CHECK(context.bound(seconds(10)) <= milliseconds(200));
+
+    CancelToken copy = token;
+    copy.cancel();
+    copy.cancel();
+
+    BOOST_CHECK(context.is_cancelled());
+    BOOST_CHECK(called == 1);
+
+    token.unsubscribe(first);
+    token.subscribe([&called]{ ++called; });
+    BOOST_CHECK(called == 2);
+
+    auto expired = CallContext::Timeout(milliseconds(0));
+    BOOST_CHECK(expired.is_expired());
+    BOOST_CHECK(expired.bound(seconds(1)) == milliseconds(0));
+
+    BOOST_CHECK(CallContext().bound(seconds(3)) == seconds(3));
+}
+
+BOOST_AUTO_TEST_CASE( AdaptiveTimeoutBounds )
+{
+    using namespace std::chrono;
+
+    AdaptiveTimeout timeout(milliseconds(20), milliseconds(3000));
+
+    BOOST_CHECK(timeout.get() == milliseconds(3000));
+
+    for (int i = 0; i < 100; ++i)
+        timeout.observe(milliseconds(10));
+
+    BOOST_CHECK(timeout.get() >= milliseconds(20));
+    BOOST_CHECK(timeout.get() < milliseconds(100));
+
+    for (int i = 0; i < 100; ++i)
+        timeout.observe(seconds(10));
+
+    BOOST_CHECK(timeout.get() == milliseconds(3000));
+}
@@ -0,0 +1,163 @@
+//
+// Created by lotus mile on 2026-10-17.
+//
+
+#define BOOST_TEST_MODULE hedged
+
+#include <thread>
+#include <future>
+#include <atomic>
+#include "milecsa_hedged_client.hpp"
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/test/included/unit_test.hpp>
+
+using HedgedClient = milecsa::rpc::HedgedClient;
+using HedgePolicy = milecsa::rpc::HedgePolicy;
+using ConcurrentClient = milecsa::rpc::ConcurrentClient;
+using tcp = boost::asio::ip::tcp;
+namespace beast = boost::beast;
+
+/**
+ * Local node serves every connection by its own thread, get-current-block-id is replied
+ * after the node delay
+ */
+struct StubNode {
+
+    StubNode(std::chrono::milliseconds delay):
+            delay(delay),
+            acceptor(ioc, tcp::endpoint(boost::asio::ip::make_address("127.0.0.1"), 0)),
+            thread([this]{ serve(); }) {}
+
+    ~StubNode() {
+        stopped = true;
+        boost::asio::io_context wake;
+        tcp::socket socket(wake);
+        boost::system::error_code ec;
+        socket.connect(acceptor.local_endpoint(), ec);
+        thread.join();
+        for (auto &connection: connections)
+            connection.join();
+    }
+
+    std::string url() const {
+        return "http://127.0.0.1:" + std::to_string(acceptor.local_endpoint().port()) + "/";
+    }
+
+    void serve() {
+        while (!stopped) {
+            tcp::socket socket(ioc);
+            boost::system::error_code ec;
+            acceptor.accept(socket, ec);
+            if (ec || stopped)
+                return;
+            connections.emplace_back([this, s = std::move(socket)]() mutable { reply(s); });
+        }
+    }
+
+    void reply(tcp::socket &socket) {
+        beast::flat_buffer buffer;
+        for (;;) {
+            boost::system::error_code ec;
+            beast::http::request<beast::http::string_body> req;
+            beast::http::read(socket, buffer, req, ec);
+            if (ec)
+                return;
+
+            auto body = milecsa::rpc::json::parse(req.body());
+            milecsa::rpc::json result = true;
+
+            if (body["method"].get<std::string>() == "get-current-block-id") {
+                std::this_thread::sleep_for(delay);
+                result = {{"current-block-id", "12345"}};
+            }
+
+            beast::http::response<beast::http::string_body> res;
+            res.version(11);
+            res.keep_alive(true);
+            res.result(beast::http::status::ok);
+            res.set(beast::http::field::content_type, "application/json");
+            res.body() = milecsa::rpc::json{{"jsonrpc", "2.0"}, {"result", result}, {"id", body["id"]}}.dump();
+            res.prepare_payload();
+            beast::http::write(socket, res, ec);
+            if (ec)
+                return;
+        }
+    }
+
+    const std::chrono::milliseconds delay;
+
+    boost::asio::io_context ioc;
+    tcp::acceptor acceptor;
+    std::atomic<bool> stopped{false};
+
+    std::vector<std::thread> connections;
+    std::thread thread;
+};
+
+/**
+ * Hedged client holds the only copies of the node clients
+ */
+static std::optional<HedgedClient> start(const std::vector<StubNode*> &nodes, const HedgePolicy &policy) {
+    milecsa::ErrorHandler error_handler = [](milecsa::result, const std::string &error){
+        BOOST_TEST_MESSAGE("Hedged error: " + error);
+    };
+
+    std::vector<ConcurrentClient> clients;
+    for (auto node: nodes) {
+        auto client = ConcurrentClient::Connect(
+                node->url(), 1, 1, 2, false, milecsa::http::default_response_handler, error_handler);
+        if (!client)
+            return std::nullopt;
+        clients.push_back(*client);
+    }
+
+    return HedgedClient::Start(clients, policy, error_handler);
+}
+
+/**
+ * Handler drops the last client copy and must return, the state is released by the io threads
+ */
+static bool release_in_handler(std::optional<HedgedClient> &client) {
+    auto released = std::make_shared<std::promise<bool>>();
+    auto future = released->get_future();
+
+    client->async_get_current_block_id([&client, released](const std::optional<uint256_t> &id){
+        client.reset();
+        released->set_value(id.has_value());
+    });
+
+    if (future.wait_for(std::chrono::seconds(10)) != std::future_status::ready)
+        return false;
+
+    return future.get() && !client;
+}
+
+BOOST_AUTO_TEST_CASE( HandlerReleasesLastCopy )
+{
+    StubNode node(std::chrono::milliseconds(0));
+
+    auto client = start({&node}, HedgePolicy());
+    BOOST_REQUIRE(client);
+
+    BOOST_CHECK(release_in_handler(client));
+}
+
+BOOST_AUTO_TEST_CASE( HandlerReleasesLastCopyWhileHedged )
+{
+    StubNode fast(std::chrono::milliseconds(0));
+    StubNode slow(std::chrono::milliseconds(200));
+
+    //
+    // hedge is sent at once, the winner handler runs while the other attempt is outstanding
+    //
+    HedgePolicy policy;
+    policy.min_delay = 0;
+    policy.max_delay = 0;
+    policy.max_extra_load = 1.0;
+
+    auto client = start({&slow, &fast}, policy);
+    BOOST_REQUIRE(client);
+
+    BOOST_CHECK(release_in_handler(client));
+}
@@ -0,0 +1,193 @@
+//
+// Created by lotus mile on 2026-10-17.
+//
+
+#define BOOST_TEST_MODULE inflate
+
+#include "milecsa_inflate_body.hpp"
+#include "milecsa_rpc_session.hpp"
+#include <boost/beast/http/parser.hpp>
+#include <zlib.h>
+#include <boost/test/included/unit_test.hpp>
+
+using InflateBody = milecsa::http::inflate_body;
+
+static std::string compress(const std::string &data, int window_bits) {
+    z_stream stream = {};
+    deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, window_bits, 8, Z_DEFAULT_STRATEGY);
+    std::string out(deflateBound(&stream, data.size()) + 32, '\0');
+    stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+    stream.avail_in = static_cast<uInt>(data.size());
+    stream.next_out = reinterpret_cast<Bytef *>(&out[0]);
+    stream.avail_out = static_cast<uInt>(out.size());
+    deflate(&stream, Z_FINISH);
+    out.resize(stream.total_out);
+    deflateEnd(&stream);
+    return out;
+}
+
+static std::string make_data() {
+    std::string data;
+    for (int i = 0; i < 10000; ++i)
+        data += "{\"jsonrpc\":\"2.0\",\"id\":" + std::to_string(i) + "}";
+    return data;
+}
+
+static boost::system::error_code parse(const std::string &body,
+                                       const std::string &encoding,
+                                       size_t chunk,
+                                       std::string &decoded,
+                                       size_t limit = std::numeric_limits<size_t>::max()) {
+
+    auto header = "HTTP/1.1 200 OK\r\nContent-Encoding: " + encoding + "\r\nContent-Length: " +
+                  std::to_string(body.size()) + "\r\n\r\n";
+
+    boost::beast::http::response_parser<InflateBody> parser;
+    parser.get().body().limit = limit;
+
+    boost::system::error_code ec;
+    parser.put(boost::asio::buffer(header), ec);
+    if (ec)
+        return ec;
+
+    //
+    // body is inflated chunk by chunk as it arrives
+    //
+    size_t offset = 0;
+    while (offset < body.size() && !ec && !parser.is_done()) {
+        auto size = std::min(chunk, body.size() - offset);
+        offset += parser.put(boost::asio::buffer(body.data() + offset, size), ec);
+        if (ec == boost::beast::http::error::need_more)
+            ec = {};
+    }
+
+    decoded = parser.get().body();
+    return ec;
+}
+
+BOOST_AUTO_TEST_CASE( InflateBodyStream )
+{
+    auto data = make_data();
+
+    auto body = compress(data, 15 + 16);
+    BOOST_CHECK(body.size() < data.size());
+
+    std::string decoded;
+    BOOST_CHECK(!parse(body, "gzip", 97, decoded));
+    BOOST_CHECK(decoded == data);
+
+    //
+    // truncated stream is reported instead of the partial body
+    //
+    auto truncated = body.substr(0, body.size() / 2);
+    BOOST_CHECK(parse(truncated + std::string(body.size() - truncated.size(), '\0'), "gzip", 97, decoded));
+}
+
+BOOST_AUTO_TEST_CASE( InflateBodyFormats )
+{
+    auto data = make_data();
+    std::string decoded;
+
+    //
+    // zlib and raw deflate are both sent as "deflate", the format is known by the first two bytes
+    // even if they come in separate writes
+    //
+    BOOST_CHECK(!parse(compress(data, 15), "deflate", 1, decoded));
+    BOOST_CHECK(decoded == data);
+
+    BOOST_CHECK(!parse(compress(data, -15), "deflate", 1, decoded));
+    BOOST_CHECK(decoded == data);
+
+    BOOST_CHECK(!parse(compress(data, -15), "deflate", 4096, decoded));
+    BOOST_CHECK(decoded == data);
+}
+
+BOOST_AUTO_TEST_CASE( InflateBodyLimit )
+{
+    auto data = make_data();
+    auto body = compress(data, 15 + 16);
+    std::string decoded;
+
+    BOOST_CHECK(parse(body, "gzip", 97, decoded, data.size() - 1) == boost::beast::http::error::body_limit);
+    BOOST_CHECK(decoded.size() <= data.size() - 1);
+
+    BOOST_CHECK(!parse(body, "gzip", 97, decoded, data.size()));
+    BOOST_CHECK(decoded == data);
+
+    BOOST_CHECK(parse(data, "identity", 97, decoded, data.size() - 1) == boost::beast::http::error::body_limit);
+}
+
+BOOST_AUTO_TEST_CASE( CompressionBySize )
+{
+    milecsa::http::Session session("127.0.0.1", 80, "/", milecsa::http::Url::protocol::http);
+
+    boost::beast::http::fields fields;
+
+    session.prepare_encoding(fields, "get-block-by-id");
+    BOOST_CHECK(fields.count(boost::beast::http::field::accept_encoding) == 1);
+
+    //
+    // small response turns compression of the method off for the next requests
+    //
+    milecsa::http::response res{boost::beast::http::status::ok, 11};
+    res.body() = "{\"result\":{}}";
+
+    session.observe_encoding("get-block-by-id", res);
+    session.prepare_encoding(fields, "get-block-by-id");
+    BOOST_CHECK(fields.count(boost::beast::http::field::accept_encoding) == 0);
+
+    session.prepare_encoding(fields, "get-wallet-state");
+    BOOST_CHECK(fields.count(boost::beast::http::field::accept_encoding) == 1);
+}
+
+BOOST_AUTO_TEST_CASE( InflateBodySink )
+{
+    std::string result = "[";
+    for (int i = 0; i < 10000; ++i)
+        result += (i ? ",{\"id\":" : "{\"id\":") + std::to_string(i) + ",\"name\":\"\\u00e9\\ud83d\\ude00\"}";
+    result += "]";
+
+    auto data = "{\"jsonrpc\":\"2.0\",\"id\":7,\"result\":" + result + "}";
+    auto body = compress(data, 15 + 16);
+
+    auto header = "HTTP/1.1 200 OK\r\nContent-Encoding: gzip\r\nContent-Length: " +
+                  std::to_string(body.size()) + "\r\n\r\n";
+
+    milecsa::rpc::detail::DomResponse response;
+
+    boost::beast::http::response_parser<InflateBody> parser;
+    parser.get().body().sink = &response;
+
+    boost::system::error_code ec;
+    parser.put(boost::asio::buffer(header), ec);
+    BOOST_CHECK(!ec);
+
+    //
+    // result is parsed as the content arrives, the body keeps the first bytes only
+    //
+    size_t offset = 0;
+    while (offset < body.size() && !ec && !parser.is_done()) {
+        auto size = std::min<size_t>(61, body.size() - offset);
+        offset += parser.put(boost::asio::buffer(body.data() + offset, size), ec);
+        if (ec == boost::beast::http::error::need_more)
+            ec = {};
+    }
+
+    BOOST_CHECK(!ec);
+    BOOST_CHECK(parser.get().body().streamed);
+    BOOST_CHECK(parser.get().body().content_size() == data.size());
+    BOOST_CHECK(parser.get().body().size() < data.size());
+
+    BOOST_CHECK(!response.parser.parser.error);
+    BOOST_CHECK(response.parser.envelope.id);
+    BOOST_CHECK(response.parser.envelope.has_result);
+    BOOST_CHECK(response.dom.value == nlohmann::json::parse(result));
+
+    //
+    // malformed content is reported by the parser
+    //
+    response.start();
+    response.write(data.data(), data.size() - 1);
+    response.finish();
+    BOOST_CHECK(response.parser.parser.error);
+}
@@ -0,0 +1,251 @@
+//
+// Created by lotus mile on 2026-10-17.
+//
+
+#define BOOST_TEST_MODULE json_parser
+
+#include "milecsa_rpc_sax.hpp"
+#include <boost/test/included/unit_test.hpp>
+
+using milecsa::rpc::detail::JsonPushParser;
+
+///
+/// Handler records events as text, it stops parsing after the limit of events
+///
+class Events: public milecsa::rpc::ResultSax {
+
+public:
+
+    bool null() override { return add("null"); }
+    bool boolean(bool val) override { return add(val ? "true" : "false"); }
+    bool number_integer(number_integer_t val) override { return add("i:" + std::to_string(val)); }
+    bool number_unsigned(number_unsigned_t val) override { return add("u:" + std::to_string(val)); }
+    bool number_float(number_float_t, const string_t &s) override { return add("f:" + s); }
+    bool string(string_t &val) override { return add("s:" + val); }
+#ifdef MILECSA_JSON_SAX_BINARY
+    bool binary(binary_t &) override { return add("binary"); }
+#endif
+    bool start_object(std::size_t) override { return add("{"); }
+    bool key(string_t &val) override { return add("k:" + val); }
+    bool end_object() override { return add("}"); }
+    bool start_array(std::size_t) override { return add("["); }
+    bool end_array() override { return add("]"); }
+    bool parse_error(std::size_t, const std::string &, const nlohmann::detail::exception &) override { return false; }
+
+    std::vector<std::string> events;
+    size_t limit = std::numeric_limits<size_t>::max();
+
+private:
+
+    bool add(const std::string &event) {
+        events.push_back(event);
+        return events.size() < limit;
+    }
+};
+
+typedef std::vector<std::string> events_t;
+
+///
+/// Parse text written by pieces of the chunk size
+/// @return events or nullopt on parse error
+///
+static std::optional<events_t> parse(const std::string &text, size_t chunk = std::numeric_limits<size_t>::max()) {
+    Events events;
+    JsonPushParser parser(events);
+    for (size_t offset = 0; offset < text.size(); offset += chunk)
+        parser.write(text.data() + offset, std::min(chunk, text.size() - offset));
+    if (!parser.finish())
+        return std::nullopt;
+    return events.events;
+}
+
+static bool valid(const std::string &text) {
+    return parse(text) && parse(text, 1);
+}
+
+BOOST_AUTO_TEST_CASE( JsonPushParserNumbers )
+{
+    BOOST_CHECK(parse("[-12,0,-0,7,1.5e3,-2E-2,0.25,1e+2]") ==
+                events_t({"[", "i:-12", "u:0", "i:0", "u:7", "f:1.5e3", "f:-2E-2", "f:0.25", "f:1e+2", "]"}));
+
+    //
+    // integers out of 64 bits are taken as float
+    //
+    BOOST_CHECK(parse("[18446744073709551615,-9223372036854775808,18446744073709551616,-9223372036854775809]") ==
+                events_t({"[", "u:18446744073709551615", "i:-9223372036854775808",
+                          "f:18446744073709551616", "f:-9223372036854775809", "]"}));
+
+    milecsa::rpc::detail::DomSax dom;
+    JsonPushParser parser(dom);
+    BOOST_CHECK(parser.write("[184467440737095516160]", 23) && parser.finish());
+    BOOST_CHECK(dom.value[0].get<double>() == 184467440737095516160.0);
+
+    //
+    // overflow is an error, underflow is rounded
+    //
+    BOOST_CHECK(!parse("1e400"));
+    BOOST_CHECK(!parse("[-1e400]"));
+    BOOST_CHECK(parse("1e-400") == events_t({"f:1e-400"}));
+
+    //
+    // number grammar
+    //
+    for (auto text: {"01", "-01", "[00]", "-", "1.", ".5", "+1", "1e", "1e+", "1.e3", "--1", "0x10", "1-2"})
+        BOOST_CHECK_MESSAGE(!parse(text), text);
+}
+
+BOOST_AUTO_TEST_CASE( JsonPushParserLiterals )
+{
+    events_t expected = {"[", "true", "false", "null", "]"};
+
+    BOOST_CHECK(parse("[true,false,null]") == expected);
+    BOOST_CHECK(parse("[true,false,null]", 1) == expected);
+    BOOST_CHECK(parse("[true,false,null]", 2) == expected);
+    BOOST_CHECK(parse("[true,false,null]", 3) == expected);
+
+    BOOST_CHECK(parse("true", 1) == events_t({"true"}));
+    BOOST_CHECK(parse(" null ", 1) == events_t({"null"}));
+
+    for (auto text: {"tru", "nul", "truex", "[nulll]", "True", "[fals]", "nan", "[t]"})
+        BOOST_CHECK_MESSAGE(!valid(text) && !parse(text, 1), text);
+}
+
+BOOST_AUTO_TEST_CASE( JsonPushParserStrings )
+{
+    BOOST_CHECK(parse(R"(["a\"\\\/\b\f\n\r\t"])") == events_t({"[", "s:a\"\\/\b\f\n\r\t", "]"}));
+    BOOST_CHECK(parse(R"("\u0041\u00e9\u20ac\ud83d\ude00")", 1) == events_t({"s:A\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80"}));
+
+    //
+    // bad escapes and lone surrogates
+    //
+    for (auto text: {R"("\x")", R"("\u12G4")", R"("\u12")", R"("\ud83d")", R"("\ud83dx")",
+                     R"("\ud83d\n")", R"("\ud83d\u0041")", R"("\ude00")", R"("abc)", "\"a\nb\""})
+        BOOST_CHECK_MESSAGE(!parse(text) && !parse(text, 1), text);
+
+    //
+    // raw UTF-8 is passed as is when it is well-formed
+    //
+    BOOST_CHECK(parse("\"\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80\"", 1) == events_t({"s:\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80"}));
+
+    for (auto text: {"\"\xc3\"", "\"\xc3\x41\"", "\"\xc0\xaf\"", "\"\xe0\x80\xaf\"", "\"\xed\xa0\x80\"",
+                     "\"\xf4\x90\x80\x80\"", "\"\xf5\x80\x80\x80\"", "\"\x80\"", "\"\xff\""})
+        BOOST_CHECK_MESSAGE(!parse(text) && !parse(text, 1), text);
+}
+
+BOOST_AUTO_TEST_CASE( JsonPushParserStructure )
+{
+    BOOST_CHECK(parse(" { \"a\" : [ 1 , { } , [ ] ] } ") ==
+                events_t({"{", "k:a", "[", "u:1", "{", "}", "[", "]", "]", "}"}));
+
+    //
+    // trailing garbage and broken containers
+    //
+    for (auto text: {"{} x", "1 2", "{}}", "[]]", "[1,]", "{\"a\":1,}", "{\"a\"}", "{\"a\" 1}", "{1:2}",
+                     "[1 2]", "[", "{", "", " ", "[}", "{]", "\"a\" \"b\""})
+        BOOST_CHECK_MESSAGE(!parse(text) && !parse(text, 1), text);
+}
+
+BOOST_AUTO_TEST_CASE( JsonPushParserStop )
+{
+    Events events;
+    events.limit = 3;
+
+    JsonPushParser parser(events);
+
+    //
+    // handler has stopped parsing: the rest of the text is not read and is not an error
+    //
+    std::string text = "[1,2,3,4";
+    BOOST_CHECK(!parser.write(text.data(), text.size()));
+    BOOST_CHECK(parser.stopped);
+    BOOST_CHECK(!parser.error);
+    BOOST_CHECK(!parser.write("]", 1));
+    BOOST_CHECK(parser.finish());
+    BOOST_CHECK(events.events == events_t({"[", "u:1", "u:2"}));
+
+    //
+    // stopped sink of the envelope gets no more events, the envelope id is read anyway
+    //
+    Events result;
+    result.limit = 1;
+
+    milecsa::rpc::detail::ResponseParser response(result);
+    std::string envelope = R"({"jsonrpc":"2.0","result":{"a":[1,2]},"id":"42"})";
+
+    response.start();
+    response.write(envelope.data(), envelope.size());
+    response.finish();
+
+    BOOST_CHECK(!response.parser.error);
+    BOOST_CHECK(result.events == events_t({"{"}));
+    BOOST_CHECK(response.envelope.has_result);
+    BOOST_CHECK(response.envelope.id && *response.envelope.id == "42");
+}
+
+BOOST_AUTO_TEST_CASE( ResponseParserNullId )
+{
+    //
+    // error reply with null id has no id to compare and no result, it is failed as a response
+    //
+    Events result;
+
+    milecsa::rpc::detail::ResponseParser response(result);
+    std::string envelope = R"({"jsonrpc":"2.0","error":{"code":-32700,"message":"Parse error"},"id":null})";
+
+    response.start();
+    response.write(envelope.data(), envelope.size());
+    response.finish();
+
+    BOOST_CHECK(!response.parser.error);
+    BOOST_CHECK(!response.envelope.id);
+    BOOST_CHECK(!response.envelope.has_result);
+    BOOST_CHECK(result.events.empty());
+
+    envelope = R"({"jsonrpc":"2.0","result":true,"id":7})";
+
+    response.start();
+    response.write(envelope.data(), envelope.size());
+    response.finish();
+
+    BOOST_CHECK(response.envelope.id && *response.envelope.id == "7");
+}
+
+BOOST_AUTO_TEST_CASE( JsonPushParserSplit )
+{
+    std::string text = R"( {"id":-7,"big":123456789012345678901234567890,"float":-1.25e-3,)"
+                       R"("list":[true,false,null,[],{},"",0],"text":"a\"\\\u00e9\ud83d\ude00 )"
+                       "\xe2\x82\xac"
+                       R"("} )";
+
+    auto expected = parse(text);
+    BOOST_REQUIRE(expected);
+
+    milecsa::rpc::detail::DomSax dom;
+    JsonPushParser dom_parser(dom);
+    BOOST_CHECK(dom_parser.write(text.data(), text.size()) && dom_parser.finish());
+    BOOST_CHECK(dom.value == nlohmann::json::parse(text));
+
+    //
+    // the same events at every split point
+    //
+    for (size_t split = 0; split <= text.size(); ++split) {
+        Events events;
+        JsonPushParser parser(events);
+        parser.write(text.data(), split);
+        parser.write(text.data() + split, text.size() - split);
+        BOOST_CHECK_MESSAGE(parser.finish() && events.events == *expected, "split at " << split);
+    }
+
+    BOOST_CHECK(parse(text, 1) == expected);
+
+    //
+    // parser starts over after reset
+    //
+    Events events;
+    JsonPushParser parser(events);
+    BOOST_CHECK(!parser.write("[1,", 3) || !parser.finish());
+    parser.reset();
+    events.events.clear();
+    BOOST_CHECK(parser.write(text.data(), text.size()) && parser.finish());
+    BOOST_CHECK(events.events == *expected);
+}
@@ -0,0 +1,315 @@
+//
+// Created by lotus mile on 2026-10-17.
+//
+
+#define BOOST_TEST_MODULE pipeline
+
+#include <thread>
+#include <set>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include "milecsa_transaction_pipeline.hpp"
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/test/included/unit_test.hpp>
+
+using TransactionPipeline = milecsa::rpc::TransactionPipeline;
+using ConcurrentClient = milecsa::rpc::ConcurrentClient;
+using tcp = boost::asio::ip::tcp;
+namespace beast = boost::beast;
+
+/**
+ * Local node serves every connection by its own thread: send-transaction is replied with its params
+ * after the "delay" param milliseconds, replies are held while the node is closed
+ */
+struct StubNode {
+
+    StubNode():
+            acceptor(ioc, tcp::endpoint(boost::asio::ip::make_address("127.0.0.1"), 0)),
+            thread([this]{ serve(); }) {}
+
+    ~StubNode() {
+        open();
+        stopped = true;
+        boost::asio::io_context wake;
+        tcp::socket socket(wake);
+        boost::system::error_code ec;
+        socket.connect(acceptor.local_endpoint(), ec);
+        thread.join();
+        for (auto &connection: connections)
+            connection.join();
+    }
+
+    std::string url() const {
+        return "http://127.0.0.1:" + std::to_string(acceptor.local_endpoint().port()) + "/";
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+    }
+
+    void open() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closed = false;
+        }
+        changed.notify_all();
+    }
+
+    /**
+     * Wait until the node holds count replies
+     */
+    bool wait_held(size_t count) {
+        std::unique_lock<std::mutex> lock(mutex);
+        return changed.wait_for(lock, std::chrono::seconds(10), [&]{ return held >= count; });
+    }
+
+    void serve() {
+        while (!stopped) {
+            tcp::socket socket(ioc);
+            boost::system::error_code ec;
+            acceptor.accept(socket, ec);
+            if (ec || stopped)
+                return;
+            connections.emplace_back([this, s = std::move(socket)]() mutable { reply(s); });
+        }
+    }
+
+    void reply(tcp::socket &socket) {
+        beast::flat_buffer buffer;
+        for (;;) {
+            boost::system::error_code ec;
+            beast::http::request<beast::http::string_body> req;
+            beast::http::read(socket, buffer, req, ec);
+            if (ec)
+                return;
+
+            auto body = milecsa::rpc::json::parse(req.body());
+            auto method = body["method"].get<std::string>();
+            milecsa::rpc::json result = true;
+
+            if (method == "get-current-block-id")
+                result = {{"current-block-id", "12345"}};
+
+            else if (method == "send-transaction") {
+                result = body["params"];
+
+                std::unique_lock<std::mutex> lock(mutex);
+                ++held;
+                max_held = std::max(max_held, held);
+                changed.notify_all();
+                changed.wait(lock, [this]{ return !closed; });
+                lock.unlock();
+
+                if (result.count("delay") > 0)
+                    std::this_thread::sleep_for(std::chrono::milliseconds(result["delay"].get<int>()));
+
+                lock.lock();
+                --held;
+                replied.push_back(result);
+            }
+
+            beast::http::response<beast::http::string_body> res;
+            res.version(11);
+            res.keep_alive(true);
+            res.result(beast::http::status::ok);
+            res.set(beast::http::field::content_type, "application/json");
+            res.body() = milecsa::rpc::json{{"jsonrpc", "2.0"}, {"result", result}, {"id", body["id"]}}.dump();
+            res.prepare_payload();
+            beast::http::write(socket, res, ec);
+            if (ec)
+                return;
+        }
+    }
+
+    boost::asio::io_context ioc;
+    tcp::acceptor acceptor;
+    std::atomic<bool> stopped{false};
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    bool closed = false;
+    size_t held = 0;
+    size_t max_held = 0;
+    std::vector<milecsa::rpc::json> replied;
+
+    std::vector<std::thread> connections;
+    std::thread thread;
+};
+
+/**
+ * Connections take one request at a time, so every request in flight is held by the node
+ */
+static std::optional<ConcurrentClient> connect(StubNode &node, size_t connections) {
+    milecsa::ErrorHandler error_handler = [](milecsa::result, const std::string &error){
+        BOOST_TEST_MESSAGE("Pipeline error: " + error);
+    };
+    return ConcurrentClient::Connect(node.url(), connections, 1, 2, false, milecsa::http::default_response_handler, error_handler);
+}
+
+BOOST_AUTO_TEST_CASE( SignUniqueIds )
+{
+    std::optional<milecsa::keys::Pair> pair = milecsa::keys::Pair::Random();
+    std::optional<milecsa::keys::Pair> destination = milecsa::keys::Pair::Random();
+
+    uint256_t block_id(12345);
+
+    std::mutex mutex;
+    std::set<std::string> ids;
+    std::vector<std::string> blocks;
+    std::vector<std::thread> signers;
+
+    //
+    // signers share one wallet, every transfer takes its own transaction id
+    //
+    for (int i = 0; i < 4; ++i) {
+        signers.emplace_back([&]{
+            for (int j = 0; j < 50; ++j) {
+                TransactionPipeline::Transfer transfer{
+                        *pair, destination->get_public_key().encode(), 1, 0.1f, 0.0f, "pipeline"};
+                auto body = TransactionPipeline::Sign(transfer, block_id);
+                BOOST_REQUIRE(body);
+                std::lock_guard<std::mutex> lock(mutex);
+                ids.insert((*body)["transaction-id"].dump());
+                blocks.push_back((*body)["block-id"].get<std::string>());
+            }
+        });
+    }
+
+    for (auto &signer: signers)
+        signer.join();
+
+    BOOST_CHECK_EQUAL(ids.size(), 200);
+    BOOST_CHECK_EQUAL(blocks.size(), 200);
+    for (auto &block: blocks)
+        BOOST_CHECK_EQUAL(block, UInt256ToDecString(block_id));
+}
+
+BOOST_AUTO_TEST_CASE( PipelineSubmit )
+{
+    StubNode node;
+
+    auto client = connect(node, 4);
+    BOOST_REQUIRE(client);
+
+    std::optional<milecsa::keys::Pair> pair = milecsa::keys::Pair::Random();
+    std::optional<milecsa::keys::Pair> destination = milecsa::keys::Pair::Random();
+
+    auto pipeline = TransactionPipeline::Start(*client, 2, 4);
+    BOOST_REQUIRE(pipeline);
+
+    std::mutex mutex;
+    std::vector<std::pair<size_t, milecsa::rpc::response>> delivered;
+
+    for (int i = 0; i < 20; ++i) {
+        TransactionPipeline::Transfer transfer{*pair, destination->get_public_key().encode(), 1, 0.1f, 0.0f, "pipeline"};
+        pipeline->submit(transfer, [&](size_t sequence, const milecsa::rpc::response &result){
+            std::lock_guard<std::mutex> lock(mutex);
+            delivered.emplace_back(sequence, result);
+        });
+    }
+
+    TransactionPipeline::Transfer transfer{*pair, destination->get_public_key().encode(), 1, 0.1f, 0.0f, "future"};
+    auto result = pipeline->submit(transfer).get();
+    BOOST_REQUIRE(result);
+    BOOST_CHECK_EQUAL((*result)["block-id"].get<std::string>(), "12345");
+
+    pipeline->wait();
+
+    //
+    // signed transfers are sent once each and delivered in submission order
+    //
+    BOOST_CHECK_EQUAL(node.replied.size(), 21);
+    BOOST_REQUIRE_EQUAL(delivered.size(), 20);
+
+    std::set<std::string> ids;
+    for (size_t i = 0; i < delivered.size(); ++i) {
+        BOOST_CHECK_EQUAL(delivered[i].first, i);
+        BOOST_REQUIRE(delivered[i].second);
+        BOOST_CHECK_EQUAL((*delivered[i].second)["block-id"].get<std::string>(), "12345");
+        ids.insert((*delivered[i].second)["transaction-id"].dump());
+    }
+    BOOST_CHECK_EQUAL(ids.size(), 20);
+}
+
+BOOST_AUTO_TEST_CASE( PipelineSubmissionOrder )
+{
+    StubNode node;
+
+    auto client = connect(node, 8);
+    BOOST_REQUIRE(client);
+
+    auto pipeline = TransactionPipeline::StartBroadcast(*client, 8, TransactionPipeline::Order::submission);
+
+    std::mutex mutex;
+    std::vector<std::pair<size_t, milecsa::rpc::response>> delivered;
+
+    //
+    // earlier transactions are replied later
+    //
+    const int count = 8;
+    for (int i = 0; i < count; ++i) {
+        pipeline.broadcast({{"n", i}, {"delay", (count - i) * 30}}, [&](size_t sequence, const milecsa::rpc::response &result){
+            std::lock_guard<std::mutex> lock(mutex);
+            delivered.emplace_back(sequence, result);
+        });
+    }
+
+    pipeline.wait();
+
+    BOOST_REQUIRE_EQUAL(node.replied.size(), count);
+    BOOST_CHECK(node.replied.front()["n"] != 0);
+
+    BOOST_REQUIRE_EQUAL(delivered.size(), count);
+    for (int i = 0; i < count; ++i) {
+        BOOST_CHECK_EQUAL(delivered[i].first, i);
+        BOOST_REQUIRE(delivered[i].second);
+        BOOST_CHECK_EQUAL((*delivered[i].second)["n"].get<int>(), i);
+    }
+}
+
+BOOST_AUTO_TEST_CASE( PipelineWindow )
+{
+    StubNode node;
+
+    auto client = connect(node, 8);
+    BOOST_REQUIRE(client);
+
+    const size_t window = 3;
+    auto pipeline = TransactionPipeline::StartBroadcast(*client, window, TransactionPipeline::Order::completion);
+
+    std::atomic<size_t> delivered(0);
+
+    node.close();
+
+    //
+    // submit blocks when the window is full, so transactions are submitted from the other thread
+    //
+    std::thread submitter([&]{
+        for (int i = 0; i < 20; ++i)
+            pipeline.broadcast({{"n", i}}, [&](size_t, const milecsa::rpc::response &result){
+                if (result)
+                    ++delivered;
+            });
+    });
+
+    BOOST_CHECK(node.wait_held(window));
+
+    //
+    // connections could take more, the window does not let them
+    //
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    {
+        std::lock_guard<std::mutex> lock(node.mutex);
+        BOOST_CHECK_EQUAL(node.held, window);
+    }
+
+    node.open();
+    submitter.join();
+    pipeline.wait();
+
+    BOOST_CHECK_EQUAL(delivered, 20);
+    BOOST_CHECK_EQUAL(node.max_held, window);
+}
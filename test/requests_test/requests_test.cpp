@@ -5,11 +5,22 @@
 #define BOOST_TEST_MODULE requests
 
 #include "milecsa_jsonrpc.hpp"
+#include "milecsa_client_pool.hpp"
+#include "milecsa_concurrent_client.hpp"
+#include "milecsa_jsonrpc_coro.hpp"
+#include "milecsa_block_iterator.hpp"
+#include "milecsa_hedged_client.hpp"
 
 #include <optional>
+#include <thread>
+#include <atomic>
 #include <boost/test/included/unit_test.hpp>
 
 std::string node_url = "https://lotus000.testnet.mile.global/v1/api";
+std::vector<std::string> node_urls = {
+        "https://lotus000.testnet.mile.global/v1/api",
+        "https://lotus001.testnet.mile.global/v1/api"
+};
 
 struct RequestsEval {
 
@@ -68,16 +79,251 @@ struct RequestsEval {
             BOOST_TEST_MESSAGE(" -- ");
             BOOST_TEST_MESSAGE("Trxs  : " + rpc->get_wallet_transactions(pk, 5)->dump());
 
+            //
+            // result events are passed to the handler, the response DOM is not built
+            //
+            struct ObjectsCounter: public milecsa::rpc::detail::DomSax {
+                size_t objects = 0;
+                bool start_object(std::size_t elements) override {
+                    ++objects;
+                    return DomSax::start_object(elements);
+                }
+            } counter;
+
+            BOOST_CHECK(rpc->stream("get-wallet-transactions", {{"public-key", pk}, {"limit", 5}}, counter));
+            BOOST_TEST_MESSAGE(" -- ");
+            BOOST_TEST_MESSAGE("Trxs objects: " + std::to_string(counter.objects));
+
+            auto wallet = rpc->get<milecsa::rpc::WalletState>({{"public-key", pk}});
+            BOOST_CHECK(wallet);
+            for (auto &balance: wallet->balance)
+                BOOST_TEST_MESSAGE("Typed balance: " + std::to_string(balance.asset_code) + ": " + balance.amount);
+
+            auto state = rpc->get<milecsa::rpc::BlockchainState>();
+            BOOST_CHECK(state);
+            BOOST_TEST_MESSAGE("Typed block count: " + UInt256ToDecString(state->block_count));
+
+            BOOST_CHECK(milecsa::rpc::has_result(rpc->call("get-wallet-state", {{"public-key", pk}})));
+            BOOST_CHECK(!milecsa::rpc::Methods::Register("ping", {}));
+            BOOST_CHECK(milecsa::rpc::Methods::Register("get-block-count", [](const milecsa::rpc::Client &client,
+                                                                              const std::string &,
+                                                                              const nlohmann::json &,
+                                                                              const milecsa::ErrorHandler &)
+                                                                              -> milecsa::rpc::CallResult {
+                if (auto state = client.get<milecsa::rpc::BlockchainState>())
+                    return state->block_count;
+                return {};
+            }));
+            BOOST_CHECK(milecsa::rpc::has_result(rpc->call("get-block-count", {})));
+
             BOOST_TEST_MESSAGE(" -- ");
             BOOST_TEST_MESSAGE("NW State: " + rpc->get_network_state()->dump());
 
             BOOST_TEST_MESSAGE(" -- ");
             BOOST_TEST_MESSAGE("NW Nodes: " + rpc->get_nodes()->dump());
 
+            auto blocks = rpc->get_blocks({0, 1, 2});
+            BOOST_CHECK(blocks.size() == 3);
+            for (auto &block: blocks) {
+                BOOST_TEST_MESSAGE(" -- ");
+                BOOST_TEST_MESSAGE("Batch Block: " + (block ? block->dump() : "null"));
+            }
+
+            auto states = rpc->get_wallet_states({pk, pk});
+            BOOST_CHECK(states.size() == 2);
+
+            rpc->set_pipeline_depth(4);
+            auto pipelined = rpc->pipeline({
+                                                   {"get-blockchain-info", {}},
+                                                   {"get-blockchain-state", {}},
+                                                   {"get-wallet-state", {{"public-key", pk}}},
+                                                   {"get-current-block-id", {}}
+                                           });
+            BOOST_CHECK(pipelined.size() == 4);
+            for (auto &r: pipelined) {
+                BOOST_TEST_MESSAGE(" -- ");
+                BOOST_TEST_MESSAGE("Pipelined: " + (r ? r->dump() : "null"));
+            }
+
+            return true;
+        }
+        return false;
+    }
+
+    bool async(const std::string &u = node_url) {
+
+        boost::asio::io_context ioc;
+        auto work = boost::asio::make_work_guard(ioc);
+        std::thread runner([&ioc]{ ioc.run(); });
+
+        bool done = false;
+
+        if (auto rpc = milecsa::rpc::Client::Connect(ioc, u, true, response_handler, error_handler)) {
+
+            auto info = rpc->async_get_blockchain_info();
+            auto state = rpc->async_get_blockchain_state();
+            auto last_block_id = rpc->async_get_current_block_id();
+
+            if (auto id = last_block_id.get()) {
+                BOOST_TEST_MESSAGE("Async Id   : " + UInt256ToDecString(*id));
+                if (auto block = rpc->async_get_block(*id).get()) {
+                    BOOST_TEST_MESSAGE("Async Block: " + block->dump());
+                    done = info.get().has_value() && state.get().has_value();
+                }
+            }
+        }
+
+        work.reset();
+        ioc.stop();
+        runner.join();
+
+        return done;
+    }
+
+#if defined(BOOST_ASIO_HAS_CO_AWAIT)
+
+    bool coroutine(const std::string &u = node_url) {
+
+        boost::asio::io_context ioc;
+        bool done = false;
+
+        if (auto rpc = milecsa::rpc::CoClient::Connect(ioc, u, true, response_handler, error_handler)) {
+
+            boost::asio::co_spawn(ioc, [&]() -> milecsa::rpc::awaitable<void> {
+                if (auto id = co_await rpc->get_current_block_id()) {
+                    BOOST_TEST_MESSAGE("Coroutine Id   : " + UInt256ToDecString(*id));
+                    if (auto block = co_await rpc->get_block(*id)) {
+                        BOOST_TEST_MESSAGE("Coroutine Block: " + block->dump());
+                        done = true;
+                    }
+                }
+            }, boost::asio::detached);
+
+            ioc.run();
+        }
+
+        return done;
+    }
+
+#endif
+
+    bool concurrent(const std::string &u = node_url) {
+
+        if (auto rpc = milecsa::rpc::ConcurrentClient::Connect(u, 2, 4, 1, true, response_handler, error_handler)) {
+
+            std::atomic<int> received(0);
+            std::vector<std::thread> workers;
+
+            for (int i = 0; i < 4; ++i) {
+                workers.emplace_back([&]{
+                    for (int j = 0; j < 4; ++j) {
+                        if (rpc->get_current_block_id() && rpc->get_blockchain_state())
+                            ++received;
+                    }
+                });
+            }
+
+            for (auto &worker: workers)
+                worker.join();
+
+            BOOST_TEST_MESSAGE("Concurrent calls: " + std::to_string(received.load()));
+
+            return received == 16;
+        }
+        return false;
+    }
+
+    bool pool(const std::vector<std::string> &urls = node_urls) {
+        if (auto pool = milecsa::rpc::ClientPool::Connect(urls, 2, true, response_handler, error_handler)) {
+
+            for (int i = 0; i < 4; ++i) {
+                if (auto last_block_id = pool->get_current_block_id()) {
+                    BOOST_TEST_MESSAGE("Pool Id   : " + UInt256ToDecString(*last_block_id));
+                }
+                else
+                    return false;
+            }
+
+            for (auto &node: pool->get_stat()) {
+                BOOST_TEST_MESSAGE("Pool node: " + node.url
+                                   + " latency: " + std::to_string(node.latency)
+                                   + " requests: " + std::to_string(node.requests)
+                                   + " healthy: " + std::to_string(node.healthy));
+            }
+
             return true;
         }
         return false;
     }
+
+    bool iterator(const std::string &u = node_url) {
+        if (auto rpc = milecsa::rpc::ConcurrentClient::Connect(u, 2, 4, 1, true, response_handler, error_handler)) {
+
+            auto blocks = milecsa::rpc::BlockIterator::Start({*rpc}, 0, 31, 8, error_handler);
+            if (!blocks)
+                return false;
+
+            size_t received = 0;
+            while (auto block = blocks->next())
+                ++received;
+
+            BOOST_TEST_MESSAGE("Iterated blocks: " + std::to_string(received)
+                               + " window: " + std::to_string(blocks->get_window()));
+
+            return received == 32 && blocks->get_position() == 32;
+        }
+        return false;
+    }
+
+    bool hedged(const std::vector<std::string> &urls = node_urls) {
+        std::vector<milecsa::rpc::ConcurrentClient> nodes;
+        for (auto &u: urls) {
+            if (auto rpc = milecsa::rpc::ConcurrentClient::Connect(u, 2, 4, 1, true, response_handler, error_handler))
+                nodes.push_back(*rpc);
+        }
+
+        milecsa::rpc::HedgePolicy policy;
+        policy.max_extra_load = 0.5;
+
+        if (auto rpc = milecsa::rpc::HedgedClient::Start(nodes, policy, error_handler)) {
+
+            for (int i = 0; i < 32; ++i) {
+                if (!rpc->get_current_block_id())
+                    return false;
+            }
+
+            if (!rpc->get_block(0))
+                return false;
+
+            for (auto &node: rpc->get_stat()) {
+                BOOST_TEST_MESSAGE("Hedged node: " + node.url
+                                   + " delay: " + std::to_string(node.delay)
+                                   + " requests: " + std::to_string(node.requests)
+                                   + " hedges: " + std::to_string(node.hedges)
+                                   + " wins: " + std::to_string(node.wins));
+            }
+
+            return true;
+        }
+        return false;
+    }
+
+    bool tracker(const std::string &u = node_url) {
+        if (auto tracker = milecsa::rpc::BlockIdTracker::Start(u, std::chrono::milliseconds(200), true, response_handler, error_handler)) {
+
+            auto id = tracker->get();
+            if (!id)
+                return false;
+
+            BOOST_TEST_MESSAGE("Tracked Id: " + UInt256ToDecString(*id)
+                               + " age: " + std::to_string(tracker->get_age().count()) + "ms");
+
+            tracker->refresh();
+
+            return tracker->get_age() < milecsa::rpc::BlockIdTracker::max_staleness;
+        }
+        return false;
+    }
 };
 
 
@@ -86,4 +332,13 @@ BOOST_FIXTURE_TEST_CASE( requests, RequestsEval )
     milecsa::rpc::Client::timeout = 20;
     BOOST_CHECK(test());
     BOOST_CHECK(getzeroblock());
+    BOOST_CHECK(async());
+#if defined(BOOST_ASIO_HAS_CO_AWAIT)
+    BOOST_CHECK(coroutine());
+#endif
+    BOOST_CHECK(concurrent());
+    BOOST_CHECK(pool());
+    BOOST_CHECK(iterator());
+    BOOST_CHECK(hedged());
+    BOOST_CHECK(tracker());
 }
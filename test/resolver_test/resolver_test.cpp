@@ -0,0 +1,78 @@
+//
+// Created by lotus mile on 2026-10-17.
+//
+
+#define BOOST_TEST_MODULE resolver
+
+#include <future>
+#include <thread>
+#include "milecsa_resolver_cache.hpp"
+#include <boost/test/included/unit_test.hpp>
+
+using ResolverCache = milecsa::rpc::ResolverCache;
+
+BOOST_AUTO_TEST_CASE( ResolverCacheStale )
+{
+    auto &cache = ResolverCache::Instance();
+
+    boost::system::error_code ec;
+    auto endpoints = cache.resolve("127.0.0.1", "8080", ec);
+
+    BOOST_CHECK(!ec);
+    BOOST_CHECK(endpoints.size() == 1);
+    BOOST_CHECK(endpoints.front().port() == 8080);
+
+    //
+    // endpoints past ttl are taken at once by the caller thread while the host is resolved again
+    //
+    cache.set_ttl(std::chrono::seconds(0));
+    cache.resolve("127.0.0.1", "8081", ec);
+
+    auto caller = std::this_thread::get_id();
+    std::promise<bool> taken;
+    cache.async_resolve("127.0.0.1", "8081", [&taken, caller](const boost::system::error_code &ec,
+                                                              const ResolverCache::Endpoints &endpoints){
+        taken.set_value(!ec && endpoints.size() == 1 && std::this_thread::get_id() == caller);
+    });
+
+    BOOST_CHECK(taken.get_future().get());
+    cache.set_ttl(std::chrono::seconds(60));
+
+    cache.resolve("host.invalid", "8080", ec);
+    BOOST_CHECK(ec);
+}
+
+BOOST_AUTO_TEST_CASE( ResolverCacheExpire )
+{
+    auto &cache = ResolverCache::Instance();
+
+    boost::system::error_code ec;
+    cache.resolve("127.0.0.1", "8082", ec);
+    BOOST_CHECK(!ec);
+
+    //
+    // endpoints expired by a connection failure are not taken, the handler waits for the fresh query
+    // completed on the cache thread
+    //
+    cache.expire("127.0.0.1", "8082");
+
+    auto caller = std::this_thread::get_id();
+    std::promise<bool> waited;
+    cache.async_resolve("127.0.0.1", "8082", [&waited, caller](const boost::system::error_code &ec,
+                                                               const ResolverCache::Endpoints &endpoints){
+        waited.set_value(!ec && endpoints.size() == 1 && std::this_thread::get_id() != caller);
+    });
+
+    BOOST_CHECK(waited.get_future().get());
+
+    //
+    // fresh endpoints are taken at once again
+    //
+    std::promise<bool> cached;
+    cache.async_resolve("127.0.0.1", "8082", [&cached, caller](const boost::system::error_code &ec,
+                                                               const ResolverCache::Endpoints &endpoints){
+        cached.set_value(!ec && std::this_thread::get_id() == caller);
+    });
+
+    BOOST_CHECK(cached.get_future().get());
+}
@@ -0,0 +1,56 @@
+#
+# Payouts are not sent again when the journal exists and neither --resume nor --force is given
+#
+
+set (PAYOUTS ${WORK_DIR}/payouts.csv)
+set (JOURNAL ${PAYOUTS}.journal)
+set (RECORD "{\"line\":1,\"status\":\"sent\",\"to\":\"wallet\",\"amount\":1.0}\n")
+
+file (WRITE ${PAYOUTS} "wallet,1,1.0,payout\n")
+file (WRITE ${JOURNAL} ${RECORD})
+
+execute_process (
+        COMMAND ${TRANSFER} --payouts ${PAYOUTS} --url http://127.0.0.1:1/v1/api
+        RESULT_VARIABLE result
+        ERROR_VARIABLE error
+        INPUT_FILE /dev/null
+        TIMEOUT 30)
+
+if (result EQUAL 0)
+    message (FATAL_ERROR "transfer has started over the existing journal")
+endif ()
+
+if (NOT error MATCHES "journal .* exists")
+    message (FATAL_ERROR "transfer has failed without journal error: ${error}")
+endif ()
+
+file (READ ${JOURNAL} journal)
+
+if (NOT journal STREQUAL RECORD)
+    message (FATAL_ERROR "journal has been changed: ${journal}")
+endif ()
+
+#
+# signed transactions journal is checked the same way
+#
+set (SIGNED ${WORK_DIR}/signed.ndjson)
+
+file (WRITE ${SIGNED} "{\"line\":1,\"body\":{}}\n")
+file (WRITE ${SIGNED}.journal ${RECORD})
+
+execute_process (
+        COMMAND ${TRANSFER} --broadcast ${SIGNED} --url http://127.0.0.1:1/v1/api
+        RESULT_VARIABLE result
+        ERROR_VARIABLE error
+        INPUT_FILE /dev/null
+        TIMEOUT 30)
+
+if (result EQUAL 0 OR NOT error MATCHES "journal .* exists")
+    message (FATAL_ERROR "broadcast has started over the existing journal: ${error}")
+endif ()
+
+file (READ ${SIGNED}.journal journal)
+
+if (NOT journal STREQUAL RECORD)
+    message (FATAL_ERROR "signed transactions journal has been changed: ${journal}")
+endif ()
@@ -0,0 +1,48 @@
+//
+// Created by lotus mile on 2026-10-17.
+//
+
+#define BOOST_TEST_MODULE trx_id
+
+#include <thread>
+#include <set>
+#include <algorithm>
+#include <filesystem>
+#include "milecsa_trx_id.hpp"
+#include <boost/test/included/unit_test.hpp>
+
+using TrxIdAllocator = milecsa::rpc::TrxIdAllocator;
+
+BOOST_AUTO_TEST_CASE( TrxIdMonotonic )
+{
+    auto path = std::filesystem::temp_directory_path() / "milecsa_trx_id_test";
+    std::filesystem::remove(path);
+
+    auto &allocator = TrxIdAllocator::Instance();
+    BOOST_CHECK(allocator.persist(path.string()));
+
+    std::vector<std::vector<uint64_t>> ids(4);
+    std::vector<std::thread> threads;
+
+    for (auto &taken: ids) {
+        threads.emplace_back([&allocator, &taken]{
+            for (int i = 0; i < 1000; ++i)
+                taken.push_back(allocator.get_next("wallet"));
+        });
+    }
+
+    for (auto &thread: threads)
+        thread.join();
+
+    std::set<uint64_t> unique;
+    for (auto &taken: ids) {
+        BOOST_CHECK(std::is_sorted(taken.begin(), taken.end()));
+        unique.insert(taken.begin(), taken.end());
+    }
+    BOOST_CHECK(unique.size() == 4000);
+
+    allocator.seed("wallet", *unique.rbegin() + 100);
+    BOOST_CHECK(allocator.get_next("wallet") == *unique.rbegin() + 101);
+
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,257 @@
+//
+// Created by lotus mile on 2026-10-17.
+//
+
+#define BOOST_TEST_MODULE wallet_index
+
+#include <filesystem>
+#include "milecsa_wallet_index.hpp"
+#include <boost/test/included/unit_test.hpp>
+
+using WalletIndex = milecsa::rpc::WalletIndex;
+
+BOOST_AUTO_TEST_CASE( WalletIndexRestart )
+{
+    auto directory = std::filesystem::temp_directory_path() / "milecsa_wallet_index_test";
+    std::filesystem::remove_all(directory);
+
+    milecsa::ErrorHandler error_handler = [](milecsa::result code, const std::string &error){
+        BOOST_TEST_MESSAGE("Wallet index error: " + error);
+    };
+
+    auto make_transfer = [](const std::string &from, const std::string &to, const std::string &amount) {
+        milecsa::rpc::Transaction tx;
+        tx.type = "TransferAssetsTransaction";
+        tx.from = from;
+        tx.to = to;
+        tx.assets = {{1, amount}};
+        tx.fee = "0.00000";
+        return tx;
+    };
+
+    {
+        auto index = WalletIndex::Open(directory.string(), error_handler);
+        BOOST_REQUIRE(index);
+
+        for (uint64_t i = 0; i < 10; ++i) {
+            milecsa::rpc::Block block;
+            block.id = i;
+            block.transactions.push_back(make_transfer("alice", "bob", "1.5"));
+            if (i % 2 == 0)
+                block.transactions.push_back(make_transfer("bob", "carol", "0.25"));
+            BOOST_CHECK(index->add(block));
+        }
+
+        milecsa::rpc::Block gap;
+        gap.id = 12;
+        BOOST_CHECK(!index->add(gap));
+
+        BOOST_CHECK(index->get_next_block() == 10);
+        BOOST_CHECK_EQUAL(index->count("bob"), 15);
+
+        auto history = index->get_history("carol", 2);
+        BOOST_REQUIRE_EQUAL(history.size(), 2);
+        BOOST_CHECK(history[0].block_id == 8);
+        BOOST_CHECK_EQUAL(history[0].offset, 1);
+        BOOST_CHECK_EQUAL(history[0].transaction.from, "bob");
+        BOOST_CHECK(history[1].block_id == 6);
+
+        index->flush();
+    }
+
+    auto index = WalletIndex::Open(directory.string(), error_handler);
+    BOOST_REQUIRE(index);
+
+    BOOST_CHECK(index->get_next_block() == 10);
+    BOOST_CHECK_EQUAL(index->get_history("alice").size(), 10);
+    BOOST_CHECK_EQUAL(index->get_history("alice", 100, 2, 4).size(), 3);
+    BOOST_CHECK_EQUAL(index->get_balance_delta("bob")[1], 10 * 150000 - 5 * 25000);
+    BOOST_CHECK_EQUAL(index->get_balance_delta("alice", 0, 0)[1], -150000);
+    BOOST_CHECK(index->get_history("dave").empty());
+
+    std::filesystem::remove_all(directory);
+}
+
+BOOST_AUTO_TEST_CASE( WalletIndexNonTransfer )
+{
+    auto directory = std::filesystem::temp_directory_path() / "milecsa_wallet_index_types_test";
+    std::filesystem::remove_all(directory);
+
+    milecsa::ErrorHandler error_handler = [](milecsa::result code, const std::string &error){
+        BOOST_TEST_MESSAGE("Wallet index error: " + error);
+    };
+
+    auto index = WalletIndex::Open(directory.string(), error_handler);
+    BOOST_REQUIRE(index);
+
+    milecsa::rpc::Transaction transfer;
+    transfer.type = "TransferAssetsTransaction";
+    transfer.from = "alice";
+    transfer.to = "bob";
+    transfer.assets = {{1, "2"}};
+    transfer.fee = "0.01";
+
+    //
+    // node registration locks the amount but does not move it to the node
+    //
+    milecsa::rpc::Transaction node;
+    node.type = "RegisterNodeTransactionWithAmount";
+    node.from = "alice";
+    node.to = "node";
+    node.assets = {{1, "10"}};
+    node.fee = "0.01";
+
+    milecsa::rpc::Block block;
+    block.id = 0;
+    block.transactions.push_back(transfer);
+    block.transactions.push_back(node);
+    BOOST_CHECK(index->add(block));
+
+    BOOST_CHECK_EQUAL(index->get_balance_delta("alice")[1], -200000 - 2 * 1000);
+    BOOST_CHECK_EQUAL(index->get_balance_delta("bob")[1], 200000);
+    BOOST_CHECK_EQUAL(index->get_balance_delta("node")[1], 0);
+
+    auto history = index->get_history("node");
+    BOOST_REQUIRE_EQUAL(history.size(), 1);
+    BOOST_CHECK_EQUAL(history[0].transaction.type, "RegisterNodeTransactionWithAmount");
+
+    std::filesystem::remove_all(directory);
+}
+
+BOOST_AUTO_TEST_CASE( WalletIndexDecodedBlock )
+{
+    auto directory = std::filesystem::temp_directory_path() / "milecsa_wallet_index_decoded_test";
+    std::filesystem::remove_all(directory);
+
+    milecsa::ErrorHandler error_handler = [](milecsa::result code, const std::string &error){
+        BOOST_TEST_MESSAGE("Wallet index error: " + error);
+    };
+
+    auto json = nlohmann::json::parse(R"({
+        "block-id": "0",
+        "version": "1",
+        "previous-block-digest": "2QxJUwY7VuqYAhHX8SEBmUoDgERKyvbuFXxnhS3Wa19tnUBbpi",
+        "merkle-root": "9ti8JsHjUK6FxchSPNi4ZvCSvRPbBxTn7cJ5Dz1QFF9WJPG7N",
+        "timestamp": "2018-12-12 10:00:00",
+        "number-of-transactions": 2,
+        "transactions": [
+            {
+                "transaction-type": "TransferAssetsTransaction",
+                "transaction-id": "7",
+                "from": "alice",
+                "to": "bob",
+                "asset": [{"code": 0, "amount": "1.5"}, {"code": 1, "amount": "0.25"}],
+                "fee": "0.01",
+                "digest": "Q1QDzehqqBrtEqRNb2nzJnrn8nUPv1owQQenGjxXDWWFDGZbP"
+            },
+            {
+                "transaction-type": "EmissionTransaction",
+                "transaction-id": "8",
+                "from": "bob",
+                "to": "",
+                "asset-code": 1,
+                "amount": "3",
+                "fee": "0"
+            }
+        ]
+    })");
+
+    auto block = milecsa::rpc::decode_block(json);
+    BOOST_REQUIRE(block);
+
+    BOOST_CHECK(block->id == 0);
+    BOOST_CHECK_EQUAL(block->transaction_count, 2);
+    BOOST_REQUIRE_EQUAL(block->transactions.size(), 2);
+
+    auto &transfer = block->transactions[0];
+    BOOST_CHECK(transfer.id == 7);
+    BOOST_CHECK_EQUAL(transfer.type, "TransferAssetsTransaction");
+    BOOST_REQUIRE_EQUAL(transfer.assets.size(), 2);
+    BOOST_CHECK_EQUAL(transfer.assets[0].asset_code, 0);
+    BOOST_CHECK_EQUAL(transfer.assets[0].amount, "1.5");
+    BOOST_CHECK_EQUAL(transfer.assets[1].asset_code, 1);
+    BOOST_CHECK_EQUAL(transfer.assets[1].amount, "0.25");
+
+    auto &emission = block->transactions[1];
+    BOOST_REQUIRE_EQUAL(emission.assets.size(), 1);
+    BOOST_CHECK_EQUAL(emission.assets[0].asset_code, 1);
+    BOOST_CHECK_EQUAL(emission.assets[0].amount, "3");
+
+    //
+    // every asset is moved, the fee is charged once
+    //
+    auto index = WalletIndex::Open(directory.string(), error_handler);
+    BOOST_REQUIRE(index);
+    BOOST_CHECK(index->add(*block));
+
+    auto alice = index->get_balance_delta("alice");
+    BOOST_CHECK_EQUAL(alice[0], -150000 - 1000);
+    BOOST_CHECK_EQUAL(alice[1], -25000);
+
+    auto bob = index->get_balance_delta("bob");
+    BOOST_CHECK_EQUAL(bob[0], 150000);
+    BOOST_CHECK_EQUAL(bob[1], 25000 + 300000);
+
+    BOOST_CHECK_EQUAL(index->count("alice"), 1);
+    BOOST_CHECK_EQUAL(index->count("bob"), 2);
+
+    auto history = index->get_history("alice");
+    BOOST_REQUIRE_EQUAL(history.size(), 1);
+    BOOST_CHECK_EQUAL(history[0].transaction.assets.size(), 2);
+
+    std::filesystem::remove_all(directory);
+}
+
+BOOST_AUTO_TEST_CASE( ParseAmount )
+{
+    using milecsa::rpc::parse_amount;
+
+    BOOST_CHECK(parse_amount("12.5") == 1250000);
+    BOOST_CHECK(parse_amount("-0.25") == -25000);
+    BOOST_CHECK(parse_amount("7") == 700000);
+    BOOST_CHECK(parse_amount("0.123456789") == 12345);
+    BOOST_CHECK(parse_amount("92233720368547.75807") == std::numeric_limits<int64_t>::max());
+
+    for (auto malformed: {"", "-", ".5", "1.", "1e-5", "1,5", "1-", "--1", " 1", "1.2.3", "0x10",
+                          "92233720368547.75808", "99999999999999999999"})
+        BOOST_CHECK_MESSAGE(!parse_amount(malformed), malformed);
+}
+
+BOOST_AUTO_TEST_CASE( WalletIndexMalformedAmount )
+{
+    auto directory = std::filesystem::temp_directory_path() / "milecsa_wallet_index_amount_test";
+    std::filesystem::remove_all(directory);
+
+    milecsa::ErrorHandler error_handler = [](milecsa::result code, const std::string &error){
+        BOOST_TEST_MESSAGE("Wallet index error: " + error);
+    };
+
+    auto index = WalletIndex::Open(directory.string(), error_handler);
+    BOOST_REQUIRE(index);
+
+    milecsa::rpc::Transaction valid;
+    valid.type = "TransferAssetsTransaction";
+    valid.from = "alice";
+    valid.to = "bob";
+    valid.assets = {{1, "1.5"}};
+    valid.fee = "0.01";
+
+    auto malformed = valid;
+    malformed.assets = {{1, "1e-5"}};
+
+    //
+    // nothing of the block is indexed, the same block can be added again
+    //
+    milecsa::rpc::Block block;
+    block.id = 0;
+    block.transactions = {valid, malformed};
+    BOOST_CHECK(!index->add(block));
+    BOOST_CHECK(index->get_next_block() == 0);
+    BOOST_CHECK(index->get_history("alice").empty());
+
+    block.transactions = {valid};
+    BOOST_CHECK(index->add(block));
+    BOOST_CHECK_EQUAL(index->get_balance_delta("bob")[1], 150000);
+
+    std::filesystem::remove_all(directory);
+}